@@ -8,7 +8,7 @@ CXXFLAGS = -O3 -Isrc -I../libgit2/include -std=c++11
 #CPPFLAGS += -I boss-common -I ../../../libgit2/include
 #LDFLAGS += -static
 LDFLAGS += -Llib
-LDLIBS += -lboost_filesystem -lboost_iostreams -lboost_program_options -lboost_system -lboost_locale -lgit2 -lssl -lcrypto
+LDLIBS += -lboost_filesystem -lboost_iostreams -lboost_program_options -lboost_system -lboost_locale -lgit2 -lssl -lcrypto -pthread
 
 #%.d: %.cpp
 #		@set -e; rm -f $@; \
@@ -28,14 +28,22 @@ OBJECTS = 							$(DIR1)/boss_cli.o \
 									$(DIR2)/common/globals.o \
 									$(DIR2)/common/item_list.o \
 									$(DIR2)/common/keywords.o \
+									$(DIR2)/common/load_order_state.o \
+									$(DIR2)/common/plugin_cache.o \
 									$(DIR2)/common/rule_line.o \
 									$(DIR2)/common/settings.o \
 									$(DIR2)/output/boss_log.o \
 									$(DIR2)/output/output.o \
 									$(DIR2)/parsing/grammar.o \
+									$(DIR2)/support/arena.o \
+									$(DIR2)/support/change_monitor.o \
+									$(DIR2)/support/command_socket.o \
 									$(DIR2)/support/helpers.o \
 									$(DIR2)/support/logger.o \
 									$(DIR2)/support/mod_format.o \
+									$(DIR2)/support/profiler.o \
+									$(DIR2)/support/rw_lock.o \
+									$(DIR2)/support/thread_specific.o \
 									$(DIR2)/support/version_regex.o
 
 
@@ -43,13 +51,17 @@ bossCLI :							$(OBJECTS)
 									$(CXX) $(CXXFLAGS) $(CPPFLAGS) $^ $(LDFLAGS) $(LDLIBS) -o $@
 
 
-$(DIR1)/boss_cli.o :				$(DIR2)/common/error.h \
+$(DIR1)/boss_cli.o :				$(DIR2)/base/fstream.h \
+									$(DIR2)/common/error.h \
 									$(DIR2)/common/game.h \
 									$(DIR2)/common/globals.h \
 									$(DIR2)/common/settings.h \
 									$(DIR2)/output/boss_log.h \
 									$(DIR2)/output/output.h \
+									$(DIR2)/support/change_monitor.h \
+									$(DIR2)/support/command_socket.h \
 									$(DIR2)/support/logger.h \
+									$(DIR2)/support/profiler.h \
 									$(DIR2)/updating/updater.h
 
 $(DIR2)/common/conditional_data.o :	$(DIR2)/common/conditional_data.h \
@@ -60,7 +72,8 @@ $(DIR2)/common/conditional_data.o :	$(DIR2)/common/conditional_data.h \
 									$(DIR2)/parsing/grammar.h \
 									$(DIR2)/support/helpers.h \
 									$(DIR2)/support/logger.h \
-									$(DIR2)/support/mod_format.h
+									$(DIR2)/support/mod_format.h \
+									$(DIR2)/support/profiler.h
 
 $(DIR2)/common/error.o :			$(DIR2)/common/error.h \
 									$(DIR2)/common/dll_def.h
@@ -78,7 +91,8 @@ $(DIR2)/common/game.o :				$(DIR2)/common/game.h \
 									$(DIR2)/output/output.h \
 									$(DIR2)/support/helpers.h \
 									$(DIR2)/support/logger.h \
-									$(DIR2)/support/platform.h
+									$(DIR2)/support/platform.h \
+									$(DIR2)/support/profiler.h
 
 $(DIR2)/common/globals.o :			$(DIR2)/common/globals.h \
 									$(DIR2)/common/dll_def.h
@@ -95,11 +109,27 @@ $(DIR2)/common/item_list.o :		$(DIR2)/common/item_list.h \
 									$(DIR2)/parsing/grammar.h \
 									$(DIR2)/support/helpers.h \
 									$(DIR2)/support/logger.h \
-									$(DIR2)/support/platform.h
+									$(DIR2)/support/platform.h \
+									$(DIR2)/support/profiler.h
 
 $(DIR2)/common/keywords.o :			$(DIR2)/common/keywords.h \
 									$(DIR2)/common/dll_def.h
 
+$(DIR2)/common/load_order_state.o :	$(DIR2)/common/load_order_state.h \
+									$(DIR2)/base/fstream.h \
+									$(DIR2)/common/conditional_data.h \
+									$(DIR2)/common/dll_def.h \
+									$(DIR2)/common/error.h \
+									$(DIR2)/common/game.h \
+									$(DIR2)/support/helpers.h \
+									$(DIR2)/support/logger.h \
+									$(DIR2)/support/platform.h
+
+$(DIR2)/common/plugin_cache.o :		$(DIR2)/common/plugin_cache.h \
+									$(DIR2)/common/dll_def.h \
+									$(DIR2)/support/helpers.h \
+									$(DIR2)/support/mod_format.h
+
 $(DIR2)/common/rule_line.o :		$(DIR2)/common/rule_line.h \
 									$(DIR2)/base/fstream.h \
 									$(DIR2)/common/conditional_data.h \
@@ -111,7 +141,8 @@ $(DIR2)/common/rule_line.o :		$(DIR2)/common/rule_line.h \
 									$(DIR2)/output/output.h \
 									$(DIR2)/parsing/grammar.h \
 									$(DIR2)/support/helpers.h \
-									$(DIR2)/support/logger.h
+									$(DIR2)/support/logger.h \
+									$(DIR2)/support/profiler.h
 
 $(DIR2)/common/settings.o :			$(DIR2)/common/settings.h \
 									$(DIR2)/base/fstream.h \
@@ -128,7 +159,8 @@ $(DIR2)/output/boss_log.o :			$(DIR2)/output/boss_log.h \
 									$(DIR2)/common/error.h \
 									$(DIR2)/common/globals.h \
 									$(DIR2)/output/output.h \
-									$(DIR2)/support/helpers.h
+									$(DIR2)/support/helpers.h \
+									$(DIR2)/support/profiler.h
 
 $(DIR2)/output/output.o :			$(DIR2)/output/output.h \
 									$(DIR2)/common/conditional_data.h \
@@ -149,6 +181,20 @@ $(DIR2)/parsing/grammar.o :			$(DIR2)/parsing/grammar.h \
 									$(DIR2)/common/rule_line.h \
 									$(DIR2)/output/output.h \
 									$(DIR2)/support/helpers.h \
+									$(DIR2)/support/logger.h \
+									$(DIR2)/support/profiler.h
+
+$(DIR2)/support/arena.o :			$(DIR2)/support/arena.h \
+									$(DIR2)/common/dll_def.h
+
+$(DIR2)/support/change_monitor.o :	$(DIR2)/support/change_monitor.h \
+									$(DIR2)/common/dll_def.h \
+									$(DIR2)/support/logger.h \
+									$(DIR2)/support/profiler.h
+
+$(DIR2)/support/command_socket.o :	$(DIR2)/support/command_socket.h \
+									$(DIR2)/common/dll_def.h \
+									$(DIR2)/common/error.h \
 									$(DIR2)/support/logger.h
 
 $(DIR2)/support/helpers.o :			$(DIR2)/support/helpers.h \
@@ -157,18 +203,32 @@ $(DIR2)/support/helpers.o :			$(DIR2)/support/helpers.h \
 									$(DIR2)/alphanum.hpp \
 									$(DIR2)/common/dll_def.h \
 									$(DIR2)/common/error.h \
-									$(DIR2)/support/logger.h
+									$(DIR2)/support/logger.h \
+									$(DIR2)/support/profiler.h
 
 $(DIR2)/support/logger.o :			$(DIR2)/support/logger.h \
 									$(DIR2)/common/dll_def.h \
-									$(DIR2)/support/platform.h
+									$(DIR2)/support/platform.h \
+									$(DIR2)/support/thread_specific.h
 
 $(DIR2)/support/mod_format.o :		$(DIR2)/support/mod_format.h \
 									$(DIR2)/base/fstream.h \
 									$(DIR2)/base/regex.h \
+									$(DIR2)/support/profiler.h \
 									$(DIR2)/support/types.h \
 									$(DIR2)/support/version_regex.h
 
+$(DIR2)/support/profiler.o :		$(DIR2)/support/profiler.h \
+									$(DIR2)/base/fstream.h \
+									$(DIR2)/common/dll_def.h \
+									$(DIR2)/common/error.h
+
+$(DIR2)/support/rw_lock.o :		$(DIR2)/support/rw_lock.h \
+									$(DIR2)/common/dll_def.h
+
+$(DIR2)/support/thread_specific.o :	$(DIR2)/support/thread_specific.h \
+									$(DIR2)/common/dll_def.h
+
 $(DIR2)/support/version_regex.o :	$(DIR2)/support/version_regex.h \
 									$(DIR2)/base/regex.h
 
@@ -27,14 +27,22 @@
 
 #include "api/boss.h"
 
+#include <algorithm>
+#include <atomic>
 #include <clocale>
+#include <cstdlib>
 #include <ctime>
 
 #include <iostream>
 #include <locale>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <new>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -53,8 +61,13 @@
 #include "common/item_list.h"
 #include "common/keywords.h"
 #include "common/rule_line.h"
+#include "support/arena.h"
+#include "support/change_monitor.h"
 #include "support/helpers.h"
 #include "support/logger.h"
+#include "support/profiler.h"
+#include "support/rw_lock.h"
+#include "support/thread_specific.h"
 #include "updating/updater.h"
 
 ////////////////////////
@@ -64,12 +77,26 @@
 // Version string.
 static const std::string boss_version = boss::IntToString(boss::BOSS_VERSION_MAJOR) + "." + boss::IntToString(boss::BOSS_VERSION_MINOR) + "." + boss::IntToString(boss::BOSS_VERSION_PATCH);
 
-// Last error details buffer.
-std::string lastErrorDetails = "";
+// Last error details buffer. Each thread gets its own, so that one thread's
+// errors can't be overwritten by another's before they're read.
+static boss::ThreadSpecific<std::string> lastErrorDetails;
 
-// Error buffer and version string output pointers (for memory management).
-uint8_t *extErrorPointer = NULL;
-uint8_t *extVersionPointer = NULL;
+// Error buffer output storage.
+static boss::ThreadSpecific<boss::Arena> extErrorArena;
+
+// Lives as long as its thread, so that dbs can tell which threads' outputs
+// can be discarded.
+struct ThreadToken {
+	std::shared_ptr<char> alive;
+
+	ThreadToken() : alive(new char(0)) {}
+};
+static boss::ThreadSpecific<ThreadToken> threadToken;
+
+// Where trace events are saved, if the BOSS_TRACE environment variable is set.
+// Set once, along with the process-wide locale, by the first CreateBossDb call.
+static std::string traceFile = "";
+static std::once_flag processSetUp;
 
 // Database structure.
 struct _boss_db_int {
@@ -78,68 +105,83 @@ struct _boss_db_int {
 	boss::ItemList rawMasterlist;
 	boss::ItemList loadOrder;
 	boss::ItemList activePlugins;
-	std::time_t activePluginsMTime;              // Holds the modification date of plugins.txt.
-	std::time_t loadOrderMTime;                  // For timestamp-based system, holds modification date of loadorder.txt, otherwise it holds the modification date of the Data folder.
+	boss::ChangeMonitor loadOrderMonitor;        // Watches the files loadOrder is read from: the Data folder, plus loadorder.txt and plugins.txt for the textfile-based system.
+	boss::ChangeMonitor activePluginsMonitor;    // Watches plugins.txt, which activePlugins is read from.
+	boss::MasterlistPrecompiler precompiler;     // Parses the masterlist in the background after UpdateMasterlist().
+	std::atomic<size_t> cacheHits;               // Times loadOrder or activePlugins were used without being re-read. Counted by shared holders of lock.
+	std::atomic<size_t> cacheMisses;             // Times they had to be re-read.
 	std::map<uint32_t, std::string> bashTagMap;  // A hashmap containing all the Bash Tag strings found in the masterlist and userlist and their unique IDs.
 	                                             // Ordered to make ensuring UIDs easy (check the UID of the last element then increment). Strings are case-preserved.
-
-	// Externally-visible data pointers storage.
+	std::unordered_map<std::string, uint32_t> bashTagIds;  // The reverse of bashTagMap.
+
+	// A plugin's Bash Tag suggestions from the filtered masterlist and the userlist, as UIDs.
+	struct PluginTags {
+		std::vector<uint32_t> added;
+		std::vector<uint32_t> removed;
+		bool userlistModified;
+
+		PluginTags() : userlistModified(false) {}
+	};
+	std::unordered_map<std::string, PluginTags> pluginTags;  // Lowercased plugin name -> its tags. Built on first use after Load or EvalConditionals.
+	bool pluginTagsBuilt;
+
+	// Externally-visible data storage. Each output is packed into its own arena,
+	// which is reset by the next call that gives the same output. The tag map is
+	// shared, but other outputs are kept per thread so that concurrent queries
+	// don't overwrite each other's.
+	struct Outputs {
+		boss::Arena stringArena;                 // GetIndexedPlugin() and GetDirtyMessage().
+		boss::Arena profileArena;                // GetProfileData().
+		boss::Arena stringArrayArena;            // GetLoadOrder(), GetActivePlugins() and the sorted plugins from SortMods().
+		boss::Arena stringArray2Arena;           // The unrecognised plugins from SortMods().
+		boss::Arena messageArena;                // GetPluginMessages().
+	};
+	struct ThreadOutputsEntry {
+		std::weak_ptr<char> owner;               // The thread's ThreadToken. Thread IDs can be reused, so this tells whether the entry is still its thread's.
+		std::unique_ptr<Outputs> outputs;
+	};
+	std::unordered_map<std::thread::id, ThreadOutputsEntry> threadOutputs;
+	std::mutex threadOutputsMutex;               // Guards threadOutputs, which shared holders of lock also add to.
+	boss::Arena tagMapArena;                     // GetBashTagMap().
+	boss::Arena updateArena;                     // UpdateMasterlists(), when this is the first db given.
 	BashTag *extTagMap;                          // Holds the pointer for the bashTagMap returned by GetBashTagMap().
-	uint32_t *extAddedTagIds;
-	uint32_t *extRemovedTagIds;
-	uint8_t *extString;
-	uint8_t **extStringArray;
-	uint8_t **extStringArray2;
-	BossMessage *extMessageArray;
-
-	// Pointer array sizes.
-	size_t extStringArraySize;
-	size_t extStringArray2Size;
-	size_t extMessageArraySize;
+	bool tagMapBuilt;                            // An empty tag map is output as NULL, so extTagMap can't tell if GetBashTagMap() has been run.
+
+	// Every API function holds this while it uses the db: shared if it only reads
+	// the db, and exclusively if it changes the db or its caches.
+	boss::RWLock lock;
 
 	// Constructor
 	_boss_db_int()
-	    : extTagMap(NULL),
-	      extAddedTagIds(NULL),
-	      extRemovedTagIds(NULL),
-	      extString(NULL),
-	      extStringArray(NULL),
-	      extStringArray2(NULL),
-	      extMessageArray(NULL),
-	      extStringArraySize(0),
-	      extStringArray2Size(0),
-	      extMessageArraySize(0),
-	      activePluginsMTime(0),
-	      loadOrderMTime(0) {}
-
-	~_boss_db_int() {
-		delete[] extAddedTagIds;
-		delete[] extRemovedTagIds;
-		delete[] extString;
-
-		if (extTagMap != NULL) {
-			for (size_t i = 0; i < bashTagMap.size(); i++)
-				delete[] extTagMap[i].name;  // Gotta clear those allocated strings.
-			delete[] extTagMap;
-		}
-
-		if (extMessageArray != NULL) {
-			for (size_t i = 0; i < extMessageArraySize; i++)
-				delete[] extMessageArray[i].message;  // Gotta clear those allocated strings.
-			delete[] extMessageArray;
-		}
-
-		if (extStringArray != NULL) {
-			for (size_t i = 0; i < extStringArraySize; i++)
-				delete[] extStringArray[i];  // Clear all the uint8_t strings created.
-			delete[] extStringArray;  // Clear the string array.
-		}
-
-		if (extStringArray2 != NULL) {
-			for (size_t i = 0; i < extStringArray2Size; i++)
-				delete[] extStringArray2[i];  // Clear all the uint8_t strings created.
-			delete[] extStringArray2;  // Clear the string array.
+	    : cacheHits(0),
+	      cacheMisses(0),
+	      pluginTagsBuilt(false),
+	      extTagMap(NULL),
+	      tagMapBuilt(false) {}
+
+	// Get the calling thread's outputs. Those of threads that have exited are
+	// freed when another thread's are created. Can throw std::bad_alloc.
+	Outputs &ThreadOutputs() {
+		const std::shared_ptr<char> &token = threadToken.Get().alive;
+		std::lock_guard<std::mutex> guard(threadOutputsMutex);
+		ThreadOutputsEntry &entry = threadOutputs[std::this_thread::get_id()];
+		if (entry.outputs && entry.owner.lock() == token)
+			return *entry.outputs;
+
+		entry.owner = token;
+		entry.outputs.reset(new Outputs);
+		for (std::unordered_map<std::thread::id, ThreadOutputsEntry>::iterator it = threadOutputs.begin(); it != threadOutputs.end();) {
+			if (it->second.owner.expired()) {
+				// Callers that only share lock don't synchronise with each other,
+				// so make sure the exited thread's last use of its outputs is seen
+				// before they're freed.
+				std::atomic_thread_fence(std::memory_order_acquire);
+				it = threadOutputs.erase(it);
+			} else {
+				++it;
+			}
 		}
+		return *entry.outputs;
 	}
 
 	// Get a Bash Tag's string name from its UID.
@@ -151,15 +193,66 @@ struct _boss_db_int {
 	}
 
 	// Get a Bash Tag's position in the bashTagMap from its string name.
-	std::map<uint32_t, std::string>::iterator FindBashTag(std::string value) {
-		std::map<uint32_t, std::string>::iterator mapPos = bashTagMap.begin();
-		while (mapPos != bashTagMap.end()) {
-			if (mapPos->second == value)
-				break;
-			++mapPos;
-		}
-		return mapPos;
+	std::map<uint32_t, std::string>::iterator FindBashTag(const std::string &value) {
+		std::unordered_map<std::string, uint32_t>::const_iterator idPos = bashTagIds.find(value);
+		if (idPos == bashTagIds.end())
+			return bashTagMap.end();
+		return bashTagMap.find(idPos->second);
 	}
+
+	// Adds a Bash Tag to the map if it isn't already in it.
+	void AddBashTag(const std::string &value) {
+		if (bashTagIds.find(value) != bashTagIds.end())
+			return;
+		uint32_t uid = uint32_t(bashTagMap.size());  // UIDs are contiguous from zero.
+		bashTagMap.insert(std::pair<uint32_t, std::string>(uid, value));
+		bashTagIds.insert(std::pair<std::string, uint32_t>(value, uid));
+	}
+
+	// Discards the per-plugin tags, eg. because the masterlist has been re-filtered.
+	void ClearPluginTags() {
+		pluginTags.clear();
+		pluginTagsBuilt = false;
+	}
+};
+
+// Sort structure, for sorts started by SortModsAsync().
+struct _boss_sort_int {
+	boss_db db;
+	bool trialOnly;
+	BossSortProgress progress;
+	void *userData;
+
+	std::thread worker;
+	std::atomic<bool> cancelled;
+	std::atomic<bool> finished;
+	std::mutex finishMutex;  // Guards joining the worker and building the outputs.
+
+	// Results, set by the worker before it sets finished.
+	uint32_t returnCode;
+	std::string errorDetails;
+	std::vector<boss::Item> recognised;
+	std::vector<boss::Item> unrecognised;
+
+	// Externally-visible data storage, built by the first FinishSort() call.
+	boss::Arena sortedArena;
+	boss::Arena unrecognisedArena;
+	uint8_t **extSorted;
+	uint8_t **extUnrecognised;
+	bool outputsBuilt;
+
+	// Constructor
+	_boss_sort_int()
+	    : db(NULL),
+	      trialOnly(false),
+	      progress(NULL),
+	      userData(NULL),
+	      cancelled(false),
+	      finished(false),
+	      returnCode(0),
+	      extSorted(NULL),
+	      extUnrecognised(NULL),
+	      outputsBuilt(false) {}
 };
 
 // The following are the possible codes that the API can return.
@@ -188,6 +281,7 @@ BOSS_API const uint32_t BOSS_API_ERROR_PLUGINS_FULL           = boss::BOSS_ERROR
 BOSS_API const uint32_t BOSS_API_ERROR_PLUGIN_BEFORE_MASTER   = boss::BOSS_ERROR_PLUGIN_BEFORE_MASTER;
 BOSS_API const uint32_t BOSS_API_ERROR_INVALID_SYNTAX         = boss::BOSS_ERROR_INVALID_SYNTAX;
 BOSS_API const uint32_t BOSS_API_ERROR_GIT_ERROR              = boss::BOSS_ERROR_GIT_ERROR;
+BOSS_API const uint32_t BOSS_API_ERROR_CANCELLED              = boss::BOSS_ERROR_CANCELLED;
 BOSS_API const uint32_t BOSS_API_RETURN_MAX                   = boss::BOSS_ERROR_MAX;
 
 // The following are the mod cleanliness states that the API can return.
@@ -216,6 +310,23 @@ BOSS_API extern const uint32_t BOSS_API_MESSAGE_DIRTY           = boss::DIRTY;
 BOSS_API extern const uint32_t BOSS_API_MESSAGE_WARN            = boss::WARN;
 BOSS_API extern const uint32_t BOSS_API_MESSAGE_ERROR           = boss::ERR;
 
+// The following are the fields that GetPluginsMetadata can fill in.
+BOSS_API const uint32_t BOSS_API_PLUGIN_MESSAGES   = 1;
+BOSS_API const uint32_t BOSS_API_PLUGIN_BASH_TAGS  = 2;
+BOSS_API const uint32_t BOSS_API_PLUGIN_DIRTY      = 4;
+BOSS_API const uint32_t BOSS_API_PLUGIN_RECOGNISED = 8;
+BOSS_API const uint32_t BOSS_API_PLUGIN_ACTIVE     = 16;
+BOSS_API const uint32_t BOSS_API_PLUGIN_MASTER     = 32;
+BOSS_API const uint32_t BOSS_API_PLUGIN_ALL        = 63;
+
+// The following are the phases of a sort started by SortModsAsync.
+BOSS_API const uint32_t BOSS_API_SORT_PHASE_LOAD_PLUGINS      = 0;
+BOSS_API const uint32_t BOSS_API_SORT_PHASE_FILTER_MASTERLIST = 1;
+BOSS_API const uint32_t BOSS_API_SORT_PHASE_APPLY_MASTERLIST  = 2;
+BOSS_API const uint32_t BOSS_API_SORT_PHASE_APPLY_USERLIST    = 3;
+BOSS_API const uint32_t BOSS_API_SORT_PHASE_APPLY_ORDER       = 4;
+BOSS_API const uint32_t BOSS_API_SORT_PHASE_FINISHED          = 5;
+
 
 //////////////////////////////
 // Internal Functions
@@ -275,31 +386,48 @@ void GetBashTagsFromString(const std::string message,
 	}
 }
 
-// This allocates memory - don't forget to free it later.
-uint8_t * StringToUint8_tString(std::string str) {
-	size_t length = str.length() + 1;
-	uint8_t *p = new uint8_t[length];
+// Resets arena and packs str into it. Can throw std::bad_alloc.
+uint8_t * StringToArena(boss::Arena &arena, const std::string &str) {
+	arena.Reset(boss::Arena::SizeOf(str));
+	return arena.CopyString(str);
+}
+
+// Resets arena and packs the names of the given items into it as an array of
+// strings. Returns NULL if there are no items. Can throw std::bad_alloc.
+uint8_t ** ItemNamesToArena(boss::Arena &arena,
+                            const std::vector<boss::Item> &items) {
+	size_t size = boss::Arena::SizeOf<uint8_t *>(items.size());
+	for (size_t i = 0, max = items.size(); i < max; i++)
+		size += boss::Arena::SizeOf(items[i].Name());
+	arena.Reset(size);
+
+	uint8_t **array = arena.Allocate<uint8_t *>(items.size());
+	for (size_t i = 0, max = items.size(); i < max; i++)
+		array[i] = arena.CopyString(items[i].Name());
+	return array;
+}
 
-	for (size_t j = 0; j < str.length(); j++) {  // UTF-8, so this is code-point by code-point rather than char by char, but same result here.
-		p[j] = str[j];
-	}
-	p[length - 1] = '\0';
-	return p;
+// Sets the calling thread's last error details. If there isn't the memory to,
+// the details are lost, but the return code still gets through.
+void SetLastErrorDetails(const std::string &details) {
+	try {
+		lastErrorDetails.Get() = details;
+	} catch (std::bad_alloc /*&e*/) {}
 }
 
 uint32_t ReturnCode(uint32_t returnCode, std::string details) {
-	lastErrorDetails = details;
+	SetLastErrorDetails(details);
 	//std::cerr << details << std::endl;
 	return returnCode;
 }
 
 uint32_t ReturnCode(uint32_t returnCode) {
-	lastErrorDetails = "";
+	SetLastErrorDetails("");
 	return returnCode;
 }
 
 uint32_t ReturnCode(boss::boss_error e) {
-	lastErrorDetails = e.getString();
+	SetLastErrorDetails(e.getString());
 	//std::cerr << e.getString() << std::endl;
 	return e.getCode();
 }
@@ -316,33 +444,144 @@ int progress(const git_transfer_progress *stats, void *payload) {
 }  // namespace
 //};
 
-std::time_t GetLoadOrderMTime(const boss::Game& game) {
-	try {
-		if (game.GetLoadOrderMethod() == boss::LOMETHOD_TEXTFILE && boost::filesystem::exists(game.LoadOrderFile())) {
-			// Load order is stored in game.LoadOrderFile(), but load order must also be reloaded if game.DataFolder() has been altered.
-			std::time_t t1 = boost::filesystem::last_write_time(game.LoadOrderFile());
-			std::time_t t2 = boost::filesystem::last_write_time(game.DataFolder());
-			if (t1 > t2)  // Return later time.
-				return t1;
-			return t2;
+// Re-reads the db's load order if any of the files it is read from may have
+// changed. The guard is only made exclusive if the load order needs re-reading.
+void RefreshLoadOrder(boss_db db, boss::RWLockGuard &guard) {
+	if (!db->loadOrderMonitor.HasChanged()) {
+		db->cacheHits++;
+		return;
+	}
+	if (!guard.IsExclusive()) {
+		guard.MakeExclusive();
+		if (!db->loadOrderMonitor.HasChanged()) {  // Another thread re-read it meanwhile.
+			db->cacheHits++;
+			return;
 		}
-		return boost::filesystem::last_write_time(game.DataFolder());
-	} catch(boost::filesystem::filesystem_error e) {
-		throw boss::boss_error(boss::BOSS_ERROR_FS_FILE_MOD_TIME_READ_FAIL, game.DataFolder().string(), e.what());
+	}
+	db->cacheMisses++;
+	db->loadOrderMonitor.MarkUpToDate();  // Before reading, so that changes made while reading aren't missed.
+	db->game.loadOrderState.Invalidate();  // Its own checks may not have seen the change the monitor did.
+	try {
+		db->loadOrder.Load(db->game, db->game.DataFolder());
+	} catch (boss::boss_error &/*e*/) {
+		db->loadOrderMonitor.Invalidate();
+		throw;
 	}
 }
 
-// Not really necessary, but it means we can handle the two mtime checks similarly.
-std::time_t GetActivePluginsMTime(const boss::Game& game) {
+// Re-reads the db's active plugins if plugins.txt may have changed. The guard
+// is only made exclusive if they need re-reading.
+void RefreshActivePlugins(boss_db db, boss::RWLockGuard &guard) {
+	if (!db->activePluginsMonitor.HasChanged()) {
+		db->cacheHits++;
+		return;
+	}
+	if (!guard.IsExclusive()) {
+		guard.MakeExclusive();
+		if (!db->activePluginsMonitor.HasChanged()) {  // Another thread re-read them meanwhile.
+			db->cacheHits++;
+			return;
+		}
+	}
+	db->cacheMisses++;
+	db->activePluginsMonitor.MarkUpToDate();
+	db->game.loadOrderState.Invalidate();
 	try {
-		if (boost::filesystem::exists(game.ActivePluginsFile()))
-			return boost::filesystem::last_write_time(game.ActivePluginsFile());
-		return 0;
-	} catch(boost::filesystem::filesystem_error e) {
-		throw boss::boss_error(boss::BOSS_ERROR_FS_FILE_MOD_TIME_READ_FAIL, game.ActivePluginsFile().string(), e.what());
+		if (boost::filesystem::exists(db->game.ActivePluginsFile()))
+			db->activePlugins.Load(db->game, db->game.ActivePluginsFile());
+	} catch (boss::boss_error &/*e*/) {
+		db->activePluginsMonitor.Invalidate();
+		throw;
 	}
 }
 
+// Works out every plugin's Bash Tag suggestions from the filtered masterlist and
+// the userlist in one pass, so that looking up a plugin's tags needs no searching
+// or parsing. The Bash Tag map must already be built. Can throw std::bad_alloc.
+void BuildPluginTags(boss_db db) {
+	if (db->pluginTagsBuilt)
+		return;
+	PROFILE_SCOPE("BuildPluginTags");
+
+	// Tag names, held until they can be turned into UIDs.
+	struct TagNames {
+		std::unordered_set<std::string> added;
+		std::unordered_set<std::string> removed;
+		bool userlistModified;
+
+		TagNames() : userlistModified(false) {}
+	};
+	std::unordered_map<std::string, TagNames> pluginTagNames;
+	std::unordered_set<std::string> seen;
+
+	// Only the first entry for each plugin counts, as with ItemList::FindItem.
+	std::vector<boss::Item> items = db->game.masterlist.Items();
+	for (size_t i = 0, max = items.size(); i < max; i++) {
+		if (items[i].Type() != boss::MOD)
+			continue;
+		std::string key = boost::to_lower_copy(items[i].Name());
+		if (!seen.insert(key).second)
+			continue;
+		std::vector<boss::Message> messages = items[i].Messages();
+		for (std::vector<boss::Message>::iterator messageIter = messages.begin(); messageIter != messages.end(); ++messageIter) {
+			if (messageIter->Key() == boss::TAG) {
+				TagNames &names = pluginTagNames[key];
+				GetBashTagsFromString(messageIter->Data(), names.added, names.removed);
+			}
+		}
+	}
+
+	// Only the first enabled rule for each plugin counts, as with RuleList::FindRule.
+	seen.clear();
+	std::vector<boss::Rule> rules = db->game.userlist.Rules();
+	for (size_t i = 0, max = rules.size(); i < max; i++) {
+		if (!rules[i].Enabled())
+			continue;
+		std::string key = boost::to_lower_copy(rules[i].Object());
+		if (!seen.insert(key).second)
+			continue;
+		std::vector<boss::RuleLine> lines = rules[i].Lines();
+		for (std::vector<boss::RuleLine>::iterator lineIter = lines.begin(); lineIter != lines.end(); ++lineIter) {
+			if (lineIter->Key() == boss::REPLACE) {
+				std::unordered_map<std::string, TagNames>::iterator namesPos = pluginTagNames.find(key);
+				if (namesPos != pluginTagNames.end() &&
+				    (!namesPos->second.added.empty() || !namesPos->second.removed.empty())) {
+					namesPos->second.added.clear();
+					namesPos->second.removed.clear();
+					namesPos->second.userlistModified = true;
+				}
+			}
+			if (lineIter->ObjectAsMessage().Key() == boss::TAG) {
+				TagNames &names = pluginTagNames[key];
+				GetBashTagsFromString(lineIter->Object(), names.added, names.removed);
+				names.userlistModified = true;
+			}
+		}
+	}
+
+	// Now convert the names to UIDs. Tags not in the map are dropped.
+	db->pluginTags.clear();
+	std::unordered_map<std::string, TagNames>::const_iterator namesIter;
+	for (namesIter = pluginTagNames.begin(); namesIter != pluginTagNames.end(); ++namesIter) {
+		_boss_db_int::PluginTags &tags = db->pluginTags[namesIter->first];
+		tags.userlistModified = namesIter->second.userlistModified;
+		std::unordered_set<std::string>::const_iterator tagStringIter;
+		for (tagStringIter = namesIter->second.added.begin(); tagStringIter != namesIter->second.added.end(); ++tagStringIter) {
+			std::unordered_map<std::string, uint32_t>::const_iterator idPos = db->bashTagIds.find(*tagStringIter);
+			if (idPos != db->bashTagIds.end())
+				tags.added.push_back(idPos->second);
+		}
+		for (tagStringIter = namesIter->second.removed.begin(); tagStringIter != namesIter->second.removed.end(); ++tagStringIter) {
+			std::unordered_map<std::string, uint32_t>::const_iterator idPos = db->bashTagIds.find(*tagStringIter);
+			if (idPos != db->bashTagIds.end())
+				tags.removed.push_back(idPos->second);
+		}
+		std::sort(tags.added.begin(), tags.added.end());
+		std::sort(tags.removed.begin(), tags.removed.end());
+	}
+	db->pluginTagsBuilt = true;
+}
+
 
 //////////////////////////////
 // Error Handling Functions
@@ -354,15 +593,11 @@ BOSS_API uint32_t GetLastErrorDetails(uint8_t **details) {
 	if (details == NULL)  // Check for valid args.
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
-	delete[] extErrorPointer;
-	extErrorPointer = NULL;
-
 	try {
-		extErrorPointer = StringToUint8_tString(lastErrorDetails);
+		*details = StringToArena(extErrorArena.Get(), lastErrorDetails.Get());
 	} catch (std::bad_alloc /*&e*/) {
 		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
 	}
-	*details = extErrorPointer;
 	return ReturnCode(BOSS_API_OK);
 }
 
@@ -391,15 +626,7 @@ BOSS_API uint32_t GetVersionString(uint8_t **bossVersionStr) {
 	if (bossVersionStr == NULL)  // Check for valid args.
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
-	delete[] extVersionPointer;
-	extVersionPointer = NULL;
-
-	try {
-		extVersionPointer = StringToUint8_tString(boss_version);
-	} catch (std::bad_alloc /*&e*/) {
-		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
-	}
-	*bossVersionStr = extVersionPointer;
+	*bossVersionStr = reinterpret_cast<uint8_t *>(const_cast<char *>(boss_version.c_str()));  // Never changes, so all threads can share it.
 	return ReturnCode(BOSS_API_OK);
 }
 
@@ -421,11 +648,20 @@ BOSS_API uint32_t CreateBossDb(boss_db *db, const uint32_t clientGame,
 	         clientGame != boss::SKYRIM /*&& clientGame != boss::MORROWIND*/)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Invalid game specified.");
 
-	// Set the locale to get encoding conversions working correctly.
-	std::setlocale(LC_CTYPE, "");
-	std::locale global_loc = std::locale();  // MCP Note: Which locale is this?
-	std::locale loc(global_loc, new boost::filesystem::detail::utf8_codecvt_facet());
-	boost::filesystem::path::imbue(loc);
+	// Set the locale to get encoding conversions working correctly. This is
+	// process-wide, so only do it once, in case other threads are using dbs.
+	// Tracing is switched on by the environment, and saved when a db is destroyed.
+	std::call_once(processSetUp, []() {
+		std::setlocale(LC_CTYPE, "");
+		std::locale global_loc = std::locale();  // MCP Note: Which locale is this?
+		std::locale loc(global_loc, new boost::filesystem::detail::utf8_codecvt_facet());
+		boost::filesystem::path::imbue(loc);
+
+		if (std::getenv("BOSS_TRACE") != NULL) {
+			traceFile = std::getenv("BOSS_TRACE");
+			boss::g_tracer.Enable(!traceFile.empty());
+		}
+	});
 
 	// Set game. Because this is a global and there may be multiple DBs for different games,
 	// each time a DB's function is called, it should be reset.
@@ -474,6 +710,17 @@ BOSS_API uint32_t CreateBossDb(boss_db *db, const uint32_t clientGame,
 	retVal->game = game;
 	*db = retVal;
 
+	std::vector<boost::filesystem::path> loadOrderPaths(1, game.DataFolder());
+	if (game.GetLoadOrderMethod() == boss::LOMETHOD_TEXTFILE) {
+		loadOrderPaths.push_back(game.LoadOrderFile());
+		loadOrderPaths.push_back(game.ActivePluginsFile());
+	}
+	retVal->loadOrderMonitor.Watch(loadOrderPaths);
+	retVal->activePluginsMonitor.Watch(std::vector<boost::filesystem::path>(1, game.ActivePluginsFile()));
+
+	// Profiling only costs a clock read per stage, so keep it on for GetProfileData().
+	boss::g_profiler.Enable(true);
+
 	// Since plugins.txt is derived from loadorder.txt in the same manner as the temporary file created above,
 	// with the derivation occurring whenever loadorder.txt is changed, if plugins.txt has not been changed
 	// by something other than the API (eg. the launcher), then the CRCs will match. Otherwise they will differ.
@@ -484,13 +731,23 @@ BOSS_API uint32_t CreateBossDb(boss_db *db, const uint32_t clientGame,
 
 BOSS_API void DestroyBossDb(boss_db db) {
 	delete db;  // Delete DB. Destructor handles memory deallocation.
+
+	if (boss::g_tracer.IsEnabled()) {
+		try {
+			boss::g_tracer.FlushJSON(traceFile);
+		} catch (boss::boss_error &e) {
+			LOG_ERROR("Error: could not save trace. Details: %s",
+			          e.getString().c_str());
+		}
+	}
 }
 
 BOSS_API void CleanUpAPI() {
-	delete[] extErrorPointer;
-	delete[] extVersionPointer;
-	extErrorPointer = NULL;
-	extVersionPointer = NULL;
+	// Only the calling thread's. Other threads' are freed when they exit.
+	lastErrorDetails.Release();
+	extErrorArena.Release();
+	threadToken.Release();  // Lets dbs discard this thread's outputs.
+	boss::g_logger.stop();  // Its thread can't be joined safely once the library is being unloaded.
 }
 
 
@@ -513,6 +770,8 @@ BOSS_API uint32_t Load(boss_db db, const uint8_t *masterlistPath,
 	if (db == NULL || masterlistPath == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, true);
+
 	// PATH SETTING
 	boost::filesystem::path masterlist_path = boost::filesystem::path(reinterpret_cast<const char *>(masterlistPath));
 	if (masterlist_path.empty())
@@ -524,62 +783,36 @@ BOSS_API uint32_t Load(boss_db db, const uint8_t *masterlistPath,
 			return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Userlist path is empty.");
 	}
 
+	boss::g_profiler.Reset();  // Process-wide, so this clears every db's profile data.
+
 	// Parse masterlist and userlist.
 	try {
-		masterlist.Load(db->game, masterlist_path);
+		// If the masterlist was just updated, it's been parsed in the background.
+		if (masterlist_path != db->game.Masterlist() ||
+		    !db->precompiler.Take(db->game, masterlist))
+			masterlist.Load(db->game, masterlist_path);
 		if (userlistPath != NULL)
 			userlist.Load(db->game, userlist_path);
 	} catch (boss::boss_error &e) {
 		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 	}
 
-	// FREE CURRENT POINTERS
-	// Free memory at pointers stored in structure.
-	delete[] db->extAddedTagIds;
-	delete[] db->extRemovedTagIds;
-	delete[] db->extString;
-
-	db->extAddedTagIds = NULL;
-	db->extRemovedTagIds = NULL;
-	db->extString = NULL;
-
-	if (db->extTagMap != NULL) {
-		for (size_t i = 0; i < db->bashTagMap.size(); i++)
-			delete[] db->extTagMap[i].name;  // Gotta clear those allocated strings.
-		delete[] db->extTagMap;
-		db->extTagMap = NULL;
-		db->bashTagMap.clear();
-	}
-
-	if (db->extMessageArray != NULL) {
-		for (size_t i = 0; i < db->extMessageArraySize; i++)
-			delete[] db->extMessageArray[i].message;  // Gotta clear those allocated strings.
-		delete[] db->extMessageArray;
-		db->extMessageArray = NULL;
-		db->extMessageArraySize = 0;
-	}
-
-	if (db->extStringArray != NULL) {
-		for (size_t i = 0; i < db->extStringArraySize; i++)
-			delete[] db->extStringArray[i];  // Clear all the uint8_t strings created.
-		delete[] db->extStringArray;  // Clear the string array.
-		db->extStringArray = NULL;
-		db->extStringArraySize = 0;
-	}
-
-	if (db->extStringArray2 != NULL) {
-		for (size_t i = 0; i < db->extStringArray2Size; i++)
-			delete[] db->extStringArray2[i];  // Clear all the uint8_t strings created.
-		delete[] db->extStringArray2;  // Clear the string array.
-		db->extStringArray2 = NULL;
-		db->extStringArray2Size = 0;
+	// FREE CURRENT OUTPUTS
+	db->tagMapArena.Release();
+	{
+		std::lock_guard<std::mutex> outputsGuard(db->threadOutputsMutex);
+		db->threadOutputs.clear();
 	}
+	db->extTagMap = NULL;
+	db->tagMapBuilt = false;
 
 	// DB SET
 	db->rawMasterlist = masterlist;
 	db->game.masterlist = masterlist;  // Not actually filtered, but retrival functions assume filtered masterlist is populated.
 	db->game.userlist = userlist;
 	db->bashTagMap.clear();
+	db->bashTagIds.clear();
+	db->ClearPluginTags();
 	return ReturnCode(BOSS_API_OK);
 }
 
@@ -590,6 +823,8 @@ BOSS_API uint32_t EvalConditionals(boss_db db) {
 	if (db == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, true);
+
 	boss::ItemList masterlist = db->rawMasterlist;
 	try {
 		masterlist.EvalConditions(db->game);  // First evaluate conditionals.
@@ -600,6 +835,7 @@ BOSS_API uint32_t EvalConditionals(boss_db db) {
 
 	// Now set DB ItemList to function's ItemList.
 	db->game.masterlist = masterlist;
+	db->ClearPluginTags();  // Plugins' tags depend on which masterlist entries passed.
 	return ReturnCode(BOSS_API_OK);
 }
 
@@ -618,6 +854,8 @@ BOSS_API uint32_t UpdateMasterlist(boss_db db, const uint8_t *masterlistPath) {
 	if (db == NULL /*|| masterlistPath == NULL*/)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, true);
+
 	// PATH SETTING
 	//boost::filesystem::path masterlist_path = boost::filesystem::path(reinterpret_cast<const char *>(masterlistPath));
 
@@ -627,7 +865,8 @@ BOSS_API uint32_t UpdateMasterlist(boss_db db, const uint8_t *masterlistPath) {
 	try {
 		//std::string localDate, remoteDate;
 		//uint32_t localRevision, remoteRevision;
-		boss::UpdateMasterlist(db->game, progress, NULL);
+		std::string revision = boss::UpdateMasterlist(db->game, progress, NULL);
+		db->precompiler.Start(db->game, revision);
 		//mUpdater.Update(db->game, masterlist_path, localRevision, localDate, remoteRevision, remoteDate);
 		//if (localRevision == remoteRevision)
 		//	return ReturnCode(BOSS_API_OK_NO_UPDATE_NECESSARY);
@@ -637,6 +876,67 @@ BOSS_API uint32_t UpdateMasterlist(boss_db db, const uint8_t *masterlistPath) {
 	}
 }
 
+BOSS_API uint32_t UpdateMasterlists(boss_db *dbs, const size_t numDbs,
+                                    MasterlistUpdateResult **results) {
+	if (dbs == NULL || results == NULL)
+		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+	*results = NULL;
+	if (numDbs == 0)
+		return ReturnCode(BOSS_API_OK);
+
+	try {
+		// Hold every db while its masterlist is updated. Taking their locks in
+		// address order stops overlapping calls from deadlocking each other.
+		std::vector<boss_db> lockOrder(dbs, dbs + numDbs);
+		std::sort(lockOrder.begin(), lockOrder.end());
+		std::unordered_set<std::string> folders;
+		for (size_t i = 0; i < numDbs; i++) {
+			if (lockOrder[i] == NULL)
+				return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+			if (i > 0 && lockOrder[i] == lockOrder[i - 1])
+				return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "The same DB was given more than once.");
+			if (!folders.insert(lockOrder[i]->game.Masterlist().parent_path().string()).second)
+				return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "More than one DB has the same masterlist folder.");
+		}
+		std::vector<std::unique_ptr<boss::RWLockGuard> > guards;
+		for (size_t i = 0; i < numDbs; i++)
+			guards.push_back(std::unique_ptr<boss::RWLockGuard>(new boss::RWLockGuard(lockOrder[i]->lock, true)));
+
+		std::vector<boss::Game *> games;
+		for (size_t i = 0; i < numDbs; i++)
+			games.push_back(&dbs[i]->game);
+		std::vector<boss::MasterlistUpdate> updates = boss::UpdateMasterlists(games, NULL, NULL);
+
+		// Now create the external array. It's kept by the first db, which is
+		// held exclusively until it's filled in.
+		boss::Arena &updateArena = dbs[0]->updateArena;
+		size_t size = boss::Arena::SizeOf<MasterlistUpdateResult>(numDbs);
+		for (size_t i = 0; i < numDbs; i++)
+			size += boss::Arena::SizeOf(updates[i].revision) + boss::Arena::SizeOf(updates[i].errorString);
+		updateArena.Reset(size);
+		MasterlistUpdateResult *resultArray = updateArena.Allocate<MasterlistUpdateResult>(numDbs);
+		for (size_t i = 0; i < numDbs; i++) {
+			if (updates[i].errorCode == boss::BOSS_OK) {
+				dbs[i]->precompiler.Start(dbs[i]->game, updates[i].revision);
+				resultArray[i].returnCode = BOSS_API_OK;
+				resultArray[i].revision = updateArena.CopyString(updates[i].revision);
+				resultArray[i].errorDetails = NULL;
+			} else {
+				// Match UpdateMasterlist(), which gives all update errors as Git errors.
+				resultArray[i].returnCode = updates[i].errorCode == boss::BOSS_ERROR_NO_MEM ? BOSS_API_ERROR_NO_MEM : BOSS_API_ERROR_GIT_ERROR;
+				resultArray[i].revision = NULL;
+				resultArray[i].errorDetails = updateArena.CopyString(updates[i].errorString);
+			}
+		}
+		*results = resultArray;
+	} catch (std::bad_alloc /*&e*/) {
+		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
+	}
+
+	return ReturnCode(BOSS_API_OK);
+}
+
 ////////////////////////////////
 // Plugin Sorting Functions
 ////////////////////////////////
@@ -646,11 +946,90 @@ BOSS_API uint32_t GetLoadOrderMethod(boss_db db, uint32_t *method) {
 	if (db == NULL || method == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);
+
 	*method = db->game.GetLoadOrderMethod();
 
 	return ReturnCode(BOSS_API_OK);
 }
 
+// Starts a phase of the given sort, reporting it to the client. Does nothing
+// for synchronous sorts, which are given a NULL sort. Throws BOSS_ERROR_CANCELLED
+// if the sort has been cancelled.
+void BeginSortPhase(_boss_sort_int *sort, uint32_t phase) {
+	if (sort == NULL)
+		return;
+	if (sort->cancelled)
+		throw boss::boss_error(boss::BOSS_ERROR_CANCELLED);
+	if (sort->progress != NULL)
+		sort->progress(phase, 0, 0, sort->userData);
+}
+
+// Passed to Game::SortPlugins() for asynchronous sorts.
+bool ReportSortProgress(std::size_t done, std::size_t total, void *data) {
+	_boss_sort_int *sort = static_cast<_boss_sort_int *>(data);
+	if (sort->progress != NULL)
+		sort->progress(BOSS_API_SORT_PHASE_APPLY_ORDER, done, total,
+		               sort->userData);
+	return !sort->cancelled;
+}
+
+// Does the work of SortMods() and SortModsAsync(), recording the recognised and
+// unrecognised plugins. sort is NULL for synchronous sorts.
+uint32_t SortModsInt(boss_db db, const bool trialOnly, _boss_sort_int *sort,
+                     std::vector<boss::Item> &recognised,
+                     std::vector<boss::Item> &unrecognised) {
+	boss::RWLockGuard guard(db->lock, true);
+
+	TRACE_SCOPE("SortMods");
+
+	// Set up working modlist.
+	std::vector<boss::Item> items;
+	try {
+		BeginSortPhase(sort, BOSS_API_SORT_PHASE_LOAD_PLUGINS);
+		db->game.modlist.Load(db->game, db->game.DataFolder());
+		BeginSortPhase(sort, BOSS_API_SORT_PHASE_FILTER_MASTERLIST);
+		db->game.masterlist.EvalConditions(db->game);  // In case it hasn't already been filtered.
+		db->game.masterlist.EvalRegex(db->game);       // In case it hasn't already been filtered.
+		BeginSortPhase(sort, BOSS_API_SORT_PHASE_APPLY_MASTERLIST);
+		db->game.ApplyMasterlist();
+		BeginSortPhase(sort, BOSS_API_SORT_PHASE_APPLY_USERLIST);
+		db->game.ApplyUserlist();
+		// Before the master partition is applied in SortPlugins(), record recognised and unrecognised plugins.
+		items = db->game.modlist.Items();
+		if (db->game.modlist.LastRecognisedPos() > 0) {
+			recognised = std::vector<boss::Item>(items.begin(), items.begin() + db->game.modlist.LastRecognisedPos());
+			unrecognised = std::vector<boss::Item>(items.begin() + db->game.modlist.LastRecognisedPos() + 1, items.end());
+		}
+		BeginSortPhase(sort, BOSS_API_SORT_PHASE_APPLY_ORDER);
+		if (sort == NULL)
+			db->game.SortPlugins(trialOnly);
+		else
+			db->game.SortPlugins(trialOnly, ReportSortProgress, sort);
+	} catch (boss::boss_error &e) {
+		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
+	}
+
+	return ReturnCode(BOSS_API_OK);
+}
+
+// Runs on the worker thread of a sort started by SortModsAsync().
+void RunSort(_boss_sort_int *sort) {
+	try {
+		sort->returnCode = SortModsInt(sort->db, sort->trialOnly, sort,
+		                               sort->recognised, sort->unrecognised);
+	} catch (std::bad_alloc /*&e*/) {
+		sort->returnCode = ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
+	}
+	try {
+		sort->errorDetails = lastErrorDetails.Get();  // This thread's, so FinishSort() passes it on.
+	} catch (std::bad_alloc /*&e*/) {}
+	lastErrorDetails.Release();  // The worker is about to exit.
+	sort->finished = true;
+	if (sort->progress != NULL)
+		sort->progress(BOSS_API_SORT_PHASE_FINISHED, 0, 0, sort->userData);
+}
+
 // Sorts the mods in the data path, using the masterlist at the masterlist path,
 // specified when the db was loaded using Load. Outputs a list of plugins, pointed to
 // by sortedPlugins, of length pointed to by listLength. lastRecPos points to the
@@ -682,93 +1061,154 @@ BOSS_API uint32_t SortMods(boss_db db,
 	if (unrecListLength != NULL)
 		*unrecListLength = 0;
 
-	// Free memory if already used.
-	if (db->extStringArray != NULL) {
-		for (size_t i = 0; i < db->extStringArraySize; i++)
-			delete[] db->extStringArray[i];  // Clear all the uint8_t strings created.
-		delete[] db->extStringArray;  // Clear the string array.
-		db->extStringArray = NULL;
-		db->extStringArraySize = 0;
-	}
-	if (db->extStringArray2 != NULL) {
-		for (size_t i = 0; i < db->extStringArray2Size; i++)
-			delete[] db->extStringArray2[i];  // Clear all the uint8_t strings created.
-		delete[] db->extStringArray2;  // Clear the string array.
-		db->extStringArray2 = NULL;
-		db->extStringArray2Size = 0;
-	}
+	std::vector<boss::Item> recognised, unrecognised;
+	uint32_t ret = SortModsInt(db, trialOnly, NULL, recognised, unrecognised);
+	if (ret != BOSS_API_OK)
+		return ret;
 
-	// Set up working modlist.
-	boss::gl_trial_run = trialOnly;
-	std::vector<boss::Item> items, recognised, unrecognised;
+	// Now create external arrays.
+	uint8_t **sortedArray, **unrecognisedArray;
 	try {
-		db->game.modlist.Load(db->game, db->game.DataFolder());
-		db->game.masterlist.EvalConditions(db->game);  // In case it hasn't already been filtered.
-		db->game.masterlist.EvalRegex(db->game);       // In case it hasn't already been filtered.
-		db->game.ApplyMasterlist();
-		db->game.ApplyUserlist();
-		// Before the master partition is applied in SortPlugins(), record recognised and unrecognised plugins.
-		items = db->game.modlist.Items();
-		if (db->game.modlist.LastRecognisedPos() > 0) {
-			recognised = std::vector<boss::Item>(items.begin(), items.begin() + db->game.modlist.LastRecognisedPos());
-			unrecognised = std::vector<boss::Item>(items.begin() + db->game.modlist.LastRecognisedPos() + 1, items.end());
-		}
-		db->game.SortPlugins();
-	} catch (boss::boss_error &e) {
-		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
+		_boss_db_int::Outputs &outputs = db->ThreadOutputs();
+		sortedArray = ItemNamesToArena(outputs.stringArrayArena, recognised);
+		unrecognisedArray = ItemNamesToArena(outputs.stringArray2Arena, unrecognised);
+	} catch (std::bad_alloc /*&e*/) {
+		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
 	}
 
-	// Now create external arrays.
-	db->extStringArraySize = recognised.size();
-	db->extStringArray2Size = unrecognised.size();
+	// Set outputs.
+	if (sortedPlugins != NULL)
+		*sortedPlugins = sortedArray;
+	if (sortedListLength != NULL)
+		*sortedListLength = recognised.size();
+	if (unrecognisedPlugins != NULL)
+		*unrecognisedPlugins = unrecognisedArray;
+	if (unrecListLength != NULL)
+		*unrecListLength = unrecognised.size();
+
+	return ReturnCode(BOSS_API_OK);
+}
+
+BOSS_API uint32_t SortModsAsync(boss_db db,
+                                const bool trialOnly,
+                                BossSortProgress progress,
+                                void *userData,
+                                boss_sort *sort) {
+	if (db == NULL || sort == NULL)
+		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+	_boss_sort_int *retVal = NULL;
 	try {
-		// All plugins.
-		db->extStringArray = new uint8_t*[db->extStringArraySize];
-		for (size_t i = 0; i < db->extStringArraySize; i++)
-			db->extStringArray[i] = StringToUint8_tString(recognised[i].Name());
-		// Unrecognised plugins.
-		db->extStringArray2 = new uint8_t*[db->extStringArray2Size];
-		for (size_t i = 0; i < db->extStringArray2Size; i++)
-			db->extStringArray2[i] = StringToUint8_tString(unrecognised[i].Name());
+		retVal = new _boss_sort_int;
+		retVal->db = db;
+		retVal->trialOnly = trialOnly;
+		retVal->progress = progress;
+		retVal->userData = userData;
+		retVal->worker = std::thread(RunSort, retVal);
 	} catch (std::bad_alloc /*&e*/) {
+		delete retVal;
 		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
+	} catch (std::system_error &e) {
+		delete retVal;
+		return ReturnCode(BOSS_API_ERROR_NO_MEM, std::string("The sort thread could not be started: ") + e.what());
+	}
+	*sort = retVal;
+
+	return ReturnCode(BOSS_API_OK);
+}
+
+BOSS_API uint32_t CancelSort(boss_sort sort) {
+	if (sort == NULL)
+		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+	sort->cancelled = true;
+
+	return ReturnCode(BOSS_API_OK);
+}
+
+BOSS_API uint32_t IsSortFinished(boss_sort sort, bool *finished) {
+	if (sort == NULL || finished == NULL)
+		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+	*finished = sort->finished;
+
+	return ReturnCode(BOSS_API_OK);
+}
+
+BOSS_API uint32_t FinishSort(boss_sort sort,
+                             uint8_t ***sortedPlugins,
+                             size_t *sortedListLength,
+                             uint8_t ***unrecognisedPlugins,
+                             size_t *unrecListLength) {
+	if (sort == NULL)
+		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+	// Initialise vars.
+	if (sortedPlugins != NULL)
+		*sortedPlugins = NULL;
+	if (unrecognisedPlugins != NULL)
+		*unrecognisedPlugins = NULL;
+	if (sortedListLength != NULL)
+		*sortedListLength = 0;
+	if (unrecListLength != NULL)
+		*unrecListLength = 0;
+
+	std::lock_guard<std::mutex> guard(sort->finishMutex);
+	if (sort->worker.joinable())
+		sort->worker.join();
+
+	if (sort->returnCode != BOSS_API_OK)
+		return ReturnCode(sort->returnCode, sort->errorDetails);
+
+	// Now create external arrays.
+	if (!sort->outputsBuilt) {
+		try {
+			sort->extSorted = ItemNamesToArena(sort->sortedArena, sort->recognised);
+			sort->extUnrecognised = ItemNamesToArena(sort->unrecognisedArena, sort->unrecognised);
+		} catch (std::bad_alloc /*&e*/) {
+			return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
+		}
+		sort->outputsBuilt = true;
 	}
 
 	// Set outputs.
 	if (sortedPlugins != NULL)
-		*sortedPlugins = db->extStringArray;
+		*sortedPlugins = sort->extSorted;
 	if (sortedListLength != NULL)
-		*sortedListLength = db->extStringArraySize;
+		*sortedListLength = sort->recognised.size();
 	if (unrecognisedPlugins != NULL)
-		*unrecognisedPlugins = db->extStringArray2;
+		*unrecognisedPlugins = sort->extUnrecognised;
 	if (unrecListLength != NULL)
-		*unrecListLength = db->extStringArray2Size;
+		*unrecListLength = sort->unrecognised.size();
 
 	return ReturnCode(BOSS_API_OK);
 }
 
+BOSS_API void DestroySort(boss_sort sort) {
+	if (sort == NULL)
+		return;
+	{
+		std::lock_guard<std::mutex> guard(sort->finishMutex);
+		if (sort->worker.joinable())
+			sort->worker.join();
+	}
+	delete sort;
+}
+
 // Gets a list of plugins in load order, with the number of plugins given by numPlugins.
 BOSS_API uint32_t GetLoadOrder(boss_db db, uint8_t ***plugins,
                                size_t *numPlugins) {
 	if (db == NULL || plugins == NULL || numPlugins == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);  // Made exclusive if the cache needs re-reading.
+
 	// Initialise vars.
 	*numPlugins = 0;
 	*plugins = NULL;
 
-	// Free memory if already used.
-	if (db->extStringArray != NULL) {
-		for (size_t i = 0; i < db->extStringArraySize; i++)
-			delete[] db->extStringArray[i];  // Clear all the uint8_t strings created.
-		delete[] db->extStringArray;  // Clear the string array.
-		db->extStringArray = NULL;
-		db->extStringArraySize = 0;
-	}
-
 	try {
-		if (GetLoadOrderMTime(db->game) != db->loadOrderMTime)
-			db->loadOrder.Load(db->game, db->game.DataFolder());
+		RefreshLoadOrder(db, guard);
 	} catch (boss::boss_error &e) {
 		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 	}
@@ -792,19 +1232,13 @@ BOSS_API uint32_t GetLoadOrder(boss_db db, uint8_t ***plugins,
 	if (items.empty())
 		return ReturnCode(BOSS_API_OK);
 
-	// Allocate memory.
-	db->extStringArraySize = items.size();
+	// Allocate memory and set outputs.
 	try {
-		db->extStringArray = new uint8_t*[db->extStringArraySize];
-		for (size_t i = 0; i < db->extStringArraySize; i++)
-			db->extStringArray[i] = StringToUint8_tString(items[i].Name());
+		*plugins = ItemNamesToArena(db->ThreadOutputs().stringArrayArena, items);
 	} catch (std::bad_alloc /*&e*/) {
 		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
 	}
-
-	// Set outputs.
-	*plugins = db->extStringArray;
-	*numPlugins = db->extStringArraySize;
+	*numPlugins = items.size();
 
 	return ReturnCode(BOSS_API_OK);
 }
@@ -815,34 +1249,37 @@ BOSS_API uint32_t SetLoadOrder(boss_db db, uint8_t **plugins,
 	if (db == NULL || plugins == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, true);
+
 	// Check load order to see if it's valid.
 	if (numPlugins > 0 && !boss::Item(std::string(reinterpret_cast<const char *>(plugins[0]))).IsGameMasterFile(db->game))
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Plugins may not be sorted before the game's master file.");
 
-	// Create a vector to hold the new loadorder.
-	db->loadOrder.Clear();
+	// Build the new load order separately, so that the cached one is only
+	// replaced once it has been written.
+	boss::ItemList loadOrder;
 	// We need to loop through the plugin array given and enter each plugin into the vector.
 	// Also check that the plugins being added actually exist.
 	for (size_t i = 0; i < numPlugins; i++) {
 		boss::Item plugin = boss::Item(std::string(reinterpret_cast<const char *>(plugins[i])));
 		if (plugin.Exists(db->game))
-			db->loadOrder.Insert(i, plugin);
+			loadOrder.Insert(i, plugin);
 		else
 			return ReturnCode(boss::boss_error(boss::BOSS_ERROR_FILE_NOT_FOUND, plugin.Name()));
 	}
-	size_t loSize = db->loadOrder.Items().size();
+	size_t loSize = loadOrder.Items().size();
 
 	// Check to see if the masters before plugins rule is being obeyed.
 	try {
-		size_t pos = db->loadOrder.GetLastMasterPos(db->game);
-		if (db->loadOrder.GetNextMasterPos(db->game, pos + 1) != loSize)  // Masters exist after the initial set of masters. Not allowed.
+		size_t pos = loadOrder.GetLastMasterPos(db->game);
+		if (loadOrder.GetNextMasterPos(db->game, pos + 1) != loSize)  // Masters exist after the initial set of masters. Not allowed.
 			return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Master files must load before other plugins.");
 
 		// If Update.esm is installed, check if it is listed. If not, add it after the rest of the master files.
 		if (db->game.Id() == boss::SKYRIM &&
 		    boost::filesystem::exists(db->game.DataFolder() / "Update.esm") &&
-		    db->loadOrder.FindItem("Update.esm", boss::MOD) == loSize) {
-			db->loadOrder.Insert(pos + 1, boss::Item("Update.esm"));  // Previous master check ensures that GetLastMasterPos() will be not be loadOrder.size().
+		    loadOrder.FindItem("Update.esm", boss::MOD) == loSize) {
+			loadOrder.Insert(pos + 1, boss::Item("Update.esm"));  // Previous master check ensures that GetLastMasterPos() will be not be loadOrder.size().
 			loSize++;
 		}
 	} catch (boss::boss_error &e) {
@@ -862,15 +1299,15 @@ BOSS_API uint32_t SetLoadOrder(boss_db db, uint8_t **plugins,
 				LOG_TRACE("-- Found mod: '%s'", filename.string().c_str());
 				// Add file to modlist. If the filename has a '.ghost' extension, remove it.
 				const boss::Item tempItem = boss::Item(filename.string());
-				if (db->loadOrder.FindItem(tempItem.Name(), boss::MOD) == loSize) {  // If the plugin is not present, add it.
-					db->loadOrder.Insert(loSize, tempItem);
+				if (loadOrder.FindItem(tempItem.Name(), boss::MOD) == loSize) {  // If the plugin is not present, add it.
+					loadOrder.Insert(loSize, tempItem);
 					loSize++;
 				}
 			}
 		}
 	}
 	try {
-		db->loadOrder.ApplyMasterPartition(db->game);  // Apply partition to sort those just added.
+		loadOrder.ApplyMasterPartition(db->game);  // Apply partition to sort those just added.
 	} catch (boss::boss_error &e) {
 		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 	}
@@ -878,13 +1315,16 @@ BOSS_API uint32_t SetLoadOrder(boss_db db, uint8_t **plugins,
 	if (db->game.GetLoadOrderMethod() == boss::LOMETHOD_TEXTFILE) {  // Skyrim.
 		// Now save the new loadorder. Also update the plugins.txt.
 		try {
-			db->loadOrder.SavePluginNames(db->game, db->game.LoadOrderFile(), false, false);
-			db->loadOrder.SavePluginNames(db->game, db->game.ActivePluginsFile(), true, true);
+			loadOrder.SavePluginNames(db->game, db->game.LoadOrderFile(), false, false);
+			loadOrder.SavePluginNames(db->game, db->game.ActivePluginsFile(), true, true);
 		} catch (boss::boss_error &e) {
+			// Either file may have been written, so re-read both when they're next needed.
+			db->loadOrderMonitor.Invalidate();
+			db->activePluginsMonitor.Invalidate();
 			return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 		}
-		// Now update cached mtime for plugins.txt.
-		db->activePluginsMTime = GetActivePluginsMTime(db->game);
+		// plugins.txt was derived from the new load order, so re-read it when it's next needed.
+		db->activePluginsMonitor.Invalidate();
 	} else {  // Non-skyrim.
 		// Get the master time to derive dates from.
 		std::time_t masterTime;
@@ -895,19 +1335,21 @@ BOSS_API uint32_t SetLoadOrder(boss_db db, uint8_t **plugins,
 		}
 
 		// Loop through given array and set the modification time for each one.
-		std::vector<boss::Item> items = db->loadOrder.Items();
+		std::vector<boss::Item> items = loadOrder.Items();
 		for (size_t i = 0; i < loSize; i++) {
 			if (!items[i].IsGameMasterFile(db->game)) {
 				try {
 					items[i].SetModTime(db->game, masterTime + i * 60);  // time_t is an integer number of seconds, so adding 60 on increases it by a minute.
 				} catch(boss::boss_error &e) {
+					db->loadOrderMonitor.Invalidate();  // Some plugins may have been redated.
 					return ReturnCode(e);
 				}
 			}
 		}
 	}
-	// Now update cached mtime for load order.
-	db->loadOrderMTime = GetLoadOrderMTime(db->game);
+	// The load order in memory now matches what was written.
+	db->loadOrder = loadOrder;
+	db->loadOrderMonitor.MarkUpToDate();
 
 	return ReturnCode(BOSS_API_OK);
 }
@@ -918,42 +1360,34 @@ BOSS_API uint32_t GetActivePlugins(boss_db db, uint8_t ***plugins,
 	if (db == NULL || plugins == NULL || numPlugins == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);  // Made exclusive if the cache needs re-reading.
+
 	// Initialise vars.
 	*numPlugins = 0;
 	*plugins = NULL;
 
-	// Free memory if already used.
-	if (db->extStringArray != NULL) {
-		for (size_t i = 0; i < db->extStringArraySize; i++)
-			delete[] db->extStringArray[i];  // Clear all the uint8_t strings created.
-		delete[] db->extStringArray;  // Clear the string array.
-		db->extStringArray = NULL;
-		db->extStringArraySize = 0;
-	}
-
 	// Load plugins.txt.
 	try {
-		if (boost::filesystem::exists(db->game.ActivePluginsFile()) &&
-		   (GetActivePluginsMTime(db->game) != db->activePluginsMTime ||
-		    GetLoadOrderMTime(db->game) != db->loadOrderMTime))
-			db->activePlugins.Load(db->game, db->game.ActivePluginsFile());
+		RefreshActivePlugins(db, guard);
 	} catch (boss::boss_error &e) {
 		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 	}
 
 	// If Skyrim, we want to also output Skyrim.esm, Update.esm, if they are missing.
-	size_t size = db->activePlugins.Items().size();
+	// They're added to a copy, as they aren't in plugins.txt.
+	boss::ItemList activePlugins = db->activePlugins;
+	size_t size = activePlugins.Items().size();
 	if (db->game.Id() == boss::SKYRIM) {
 		// Check if Skyrim.esm is missing.
-		if (db->activePlugins.FindItem("Skyrim.esm", boss::MOD) == size) {
-			db->activePlugins.Insert(0, boss::Item("Skyrim.esm"));
+		if (activePlugins.FindItem("Skyrim.esm", boss::MOD) == size) {
+			activePlugins.Insert(0, boss::Item("Skyrim.esm"));
 			size++;
 		}
 		// If Update.esm is installed, check if it is listed. If not, add it after the rest of the master files.
 		if (boost::filesystem::exists(db->game.DataFolder() / "Update.esm") &&
-		    db->activePlugins.FindItem("Update.esm", boss::MOD) == size) {
+		    activePlugins.FindItem("Update.esm", boss::MOD) == size) {
 			try {
-				db->activePlugins.Insert(db->activePlugins.GetLastMasterPos(db->game) + 1, boss::Item("Update.esm"));  // Previous master check ensures that GetLastMasterPos() will be not be loadorder.size().
+				activePlugins.Insert(activePlugins.GetLastMasterPos(db->game) + 1, boss::Item("Update.esm"));  // Previous master check ensures that GetLastMasterPos() will be not be loadorder.size().
 				size++;
 			} catch (boss::boss_error &e) {
 				return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
@@ -962,23 +1396,17 @@ BOSS_API uint32_t GetActivePlugins(boss_db db, uint8_t ***plugins,
 	}
 
 	// Check array size. Exit if zero.
-	std::vector<boss::Item> items = db->activePlugins.Items();
+	std::vector<boss::Item> items = activePlugins.Items();
 	if (items.empty())
 		return ReturnCode(BOSS_API_OK);
 
-	// Allocate memory.
-	db->extStringArraySize = size;
+	// Allocate memory and set outputs.
 	try {
-		db->extStringArray = new uint8_t*[db->extStringArraySize];
-		for (size_t i = 0; i < db->extStringArraySize; i++)
-			db->extStringArray[i] = StringToUint8_tString(items[i].Name());
+		*plugins = ItemNamesToArena(db->ThreadOutputs().stringArrayArena, items);
 	} catch (std::bad_alloc /*&e*/) {
 		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
 	}
-
-	// Set outputs.
-	*plugins = db->extStringArray;
-	*numPlugins = db->extStringArraySize;
+	*numPlugins = items.size();
 
 	return ReturnCode(BOSS_API_OK);
 }
@@ -990,6 +1418,8 @@ BOSS_API uint32_t SetActivePlugins(boss_db db, uint8_t **plugins,
 	if (db == NULL || plugins == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, true);
+
 	if (numPlugins > 255)
 		return ReturnCode(boss::boss_error(BOSS_API_ERROR_PLUGINS_FULL));
 
@@ -998,13 +1428,14 @@ BOSS_API uint32_t SetActivePlugins(boss_db db, uint8_t **plugins,
 	    !boss::Item(std::string(reinterpret_cast<const char *>(plugins[0]))).IsGameMasterFile(db->game))
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Plugins may not be sorted before the game's master file.");
 
-	// Fill the ItemList with the input.
+	// Fill the ItemList with the input, separately from the cached active plugins
+	// so that they're only replaced once plugins.txt has been written.
 	// Check that plugins being added actually exist.
-	db->activePlugins.Clear();
+	boss::ItemList activePlugins;
 	for (size_t i = 0; i < numPlugins; i++) {
 		boss::Item plugin = boss::Item(std::string(reinterpret_cast<const char *>(plugins[i])));
 		if (plugin.Exists(db->game)) {
-			db->activePlugins.Insert(i, plugin);
+			activePlugins.Insert(i, plugin);
 			try {
 				plugin.UnGhost(db->game);
 			} catch (boss::boss_error &e) {
@@ -1016,41 +1447,50 @@ BOSS_API uint32_t SetActivePlugins(boss_db db, uint8_t **plugins,
 	}
 
 	// If Update.esm is installed, check if it is listed. If not, add it (order is decided later).
-	size_t size = db->activePlugins.Items().size();
+	size_t size = activePlugins.Items().size();
 	if (db->game.Id() == boss::SKYRIM &&
 	    boost::filesystem::exists(db->game.DataFolder() / "Update.esm") &&
-	    db->activePlugins.FindItem("Update.esm", boss::MOD) == size) {
-		db->activePlugins.Insert(size, boss::Item("Update.esm"));
+	    activePlugins.FindItem("Update.esm", boss::MOD) == size) {
+		activePlugins.Insert(size, boss::Item("Update.esm"));
 	}
 
 	// Now save plugins.txt.
 	boss::boss_error conversionStatus(BOSS_API_OK);  // An error object that will be set to BOSS_API_WARN_BAD_FILENAME if one occurs.
 	try {
-		db->activePlugins.SavePluginNames(db->game, db->game.ActivePluginsFile(), false, true);  // False to ensure newly-added plugins are actually added.
+		activePlugins.SavePluginNames(db->game, db->game.ActivePluginsFile(), false, true);  // False to ensure newly-added plugins are actually added.
 	} catch (boss::boss_error &e) {
-		if (e.getCode() == boss::BOSS_ERROR_ENCODING_CONVERSION_FAIL)
+		if (e.getCode() == boss::BOSS_ERROR_ENCODING_CONVERSION_FAIL) {
 			conversionStatus = e;
-		else
+		} else {
+			db->activePluginsMonitor.Invalidate();  // plugins.txt may have been partly written.
 			return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
+		}
 	}
 
 	// Now if running for textfile-based load order system, reorder plugins.txt, deriving the order from loadorder.txt.
 	if (db->game.GetLoadOrderMethod() == boss::LOMETHOD_TEXTFILE) {
 		// Now get the load order from loadorder.txt.
 		try {
-			if (GetLoadOrderMTime(db->game) != db->loadOrderMTime)
-				db->loadOrder.Load(db->game, db->game.DataFolder());
+			RefreshLoadOrder(db, guard);
 			// Save the load order and derive plugins.txt order from it.
 			db->loadOrder.SavePluginNames(db->game, db->game.LoadOrderFile(), false, false);
 			db->loadOrder.SavePluginNames(db->game, db->game.ActivePluginsFile(), true, true);
-			// Now update cached mtime.
-			db->loadOrderMTime = GetLoadOrderMTime(db->game);
+			// The load order in memory now matches what was written.
+			db->loadOrderMonitor.MarkUpToDate();
 		} catch (boss::boss_error &e) {
+			db->loadOrderMonitor.Invalidate();
+			db->activePluginsMonitor.Invalidate();
 			return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 		}
 	}
-	// Now update cached mtimes.
-	db->activePluginsMTime = GetActivePluginsMTime(db->game);
+	// The textfile-based system derived plugins.txt from the load order, so it
+	// needs re-reading, otherwise the active plugins in memory match what was written.
+	if (db->game.GetLoadOrderMethod() == boss::LOMETHOD_TEXTFILE) {
+		db->activePluginsMonitor.Invalidate();
+	} else {
+		db->activePlugins = activePlugins;
+		db->activePluginsMonitor.MarkUpToDate();
+	}
 
 	return ReturnCode(conversionStatus);
 }
@@ -1062,13 +1502,14 @@ BOSS_API uint32_t GetPluginLoadOrder(boss_db db, const uint8_t *plugin,
 	if (db == NULL || plugin == NULL || index == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);  // Made exclusive if the cache needs re-reading.
+
 	// Initialise vars.
 	*index = 0;
 
 	// Now get the load order.
 	try {
-		if (GetLoadOrderMTime(db->game) != db->loadOrderMTime)
-			db->loadOrder.Load(db->game, db->game.DataFolder());
+		RefreshLoadOrder(db, guard);
 	} catch (boss::boss_error &e) {
 		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 	}
@@ -1094,6 +1535,8 @@ BOSS_API uint32_t SetPluginLoadOrder(boss_db db, const uint8_t *plugin,
 	if (db == NULL || plugin == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, true);
+
 	std::string pluginStr = std::string(reinterpret_cast<const char *>(plugin));
 
 	// Check to see if the plugin is being set to the first position in the load order. Only the game master file should be set there.
@@ -1104,8 +1547,7 @@ BOSS_API uint32_t SetPluginLoadOrder(boss_db db, const uint8_t *plugin,
 
 	// Now get the current load order.
 	try {
-		if (GetLoadOrderMTime(db->game) != db->loadOrderMTime)
-			db->loadOrder.Load(db->game, db->game.DataFolder());
+		RefreshLoadOrder(db, guard);
 		// Check to see if the masters before plugins rule is being obeyed.
 		if (boss::Item(pluginStr).IsMasterFile(db->game) &&
 		    index > db->loadOrder.GetLastMasterPos(db->game) + 1)  // Sorting master after plugin, not allowed.
@@ -1117,26 +1559,33 @@ BOSS_API uint32_t SetPluginLoadOrder(boss_db db, const uint8_t *plugin,
 		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 	}
 
+	// Change a copy, so that the cached load order is only replaced once the
+	// change has been written.
+	boss::ItemList loadOrder = db->loadOrder;
+
 	// Now search for the given plugin.
-	size_t pos = db->loadOrder.FindItem(pluginStr, boss::MOD);
+	size_t pos = loadOrder.FindItem(pluginStr, boss::MOD);
 	if (pos == index)
 		return ReturnCode(BOSS_API_OK);
-	if (pos != db->loadOrder.Items().size())  // Plugin found. Erase it.
-		db->loadOrder.Erase(pos);
+	if (pos != loadOrder.Items().size())  // Plugin found. Erase it.
+		loadOrder.Erase(pos);
 
 	// Now insert the plugin into its new position.
-	if (index >= db->loadOrder.Items().size())
-		index = db->loadOrder.Items().size() - 1;
-	db->loadOrder.Insert(index, boss::Item(pluginStr));
+	if (index >= loadOrder.Items().size())
+		index = loadOrder.Items().size() - 1;
+	loadOrder.Insert(index, boss::Item(pluginStr));
 
 	if (db->game.GetLoadOrderMethod() == boss::LOMETHOD_TEXTFILE) {  // Skyrim.
 		// Now write out the new loadorder.txt. Also update the plugins.txt.
 		try {
-			db->loadOrder.SavePluginNames(db->game, db->game.LoadOrderFile(), false, false);
-			db->loadOrder.SavePluginNames(db->game, db->game.ActivePluginsFile(), true, true);
-			// Now update cached mtime.
-			db->activePluginsMTime = GetActivePluginsMTime(db->game);
+			loadOrder.SavePluginNames(db->game, db->game.LoadOrderFile(), false, false);
+			loadOrder.SavePluginNames(db->game, db->game.ActivePluginsFile(), true, true);
+			// plugins.txt was derived from the new load order, so re-read it when it's next needed.
+			db->activePluginsMonitor.Invalidate();
 		} catch (boss::boss_error &e) {
+			// Either file may have been written, so re-read both when they're next needed.
+			db->loadOrderMonitor.Invalidate();
+			db->activePluginsMonitor.Invalidate();
 			return ReturnCode(e);
 		}
 	} else {  // Non-skyrim. Scan data directory, and arrange plugins found in timestamp load order.
@@ -1160,7 +1609,7 @@ BOSS_API uint32_t SetPluginLoadOrder(boss_db db, const uint8_t *plugin,
 		}
 
 		// Now set the new timestamps.
-		std::vector<boss::Item> items = db->loadOrder.Items();
+		std::vector<boss::Item> items = loadOrder.Items();
 		size_t max = items.size();
 
 		if (index - pos >= max - 3 || pos - index >= max - 3) {  // Equivalent to abs(), which doesn't have size_t overloads.
@@ -1169,6 +1618,7 @@ BOSS_API uint32_t SetPluginLoadOrder(boss_db db, const uint8_t *plugin,
 					if (!items[i].IsGameMasterFile(db->game))
 						items[i].SetModTime(db->game, masterTime + i * 60);  // time_t is an integer number of seconds, so adding 60 on increases it by a minute.
 				} catch(boss::boss_error &e) {
+					db->loadOrderMonitor.Invalidate();  // Some plugins may have been redated.
 					return ReturnCode(e);
 				}
 			}
@@ -1193,6 +1643,7 @@ BOSS_API uint32_t SetPluginLoadOrder(boss_db db, const uint8_t *plugin,
 						if (!items[i].IsGameMasterFile(db->game))
 							items[i].SetModTime(db->game, startTime + (i - start) * deltaTime);  // time_t is an integer number of seconds, so adding 60 on increases it by a minute.
 					} catch(boss::boss_error &e) {
+						db->loadOrderMonitor.Invalidate();  // Some plugins may have been redated.
 						return ReturnCode(e);
 					}
 				}
@@ -1201,8 +1652,9 @@ BOSS_API uint32_t SetPluginLoadOrder(boss_db db, const uint8_t *plugin,
 			}
 		}
 	}
-	// Now update cached mtime.
-	db->loadOrderMTime = GetLoadOrderMTime(db->game);
+	// The load order in memory now matches what was written.
+	db->loadOrder = loadOrder;
+	db->loadOrderMonitor.MarkUpToDate();
 
 	return ReturnCode(BOSS_API_OK);
 }
@@ -1213,17 +1665,14 @@ BOSS_API uint32_t GetIndexedPlugin(boss_db db, const size_t index,
 	if (db == NULL || plugin == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);  // Made exclusive if the cache needs re-reading.
+
 	// Initialise vars.
 	*plugin = NULL;
 
-	// Free memory if already used.
-	delete[] db->extString;
-	db->extString = NULL;
-
 	// Now get the load order.
 	try {
-		if (GetLoadOrderMTime(db->game) != db->loadOrderMTime)
-			db->loadOrder.Load(db->game, db->game.DataFolder());
+		RefreshLoadOrder(db, guard);
 	} catch (boss::boss_error &e) {
 		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 	}
@@ -1232,16 +1681,13 @@ BOSS_API uint32_t GetIndexedPlugin(boss_db db, const size_t index,
 	if (index >= db->loadOrder.Items().size())
 		return ReturnCode(boss::boss_error(BOSS_API_ERROR_INVALID_ARGS, "Given index is larger than the index of the last plugin in the load order."));
 
-	// Allocate memory.
+	// Allocate memory and set outputs.
 	try {
-		db->extString = StringToUint8_tString(db->loadOrder.ItemAt(index).Name());
+		*plugin = StringToArena(db->ThreadOutputs().stringArena, db->loadOrder.ItemAt(index).Name());
 	} catch (std::bad_alloc /*&e*/) {
 		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
 	}
 
-	// Set outputs.
-	*plugin = db->extString;
-
 	return ReturnCode(BOSS_API_OK);
 }
 
@@ -1255,6 +1701,8 @@ BOSS_API uint32_t SetPluginActive(boss_db db, const uint8_t *plugin,
 	if (db == NULL || plugin == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, true);
+
 	// Catch Skyrim.esm and Update.esm for Skyrim.
 	std::string pluginStr = std::string(reinterpret_cast<const char *>(plugin));
 	if (db->game.Id() == boss::SKYRIM) {
@@ -1283,52 +1731,62 @@ BOSS_API uint32_t SetPluginActive(boss_db db, const uint8_t *plugin,
 
 	// Load plugins.txt.
 	try {
-		if (boost::filesystem::exists(db->game.ActivePluginsFile()) &&
-		    GetActivePluginsMTime(db->game) != db->activePluginsMTime)
-			db->activePlugins.Load(db->game, db->game.ActivePluginsFile());
+		RefreshActivePlugins(db, guard);
 	} catch (boss::boss_error &e) {
 		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 	}
 
+	// Change a copy, so that the cached active plugins are only replaced once
+	// plugins.txt has been written.
+	boss::ItemList activePlugins = db->activePlugins;
+
 	// If Update.esm is installed, check if it is listed. If not, add it (order is decided later).
-	size_t size = db->activePlugins.Items().size();
+	size_t size = activePlugins.Items().size();
 	if (db->game.Id() == boss::SKYRIM &&
 	    boost::filesystem::exists(db->game.DataFolder() / "Update.esm") &&
-	    db->activePlugins.FindItem("Update.esm", boss::MOD) == size) {
-		db->activePlugins.Insert(size, boss::Item("Update.esm"));
+	    activePlugins.FindItem("Update.esm", boss::MOD) == size) {
+		activePlugins.Insert(size, boss::Item("Update.esm"));
 	}
 
 	// Check if the given plugin is in plugins.txt.
-	if (db->activePlugins.FindItem(pluginStr, boss::MOD) != db->activePlugins.Items().size() && !active)  // Exists, but shouldn't.
-		db->activePlugins.Erase(db->activePlugins.FindItem(pluginStr, boss::MOD));
-	else if (db->activePlugins.FindItem(pluginStr, boss::MOD) == db->activePlugins.Items().size() && active)  // Doesn't exist, but should.
-		db->activePlugins.Insert(db->activePlugins.Items().size(), boss::Item(pluginStr));
+	if (activePlugins.FindItem(pluginStr, boss::MOD) != activePlugins.Items().size() && !active)  // Exists, but shouldn't.
+		activePlugins.Erase(activePlugins.FindItem(pluginStr, boss::MOD));
+	else if (activePlugins.FindItem(pluginStr, boss::MOD) == activePlugins.Items().size() && active)  // Doesn't exist, but should.
+		activePlugins.Insert(activePlugins.Items().size(), boss::Item(pluginStr));
 
 	// Check that there aren't too many plugins in plugins.txt.
-	if (db->activePlugins.Items().size() > 255)
+	if (activePlugins.Items().size() > 255)
 		return ReturnCode(boss::boss_error(BOSS_API_ERROR_PLUGINS_FULL));
 	else if (db->game.GetLoadOrderMethod() == boss::LOMETHOD_TEXTFILE &&
-	         db->activePlugins.Items().size() > 254)  // textfile-based system doesn't list Skyrim.esm in plugins.txt.
+	         activePlugins.Items().size() > 254)  // textfile-based system doesn't list Skyrim.esm in plugins.txt.
 		return ReturnCode(boss::boss_error(BOSS_API_ERROR_PLUGINS_FULL));
 
 	// Now save the change.
 	try {
-		db->activePlugins.SavePluginNames(db->game, db->game.ActivePluginsFile(), false, true);  // Must be false because we're not adding a currently active file, if we're adding something.
+		activePlugins.SavePluginNames(db->game, db->game.ActivePluginsFile(), false, true);  // Must be false because we're not adding a currently active file, if we're adding something.
 		if (db->game.GetLoadOrderMethod() == boss::LOMETHOD_TEXTFILE) {
 			// Now get the current load order.
-			if (GetLoadOrderMTime(db->game) != db->loadOrderMTime)
-				db->loadOrder.Load(db->game, db->game.DataFolder());
+			RefreshLoadOrder(db, guard);
 			// Save the load order and derive plugins.txt order from it.
 			db->loadOrder.SavePluginNames(db->game, db->game.LoadOrderFile(), false, false);
 			db->loadOrder.SavePluginNames(db->game, db->game.ActivePluginsFile(), true, true);
-			// Now update cached mtime.
-			db->loadOrderMTime = GetLoadOrderMTime(db->game);
+			// The load order in memory now matches what was written.
+			db->loadOrderMonitor.MarkUpToDate();
 		}
 	} catch (boss::boss_error &e) {
+		// Either file may have been written, so re-read both when they're next needed.
+		db->loadOrderMonitor.Invalidate();
+		db->activePluginsMonitor.Invalidate();
 		return ReturnCode(e);
 	}
-	// Now update cached mtimes.
-	db->activePluginsMTime = GetActivePluginsMTime(db->game);
+	// The textfile-based system derived plugins.txt from the load order, so it
+	// needs re-reading, otherwise the active plugins in memory match what was written.
+	if (db->game.GetLoadOrderMethod() == boss::LOMETHOD_TEXTFILE) {
+		db->activePluginsMonitor.Invalidate();
+	} else {
+		db->activePlugins = activePlugins;
+		db->activePluginsMonitor.MarkUpToDate();
+	}
 
 	return ReturnCode(BOSS_API_OK);
 }
@@ -1339,6 +1797,8 @@ BOSS_API uint32_t IsPluginActive(boss_db db, const uint8_t *plugin,
 	if (db == NULL || plugin == NULL || isActive == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);  // Made exclusive if the cache needs re-reading.
+
 	std::string pluginStr = std::string(reinterpret_cast<const char *>(plugin));
 
 	// Check if it's Skyrim, and Skyrim.esm/Update.esm, which are special cases.
@@ -1354,9 +1814,7 @@ BOSS_API uint32_t IsPluginActive(boss_db db, const uint8_t *plugin,
 	// Load plugins.txt. A hashset would be more efficient.
 	boss::ItemList pluginsList;
 	try {
-		if (boost::filesystem::exists(db->game.ActivePluginsFile()) &&
-		    GetActivePluginsMTime(db->game) != db->activePluginsMTime)
-			db->activePlugins.Load(db->game, db->game.ActivePluginsFile());
+		RefreshActivePlugins(db, guard);
 	} catch (boss::boss_error &e) {
 		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
 	}
@@ -1376,6 +1834,8 @@ BOSS_API uint32_t IsPluginMaster(boss_db db, const uint8_t *plugin,
 	if (db == NULL || plugin == NULL || isMaster == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);
+
 	*isMaster = boss::Item(std::string(reinterpret_cast<const char *>(plugin))).IsMasterFile(db->game);
 
 	return ReturnCode(BOSS_API_OK);
@@ -1394,12 +1854,13 @@ BOSS_API uint32_t GetBashTagMap(boss_db db, BashTag **tagMap,
 	if (db == NULL || tagMap == NULL || numTags == NULL)  // Check for valid args.
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
-	if (db->extTagMap != NULL) {  // Check to see if bashTagMap is already allocated. An empty bashTagMap is a valid option, if no tags exist.
+	boss::RWLockGuard guard(db->lock, false);
+	if (!db->tagMapBuilt)
+		guard.MakeExclusive();  // The map needs building.
+
+	if (db->tagMapBuilt) {  // Check to see if bashTagMap is already built. An empty bashTagMap is a valid option, if no tags exist.
 		*numTags = db->bashTagMap.size();  // Set size.
-		if (*numTags != 0)
-			*tagMap = db->extTagMap;
-		else
-			*tagMap = NULL;  // Don't return pointers to zero-length arrays, return NULL instead.
+		*tagMap = db->extTagMap;  // NULL if there are no tags: don't return pointers to zero-length arrays.
 	} else {
 		// Need to build internal Bash Tag map then feed it to the outside world.
 		// This involves iterating through all mods to get the tags they add and remove, in the masterlist and userlist.
@@ -1435,47 +1896,36 @@ BOSS_API uint32_t GetBashTagMap(boss_db db, BashTag **tagMap,
 		}
 		// Now tagsAdded and tagsRemoved each contain a list of unique tag strings.
 		// Time to combine. :D
-		uint32_t UID = 0;
+		db->bashTagMap.clear();
+		db->bashTagIds.clear();
 		std::unordered_set<std::string>::iterator tagStringIter;
-		for (tagStringIter = tagsAdded.begin(); tagStringIter != tagsAdded.end(); ++tagStringIter) {
-			if (db->FindBashTag(*tagStringIter) == db->bashTagMap.end()) {  // Tag not found in bashTagMap. Add it!
-				db->bashTagMap.insert(std::pair<uint32_t, std::string>(UID, *tagStringIter));
-				UID++;  // Now increment UID to keep it U.
-			}
-		}
-		for (tagStringIter = tagsRemoved.begin(); tagStringIter != tagsRemoved.end(); ++tagStringIter) {
-			if (db->FindBashTag(*tagStringIter) == db->bashTagMap.end()) {  // Tag not found in bashTagMap. Add it!
-				db->bashTagMap.insert(std::pair<uint32_t, std::string>(UID, *tagStringIter));
-				UID++;  // Now increment UID to keep it U.
-			}
-		}
-
-		// Check array size. Exit if zero. However, we need GetModBashTags to be able to tell if this function has been run or not.
-		// An empty bashTagMap and a null extTagMap are indistinguishable output from this function not being run at all.
-		// So allocate memory to a zero length array for extTagMap.
-		if (db->bashTagMap.empty()) {
-			try {
-				db->extTagMap = new BashTag[0];
-			} catch (std::bad_alloc /*&e*/) {
-				return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
-			}
-			return ReturnCode(BOSS_API_OK);
-		}
+		for (tagStringIter = tagsAdded.begin(); tagStringIter != tagsAdded.end(); ++tagStringIter)
+			db->AddBashTag(*tagStringIter);
+		for (tagStringIter = tagsRemoved.begin(); tagStringIter != tagsRemoved.end(); ++tagStringIter)
+			db->AddBashTag(*tagStringIter);
+		db->ClearPluginTags();  // They're held as UIDs, which may have changed.
 
 		// Now to convert for the outside world.
 		size_t mapSize = db->bashTagMap.size();  // Set size.
 
 		// Allocate memory, then loop through internal bashTagMap and fill output elements.
 		try {
-			db->extTagMap = new BashTag[mapSize];
+			size_t arenaSize = boss::Arena::SizeOf<BashTag>(mapSize);
+			for (size_t i = 0; i < mapSize; i++)
+				arenaSize += boss::Arena::SizeOf(db->bashTagMap[uint32_t(i)]);
+			db->tagMapArena.Reset(arenaSize);
+			db->extTagMap = db->tagMapArena.Allocate<BashTag>(mapSize);
 			for (size_t i = 0; i < mapSize; i++) {
 				uint32_t ii = uint32_t(i);
 				db->extTagMap[i].id = ii;
-				db->extTagMap[i].name = StringToUint8_tString(db->bashTagMap[ii]);
+				db->extTagMap[i].name = db->tagMapArena.CopyString(db->bashTagMap[ii]);
 			}
 		} catch (std::bad_alloc /*&e*/) {
+			db->bashTagMap.clear();
+			db->bashTagIds.clear();
 			return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
 		}
+		db->tagMapBuilt = true;  // GetModBashTags needs to be able to tell if this function has been run.
 
 		*tagMap = db->extTagMap;
 		*numTags = mapSize;
@@ -1485,11 +1935,11 @@ BOSS_API uint32_t GetBashTagMap(boss_db db, BashTag **tagMap,
 
 // Returns arrays of Bash Tag UIDs for Bash Tags suggested for addition and removal
 // by BOSS's masterlist and userlist, and the number of tags in each array.
-// The returned arrays are valid until the db is destroyed or until the Load
-// function is called.  The arrays should not be freed by the client. modName is
-// case-insensitive. If no Tags are found for an array, the array pointer (*tagIds)
-// will be NULL. The userlistModified bool is true if the userlist contains Bash Tag
-// suggestion message additions.
+// The returned arrays are valid until the db is destroyed or until the Load or
+// EvalConditionals functions are called. The arrays should not be freed by the
+// client. modName is case-insensitive. If no Tags are found for an array, the
+// array pointer (*tagIds) will be NULL. The userlistModified bool is true if the
+// userlist contains Bash Tag suggestion message additions.
 BOSS_API uint32_t GetModBashTags(boss_db db,
                                  const uint8_t *plugin,
                                  uint32_t **tagIds_added,
@@ -1503,6 +1953,8 @@ BOSS_API uint32_t GetModBashTags(boss_db db,
 	    tagIds_removed == NULL || tagIds_added == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);
+
 	// Convert modName.
 	std::string mod(reinterpret_cast<const char *>(plugin));
 
@@ -1516,84 +1968,31 @@ BOSS_API uint32_t GetModBashTags(boss_db db,
 	*tagIds_added = NULL;
 	*userlistModified = false;
 
-	if (db->extTagMap == NULL)
-		return ReturnCode(BOSS_API_ERROR_NO_TAG_MAP);
-
-	// Bash Tag temporary internal holders.
-	std::unordered_set<std::string> tagsAdded, tagsRemoved;
-
-	// Now search filtered masterlist for mod.
-	size_t pos = db->game.masterlist.FindItem(mod, boss::MOD);
-	if (pos != db->game.masterlist.Items().size()) {
-		std::vector<boss::Message> messages = db->game.masterlist.ItemAt(pos).Messages();
-		for (std::vector<boss::Message>::iterator messageIter = messages.begin(); messageIter != messages.end(); ++messageIter) {
-			if (messageIter->Key() == boss::TAG)
-				GetBashTagsFromString(messageIter->Data(), tagsAdded, tagsRemoved);
-		}
-	}
-
-	// Now search userlist for mod.
-	pos = db->game.userlist.FindRule(mod, true);
-	if (pos != db->game.userlist.Rules().size()) {
-		std::vector<boss::RuleLine> lines = db->game.userlist.RuleAt(pos).Lines();
-		for (std::vector<boss::RuleLine>::iterator lineIter = lines.begin(); lineIter != lines.end(); ++lineIter) {
-			if (lineIter->Key() == boss::REPLACE &&
-			   (!tagsAdded.empty() || !tagsRemoved.empty())) {
-				tagsAdded.clear();
-				tagsRemoved.clear();
-				*userlistModified = true;
-			}
-			if (lineIter->ObjectAsMessage().Key() == boss::TAG) {
-				GetBashTagsFromString(lineIter->Object(), tagsAdded, tagsRemoved);
-				*userlistModified = true;
-			}
-		}
-	}
-
-	// Now we convert strings to UIDs.
-	std::vector<uint32_t> tagsAddedUIDs, tagsRemovedUIDs;
-	std::unordered_set<std::string>::iterator tagStringIter;
-	for (tagStringIter = tagsAdded.begin(); tagStringIter != tagsAdded.end(); ++tagStringIter) {
-		std::map<uint32_t, std::string>::iterator mapPos = db->FindBashTag(*tagStringIter);
-		if (mapPos != db->bashTagMap.end())  // Tag found in bashTagMap. Get the UID.
-			tagsAddedUIDs.push_back(mapPos->first);
-	}
-	for (tagStringIter = tagsRemoved.begin(); tagStringIter != tagsRemoved.end(); ++tagStringIter) {
-		std::map<uint32_t, std::string>::iterator mapPos = db->FindBashTag(*tagStringIter);
-		if (mapPos != db->bashTagMap.end())  // Tag found in bashTagMap. Get the UID.
-			tagsRemovedUIDs.push_back(mapPos->first);
-	}
-	// Now set the sizes (we kept the two separate just in case some tags didn't have UIDs, which would change the size of the outputted array.
-	size_t numAdded = tagsAddedUIDs.size();
-	size_t numRemoved = tagsRemovedUIDs.size();
+	if (!db->pluginTagsBuilt)
+		guard.MakeExclusive();  // The plugins' tags need building.
 
-	// Free memory.
-	delete[] db->extAddedTagIds;
-	delete[] db->extRemovedTagIds;
-	db->extAddedTagIds = NULL;
-	db->extRemovedTagIds = NULL;
+	if (!db->tagMapBuilt)
+		return ReturnCode(BOSS_API_ERROR_NO_TAG_MAP);
 
-	// Allocate memory.
+	// Look the plugin up in the precomputed tags.
 	try {
-		if (numAdded != 0) {
-			db->extAddedTagIds = new uint32_t[numAdded];
-			for (size_t i = 0; i < numAdded; i++)
-				db->extAddedTagIds[i] = tagsAddedUIDs[i];
-		}
-		if (numRemoved != 0) {
-			db->extRemovedTagIds = new uint32_t[numRemoved];
-			for (size_t i = 0; i < numRemoved; i++)
-				db->extRemovedTagIds[i] = tagsRemovedUIDs[i];
-		}
+		BuildPluginTags(db);
 	} catch (std::bad_alloc /*&e*/) {
 		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
 	}
+	std::unordered_map<std::string, _boss_db_int::PluginTags>::const_iterator tagsPos = db->pluginTags.find(boost::to_lower_copy(mod));
+	if (tagsPos == db->pluginTags.end())
+		return ReturnCode(BOSS_API_OK);
 
-	// Set outputs.
-	*tagIds_added = db->extAddedTagIds;
-	*tagIds_removed = db->extRemovedTagIds;
-	*numTags_added = numAdded;
-	*numTags_removed = numRemoved;
+	// Set outputs. Don't return pointers to zero-length arrays.
+	const _boss_db_int::PluginTags &tags = tagsPos->second;
+	if (!tags.added.empty())
+		*tagIds_added = const_cast<uint32_t *>(&tags.added[0]);
+	if (!tags.removed.empty())
+		*tagIds_removed = const_cast<uint32_t *>(&tags.removed[0]);
+	*numTags_added = tags.added.size();
+	*numTags_removed = tags.removed.size();
+	*userlistModified = tags.userlistModified;
 
 	return ReturnCode(BOSS_API_OK);
 }
@@ -1613,6 +2012,8 @@ BOSS_API uint32_t GetDirtyMessage(boss_db db, const uint8_t *plugin,
 	    needsCleaning == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);
+
 	// Convert modName.
 	std::string mod(reinterpret_cast<const char *>(plugin));
 
@@ -1630,11 +2031,10 @@ BOSS_API uint32_t GetDirtyMessage(boss_db db, const uint8_t *plugin,
 		for (std::vector<boss::Message>::iterator messageIter = messages.begin(); messageIter != messages.end(); ++messageIter) {
 			if (messageIter->Key() == boss::DIRTY) {
 				try {
-					db->extString = StringToUint8_tString(messageIter->Data());
+					*message = StringToArena(db->ThreadOutputs().stringArena, messageIter->Data());
 				} catch (std::bad_alloc /*&e*/) {
 					return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
 				}
-				*message = db->extString;
 
 				if (messageIter->Data().find("Do not clean.") != std::string::npos)  // Mod should not be cleaned.
 					*needsCleaning = BOSS_API_CLEAN_NO;
@@ -1660,6 +2060,8 @@ BOSS_API uint32_t GetPluginMessages(boss_db db,
 	    numMessages == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);
+
 	// Convert modName.
 	std::string mod(reinterpret_cast<const char *>(plugin));
 
@@ -1670,15 +2072,6 @@ BOSS_API uint32_t GetPluginMessages(boss_db db,
 	*messages = NULL;
 	*numMessages = 0;
 
-	// Clear previously allocated memory.
-	if (db->extMessageArray != NULL) {
-		for (size_t i = 0; i < db->extMessageArraySize; i++)
-			delete[] db->extMessageArray[i].message;  // Gotta clear those allocated strings.
-		delete[] db->extMessageArray;
-		db->extMessageArray = NULL;
-		db->extMessageArraySize = 0;
-	}
-
 	// Now search filtered masterlist for mod.
 	std::vector<boss::Message> modMessages;
 	size_t pos = db->game.masterlist.FindItem(mod, boss::MOD);
@@ -1688,20 +2081,26 @@ BOSS_API uint32_t GetPluginMessages(boss_db db,
 	if (modMessages.empty())
 		return ReturnCode(BOSS_API_OK);
 
-	// Allocate memory, then loop through internal bashTagMap and fill output elements.
-	db->extMessageArraySize = modMessages.size();
+	// Allocate memory, then loop through the messages and fill output elements.
+	size_t numModMessages = modMessages.size();
+	BossMessage *messageArray;
 	try {
-		db->extMessageArray = new BossMessage[db->extMessageArraySize];
-		for (size_t i = 0; i < db->extMessageArraySize; i++) {
-			db->extMessageArray[i].type = modMessages[i].Key();
-			db->extMessageArray[i].message = StringToUint8_tString(modMessages[i].Data());
+		size_t arenaSize = boss::Arena::SizeOf<BossMessage>(numModMessages);
+		for (size_t i = 0; i < numModMessages; i++)
+			arenaSize += boss::Arena::SizeOf(modMessages[i].Data());
+		boss::Arena &messageArena = db->ThreadOutputs().messageArena;
+		messageArena.Reset(arenaSize);
+		messageArray = messageArena.Allocate<BossMessage>(numModMessages);
+		for (size_t i = 0; i < numModMessages; i++) {
+			messageArray[i].type = modMessages[i].Key();
+			messageArray[i].message = messageArena.CopyString(modMessages[i].Data());
 		}
 	} catch (std::bad_alloc /*&e*/) {
 		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
 	}
 
-	*messages = db->extMessageArray;
-	*numMessages = db->extMessageArraySize;
+	*messages = messageArray;
+	*numMessages = numModMessages;
 
 	return ReturnCode(BOSS_API_OK);
 }
@@ -1712,6 +2111,8 @@ BOSS_API uint32_t IsRecognised(boss_db db, const uint8_t * plugin,
 	if (db == NULL || plugin == NULL || recognised == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);
+
 	// Search filtered masterlist.
 	if (db->game.masterlist.FindItem(std::string(reinterpret_cast<const char *>(plugin)), boss::MOD) != db->game.masterlist.Items().size())
 		*recognised = true;
@@ -1721,6 +2122,220 @@ BOSS_API uint32_t IsRecognised(boss_db db, const uint8_t * plugin,
 	return ReturnCode(BOSS_API_OK);
 }
 
+// Outputs the requested fields for each of the given plugins in one block. The
+// masterlist, userlist, Bash Tag map and active plugins are each indexed once,
+// so that each plugin is then looked up in constant time.
+BOSS_API uint32_t GetPluginsMetadata(boss_db db, uint8_t **plugins,
+                                     const size_t numPlugins,
+                                     const uint32_t fields,
+                                     PluginMetadata **metadata) {
+	// Check for valid args.
+	if (db == NULL || metadata == NULL || (plugins == NULL && numPlugins != 0))
+		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+	if ((fields & ~BOSS_API_PLUGIN_ALL) != 0)
+		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Invalid fields requested.");
+
+	*metadata = NULL;
+
+	if (numPlugins == 0)
+		return ReturnCode(BOSS_API_OK);
+
+	// Reading plugins.txt and building the plugins' tags change the db, so the
+	// lock is made exclusive if either needs doing. Both happen before anything
+	// is read from the db, as others may change it while the lock is swapped.
+	boss::RWLockGuard guard(db->lock, false);
+	if ((fields & BOSS_API_PLUGIN_BASH_TAGS) != 0 && !db->pluginTagsBuilt)
+		guard.MakeExclusive();
+	if ((fields & BOSS_API_PLUGIN_ACTIVE) != 0) {
+		try {
+			RefreshActivePlugins(db, guard);
+		} catch (boss::boss_error &e) {
+			return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
+		}
+	}
+
+	if ((fields & BOSS_API_PLUGIN_BASH_TAGS) != 0 && !db->tagMapBuilt)
+		return ReturnCode(BOSS_API_ERROR_NO_TAG_MAP);
+
+	PROFILE_SCOPE("GetPluginsMetadata");
+
+	// Everything about a plugin, held until the output block can be sized.
+	struct PluginRecord {
+		std::string name;
+		std::vector<boss::Message> messages;
+		std::vector<uint32_t> tagsAdded;
+		std::vector<uint32_t> tagsRemoved;
+		bool userlistModified;
+		bool hasDirtyMessage;
+		std::string dirtyMessage;
+		uint32_t needsCleaning;
+		bool recognised;
+		bool active;
+		bool master;
+	};
+	std::vector<PluginRecord> records(numPlugins);
+
+	try {
+		// Index the masterlist's mods by lowercased name. The first of any duplicates
+		// is kept, to match ItemList::FindItem.
+		std::vector<boss::Item> items = db->game.masterlist.Items();
+		std::unordered_map<std::string, size_t> itemIndex;
+		if ((fields & (BOSS_API_PLUGIN_MESSAGES | BOSS_API_PLUGIN_BASH_TAGS |
+		               BOSS_API_PLUGIN_DIRTY | BOSS_API_PLUGIN_RECOGNISED)) != 0) {
+			itemIndex.reserve(items.size());
+			for (size_t i = 0, max = items.size(); i < max; i++) {
+				if (items[i].Type() == boss::MOD)
+					itemIndex.insert(std::make_pair(boost::to_lower_copy(items[i].Name()), i));
+			}
+		}
+
+		// Every plugin's Bash Tags are precomputed together.
+		if ((fields & BOSS_API_PLUGIN_BASH_TAGS) != 0)
+			BuildPluginTags(db);
+
+		// Load plugins.txt once into a hashset of lowercased names.
+		std::unordered_set<std::string> activeIndex;
+		if ((fields & BOSS_API_PLUGIN_ACTIVE) != 0) {
+			std::vector<boss::Item> activeItems = db->activePlugins.Items();
+			for (size_t i = 0, max = activeItems.size(); i < max; i++) {
+				if (activeItems[i].Type() == boss::MOD)
+					activeIndex.insert(boost::to_lower_copy(activeItems[i].Name()));
+			}
+			if (db->game.Id() == boss::SKYRIM) {
+				activeIndex.insert("skyrim.esm");
+				if (boost::filesystem::exists(db->game.DataFolder() / "Update.esm"))
+					activeIndex.insert("update.esm");
+			}
+		}
+
+		for (size_t i = 0; i < numPlugins; i++) {
+			if (plugins[i] == NULL)
+				return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+			PluginRecord &record = records[i];
+			record.name = reinterpret_cast<const char *>(plugins[i]);
+			if (record.name.empty())
+				return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Plugin name is empty.");
+			std::string key = boost::to_lower_copy(record.name);
+			record.userlistModified = false;
+			record.hasDirtyMessage = false;
+			// Zeroed like the other unrequested fields if dirty info wasn't asked for.
+			record.needsCleaning = (fields & BOSS_API_PLUGIN_DIRTY) != 0 ? BOSS_API_CLEAN_UNKNOWN : 0;
+
+			// Masterlist fields.
+			std::unordered_map<std::string, size_t>::const_iterator itemPos = itemIndex.find(key);
+			record.recognised = (fields & BOSS_API_PLUGIN_RECOGNISED) != 0 &&
+			                    itemPos != itemIndex.end();
+			if (itemPos != itemIndex.end()) {
+				std::vector<boss::Message> messages = items[itemPos->second].Messages();
+				for (std::vector<boss::Message>::iterator messageIter = messages.begin(); messageIter != messages.end(); ++messageIter) {
+					if ((fields & BOSS_API_PLUGIN_DIRTY) != 0 &&
+					    messageIter->Key() == boss::DIRTY &&
+					    !record.hasDirtyMessage) {
+						record.hasDirtyMessage = true;
+						record.dirtyMessage = messageIter->Data();
+						if (record.dirtyMessage.find("Do not clean.") != std::string::npos)  // Mod should not be cleaned.
+							record.needsCleaning = BOSS_API_CLEAN_NO;
+						else  // Mod should be cleaned.
+							record.needsCleaning = BOSS_API_CLEAN_YES;
+					}
+				}
+				if ((fields & BOSS_API_PLUGIN_MESSAGES) != 0)
+					record.messages.swap(messages);
+			}
+
+			if ((fields & BOSS_API_PLUGIN_BASH_TAGS) != 0) {
+				std::unordered_map<std::string, _boss_db_int::PluginTags>::const_iterator tagsPos = db->pluginTags.find(key);
+				if (tagsPos != db->pluginTags.end()) {
+					record.tagsAdded = tagsPos->second.added;
+					record.tagsRemoved = tagsPos->second.removed;
+					record.userlistModified = tagsPos->second.userlistModified;
+				}
+			}
+
+			record.active = (fields & BOSS_API_PLUGIN_ACTIVE) != 0 &&
+			                activeIndex.find(key) != activeIndex.end();
+			record.master = (fields & BOSS_API_PLUGIN_MASTER) != 0 &&
+			                boss::Item(record.name).IsMasterFile(db->game);
+		}
+	} catch (boss::boss_error &e) {
+		return ReturnCode(e);  // BOSS_ERRORs map directly to BOSS_API_ERRORs.
+	} catch (std::bad_alloc /*&e*/) {
+		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
+	}
+
+	// Size the block. It holds the structure array, then all the message arrays,
+	// then all the tag UID arrays, then all the string bytes. Each section's size
+	// is a multiple of the next section's alignment, so no padding is needed.
+	size_t numMessages = 0, numTags = 0, numBytes = 0;
+	for (size_t i = 0; i < numPlugins; i++) {
+		numMessages += records[i].messages.size();
+		numTags += records[i].tagsAdded.size() + records[i].tagsRemoved.size();
+		numBytes += records[i].name.length() + 1;
+		for (size_t j = 0, max = records[i].messages.size(); j < max; j++)
+			numBytes += records[i].messages[j].Data().length() + 1;
+		if (records[i].hasDirtyMessage)
+			numBytes += records[i].dirtyMessage.length() + 1;
+	}
+	uint8_t *block;
+	try {
+		block = new uint8_t[sizeof(PluginMetadata) * numPlugins +
+		                    sizeof(BossMessage) * numMessages +
+		                    sizeof(uint32_t) * numTags + numBytes];
+	} catch (std::bad_alloc /*&e*/) {
+		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
+	}
+	PluginMetadata *outMetadata = reinterpret_cast<PluginMetadata *>(block);
+	BossMessage *outMessages = reinterpret_cast<BossMessage *>(outMetadata + numPlugins);
+	uint32_t *outTags = reinterpret_cast<uint32_t *>(outMessages + numMessages);
+	uint8_t *outBytes = reinterpret_cast<uint8_t *>(outTags + numTags);
+
+	// Copies a string into the block and returns where it was put.
+	auto copyString = [&outBytes](const std::string &str) -> const uint8_t * {
+		uint8_t *start = outBytes;
+		std::copy(str.begin(), str.end(), start);
+		start[str.length()] = '\0';
+		outBytes += str.length() + 1;
+		return start;
+	};
+
+	for (size_t i = 0; i < numPlugins; i++) {
+		const PluginRecord &record = records[i];
+		PluginMetadata &out = outMetadata[i];
+		out.name = copyString(record.name);
+
+		out.numMessages = record.messages.size();
+		out.messages = out.numMessages != 0 ? outMessages : NULL;  // Don't return pointers to zero-length arrays.
+		for (size_t j = 0; j < out.numMessages; j++, outMessages++) {
+			outMessages->type = record.messages[j].Key();
+			outMessages->message = copyString(record.messages[j].Data());
+		}
+
+		out.numTags_added = record.tagsAdded.size();
+		out.tagIds_added = out.numTags_added != 0 ? outTags : NULL;
+		outTags = std::copy(record.tagsAdded.begin(), record.tagsAdded.end(), outTags);
+		out.numTags_removed = record.tagsRemoved.size();
+		out.tagIds_removed = out.numTags_removed != 0 ? outTags : NULL;
+		outTags = std::copy(record.tagsRemoved.begin(), record.tagsRemoved.end(), outTags);
+		out.userlistModified = record.userlistModified;
+
+		out.dirtyMessage = record.hasDirtyMessage ? copyString(record.dirtyMessage) : NULL;
+		out.needsCleaning = record.needsCleaning;
+
+		out.isRecognised = record.recognised;
+		out.isActive = record.active;
+		out.isMaster = record.master;
+	}
+
+	*metadata = outMetadata;
+	return ReturnCode(BOSS_API_OK);
+}
+
+// Frees an array output by GetPluginsMetadata. Everything it points to is in the
+// same block.
+BOSS_API void FreePluginsMetadata(PluginMetadata *metadata) {
+	delete[] reinterpret_cast<uint8_t *>(metadata);
+}
+
 // Writes a minimal masterlist that only contains mods that have Bash Tag suggestions,
 // and/or dirty messages, plus the Tag suggestions and/or messages themselves and their
 // conditions, in order to create the Wrye Bash taglist. outputFile is the path to use
@@ -1731,6 +2346,8 @@ BOSS_API uint32_t DumpMinimal(boss_db db, const uint8_t *outputFile,
 	if (db == NULL || outputFile == NULL)
 		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
 
+	boss::RWLockGuard guard(db->lock, false);
+
 	std::string path(reinterpret_cast<const char *>(outputFile));
 	if (!boost::filesystem::exists(path) || overwrite) {
 		boss::boss_fstream::ofstream mlist(path.c_str());
@@ -1771,3 +2388,34 @@ BOSS_API uint32_t DumpMinimal(boss_db db, const uint8_t *outputFile,
 		return ReturnCode(boss::boss_error(BOSS_API_ERROR_FILE_WRITE_FAIL, path));
 	}
 }
+
+// Outputs a JSON object giving the time taken by each stage of the work done since
+// Load was last called on any db, and counts of the work done in them. The
+// profiler is process-wide, so this includes every db's work.
+BOSS_API uint32_t GetProfileData(boss_db db, uint8_t **profile) {
+	if (db == NULL || profile == NULL)  // Check for valid args.
+		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+	boss::RWLockGuard guard(db->lock, false);
+
+	try {
+		*profile = StringToArena(db->ThreadOutputs().profileArena, boss::g_profiler.AsJSON());
+	} catch (std::bad_alloc /*&e*/) {
+		return ReturnCode(boss::boss_error(boss::BOSS_ERROR_NO_MEM));
+	}
+	return ReturnCode(BOSS_API_OK);
+}
+
+// Outputs how many times the load order and active plugins were answered from
+// memory, and how many times they had to be re-read from disk.
+BOSS_API uint32_t GetCacheStats(boss_db db, size_t *hits, size_t *misses) {
+	if (db == NULL || hits == NULL || misses == NULL)  // Check for valid args.
+		return ReturnCode(BOSS_API_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+	boss::RWLockGuard guard(db->lock, false);
+
+	*hits = db->cacheHits;
+	*misses = db->cacheMisses;
+
+	return ReturnCode(BOSS_API_OK);
+}
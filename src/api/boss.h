@@ -71,11 +71,27 @@ extern "C" {
 // by the API should not have their memory freed by the client: the API will
 // clean up after itself.
 // All API numbers and error codes are uint32_t integers.
+// The API can be used from several threads at once, including on the same db.
+// Calls that only read a db run concurrently, while calls that change it wait
+// for each other. Where an output is said to be valid until a function is next
+// called, it means called on the same db by the same thread.
 
 // Abstracts the definition of BOSS's internal state while still providing
 // type safety across the API.
 typedef struct _boss_db_int *boss_db;
 
+// Abstracts a sort started by SortModsAsync, which is its completion handle.
+typedef struct _boss_sort_int *boss_sort;
+
+// Called from the worker thread of a sort started by SortModsAsync. phase is
+// one of the BOSS_API_SORT_PHASE_* values. During the
+// BOSS_API_SORT_PHASE_APPLY_ORDER phase, done and total count the plugins the
+// order has been applied to, otherwise they are both 0. The worker holds the
+// db while it calls this, so the callback must not use the db or the sort's
+// handle, other than to call CancelSort.
+typedef void (*BossSortProgress)(uint32_t phase, size_t done, size_t total,
+                                 void *userData);
+
 // BashTag structure gives the Unique ID number (UID) for each Bash Tag and
 // the corresponding Tag name string.
 typedef struct {
@@ -89,6 +105,33 @@ typedef struct {
 	const uint8_t *message;
 } BossMessage;
 
+// PluginMetadata structure gives everything the DB knows about a plugin, as
+// output by GetPluginsMetadata. Members for fields that weren't requested are
+// zeroed. All the pointers point into the block that holds the structure array.
+typedef struct {
+	const uint8_t *name;
+	const BossMessage *messages;  // As given by GetPluginMessages.
+	size_t numMessages;
+	const uint32_t *tagIds_added;  // As given by GetModBashTags.
+	size_t numTags_added;
+	const uint32_t *tagIds_removed;
+	size_t numTags_removed;
+	bool userlistModified;
+	const uint8_t *dirtyMessage;  // As given by GetDirtyMessage.
+	uint32_t needsCleaning;  // 0 if dirty info wasn't requested, which is also BOSS_API_CLEAN_NO.
+	bool isRecognised;
+	bool isActive;
+	bool isMaster;
+} PluginMetadata;
+
+// MasterlistUpdateResult structure gives the outcome of updating one DB's
+// masterlist, as output by UpdateMasterlists.
+typedef struct {
+	uint32_t returnCode;  // What UpdateMasterlist would have returned.
+	const uint8_t *revision;  // The revision updated to, or NULL if the update failed.
+	const uint8_t *errorDetails;  // As GetLastErrorDetails would give, or NULL if the update succeeded.
+} MasterlistUpdateResult;
+
 // The following are the possible codes that the API can return.
 BOSS_API extern const uint32_t BOSS_API_OK;  ///< The function completed successfully.
 BOSS_API extern const uint32_t BOSS_API_ERROR_FILE_WRITE_FAIL;  ///< A file could not be written to.
@@ -114,6 +157,7 @@ BOSS_API extern const uint32_t BOSS_API_ERROR_PLUGINS_FULL;  ///< Writing the sp
 BOSS_API extern const uint32_t BOSS_API_ERROR_PLUGIN_BEFORE_MASTER;
 BOSS_API extern const uint32_t BOSS_API_ERROR_INVALID_SYNTAX;
 BOSS_API extern const uint32_t BOSS_API_ERROR_GIT_ERROR;
+BOSS_API extern const uint32_t BOSS_API_ERROR_CANCELLED;  ///< The operation was cancelled by the client.
 BOSS_API extern const uint32_t BOSS_API_RETURN_MAX;  ///< Matches the value of the highest-numbered return code. It isn't returned by any functions.
 
 // The following are the mod cleanliness states that the API can return.
@@ -142,6 +186,23 @@ BOSS_API extern const uint32_t BOSS_API_MESSAGE_DIRTY;  ///< A message about dir
 BOSS_API extern const uint32_t BOSS_API_MESSAGE_WARN;  ///< A warning message.
 BOSS_API extern const uint32_t BOSS_API_MESSAGE_ERROR;  ///< An error message.
 
+// The following are the fields that GetPluginsMetadata can fill in. They can be combined.
+BOSS_API extern const uint32_t BOSS_API_PLUGIN_MESSAGES;  ///< The plugin's masterlist messages.
+BOSS_API extern const uint32_t BOSS_API_PLUGIN_BASH_TAGS;  ///< The plugin's Bash Tag suggestions. GetBashTagMap must be run first.
+BOSS_API extern const uint32_t BOSS_API_PLUGIN_DIRTY;  ///< The plugin's dirty message and whether it needs cleaning.
+BOSS_API extern const uint32_t BOSS_API_PLUGIN_RECOGNISED;  ///< Whether the plugin is in the masterlist.
+BOSS_API extern const uint32_t BOSS_API_PLUGIN_ACTIVE;  ///< Whether the plugin is active.
+BOSS_API extern const uint32_t BOSS_API_PLUGIN_MASTER;  ///< Whether the plugin is a master. This reads the plugin's header.
+BOSS_API extern const uint32_t BOSS_API_PLUGIN_ALL;  ///< All of the above.
+
+// The following are the phases that SortModsAsync reports the progress of, in order.
+BOSS_API extern const uint32_t BOSS_API_SORT_PHASE_LOAD_PLUGINS;  ///< The plugins in the data path are being read.
+BOSS_API extern const uint32_t BOSS_API_SORT_PHASE_FILTER_MASTERLIST;  ///< The masterlist's conditionals and regular expressions are being evaluated.
+BOSS_API extern const uint32_t BOSS_API_SORT_PHASE_APPLY_MASTERLIST;  ///< The plugins are being ordered by the masterlist.
+BOSS_API extern const uint32_t BOSS_API_SORT_PHASE_APPLY_USERLIST;  ///< The userlist's rules are being applied.
+BOSS_API extern const uint32_t BOSS_API_SORT_PHASE_APPLY_ORDER;  ///< The plugins are being redated, or loadorder.txt and plugins.txt written.
+BOSS_API extern const uint32_t BOSS_API_SORT_PHASE_FINISHED;  ///< The sort has ended, successfully or not, and FinishSort will not wait.
+
 
 
 //////////////////////////////
@@ -149,8 +210,9 @@ BOSS_API extern const uint32_t BOSS_API_MESSAGE_ERROR;  ///< An error message.
 //////////////////////////////
 
 // Outputs a string giving the details of the last time an error or
-// warning return code was returned by a function. The string exists
-// until this function is called again or until CleanUpAPI is called.
+// warning return code was returned by a function called from this thread.
+// The string exists until this function is called again or until CleanUpAPI
+// is called by this thread.
 BOSS_API uint32_t GetLastErrorDetails(uint8_t **details);
 
 
@@ -165,8 +227,7 @@ BOSS_API bool IsCompatibleVersion(const uint32_t bossVersionMajor,
                                   const uint32_t bossVersionPatch);
 
 // Returns the version string for this version of BOSS.
-// The string exists until this function is called again or until
-// CleanUpAPI is called.
+// The string exists for the lifetime of the library.
 BOSS_API uint32_t GetVersionString(uint8_t **bossVersionStr);
 
 
@@ -185,9 +246,16 @@ BOSS_API uint32_t CreateBossDb(boss_db *db, const uint32_t clientGame,
                                             const uint8_t *gamePath);
 
 // Destroys the given DB, freeing any memory allocated as part of its use.
+// If the BOSS_TRACE environment variable was set to a file path when the first
+// DB was created, the trace events recorded since the last DB was destroyed are
+// added to that file, which holds all of the process's events so far.
 BOSS_API void DestroyBossDb(boss_db db);
 
-// Frees memory allocated to version and error strings.
+// Frees memory allocated to the calling thread's error string. Its outputs from
+// DBs are freed the next time a DB gives any thread new outputs, as they are
+// once a thread has exited, so they shouldn't be used after this is called.
+// Also stops the library's background log writer, so this should be called
+// before the library is unloaded. The API can still be used afterwards.
 BOSS_API void CleanUpAPI();
 
 
@@ -218,9 +286,19 @@ BOSS_API uint32_t EvalConditionals(boss_db db);
 // Checks if there is a masterlist at masterlistPath. If not,
 // it downloads the latest masterlist for the DB's game to masterlistPath.
 // If there is, it first compares online and local versions to see if an
-// update is necessary.
+// update is necessary. The updated masterlist is then parsed in the
+// background, so that Load can use it straight away.
 BOSS_API uint32_t UpdateMasterlist(boss_db db, const uint8_t *masterlistPath);
 
+// Updates the masterlists of the given DBs at once, each on its own thread,
+// rather than one after another. The DBs must be different and be for games
+// with different masterlist folders. Outputs the outcome for each DB in the
+// order given, which is valid until this function is next called with the same
+// first DB, or until that DB is destroyed. Returns BOSS_API_OK if every update
+// was attempted, even if some failed.
+BOSS_API uint32_t UpdateMasterlists(boss_db *dbs, const size_t numDbs,
+                                    MasterlistUpdateResult **results);
+
 
 ////////////////////////////////
 // Plugin Sorting Functions
@@ -247,6 +325,41 @@ BOSS_API uint32_t SortMods(boss_db db,
                            uint8_t ***unrecognisedPlugins,
                            size_t *unrecListLength);
 
+/*
+ * Starts sorting the mods in the data path as SortMods does, but on a worker
+ * thread, and outputs a handle for the sort. If progress is not NULL, it is
+ * called with userData at the start of each phase and after each batch of
+ * plugins the order is applied to. Calls on the same db wait until the sort
+ * has finished. The handle must be destroyed with DestroySort before the db is.
+ */
+BOSS_API uint32_t SortModsAsync(boss_db db,
+                                const bool trialOnly,
+                                BossSortProgress progress,
+                                void *userData,
+                                boss_sort *sort);
+
+// Asks the given sort to stop. The sort stops before its next phase or batch
+// of plugins and FinishSort then returns BOSS_API_ERROR_CANCELLED. Plugins
+// that have already been redated keep their new timestamps, but loadorder.txt
+// and plugins.txt are only written once every plugin has been ordered.
+BOSS_API uint32_t CancelSort(boss_sort sort);
+
+// Outputs whether the given sort has finished, without waiting for it.
+BOSS_API uint32_t IsSortFinished(boss_sort sort, bool *finished);
+
+// Waits for the given sort to finish, then returns what SortMods would have
+// returned and outputs the same lists. The lists are valid until DestroySort is
+// called, and the output pointers can be null if they are not needed.
+BOSS_API uint32_t FinishSort(boss_sort sort,
+                             uint8_t ***sortedPlugins,
+                             size_t *sortedListLength,
+                             uint8_t ***unrecognisedPlugins,
+                             size_t *unrecListLength);
+
+// Destroys the given sort, waiting for it to finish if it hasn't. Call
+// CancelSort first to avoid waiting for the whole sort.
+BOSS_API void DestroySort(boss_sort sort);
+
 // Outputs a list of the plugins installed in the data path specified when the DB was
 // created in load order, with the number of plugins given by numPlugins.
 BOSS_API uint32_t GetLoadOrder(boss_db db, uint8_t ***plugins,
@@ -308,11 +421,11 @@ BOSS_API uint32_t GetBashTagMap(boss_db db, BashTag **tagMap, size_t *numTags);
 
 // Returns arrays of Bash Tag UIDs for Bash Tags suggested for addition and removal
 // by BOSS's masterlist and userlist, and the number of tags in each array.
-// The returned arrays are valid until the db is destroyed or until the Load
-// function is called.  The arrays should not be freed by the client. modName is
-// case-insensitive. If no Tags are found for an array, the array pointer (*tagIds)
-// will be NULL. The userlistModified bool is true if the userlist contains Bash Tag
-// suggestion message additions.
+// The returned arrays are valid until the db is destroyed or until the Load or
+// EvalConditionals functions are called. The arrays should not be freed by the
+// client. modName is case-insensitive. If no Tags are found for an array, the
+// array pointer (*tagIds) will be NULL. The userlistModified bool is true if the
+// userlist contains Bash Tag suggestion message additions.
 BOSS_API uint32_t GetModBashTags(boss_db db,
                                  const uint8_t *plugin,
                                  uint32_t **tagIds_added,
@@ -342,6 +455,23 @@ BOSS_API uint32_t GetPluginMessages(boss_db db, const uint8_t *plugin,
 BOSS_API uint32_t IsRecognised(boss_db db, const uint8_t *plugin,
                                bool *recognised);
 
+// Outputs an array of numPlugins structures giving the requested fields for
+// each of the given plugins, in the same order. This is equivalent to calling
+// GetPluginMessages, GetModBashTags, GetDirtyMessage, IsRecognised, IsPluginActive
+// and IsPluginMaster for each plugin, but the masterlist, userlist and plugins.txt
+// are only looked through once. fields is a combination of the BOSS_API_PLUGIN_*
+// values. Plugin names are case-insensitive. Unlike other API outputs, the array
+// belongs to the client and stays valid until it is passed to FreePluginsMetadata.
+// If numPlugins is 0, *metadata will be NULL.
+BOSS_API uint32_t GetPluginsMetadata(boss_db db, uint8_t **plugins,
+                                     const size_t numPlugins,
+                                     const uint32_t fields,
+                                     PluginMetadata **metadata);
+
+// Frees an array output by GetPluginsMetadata, along with all the strings and
+// arrays it points to. NULL is ignored.
+BOSS_API void FreePluginsMetadata(PluginMetadata *metadata);
+
 // Writes a minimal masterlist that only contains mods that have Bash Tag suggestions,
 // and/or dirty messages, plus the Tag suggestions and/or messages themselves and their
 // conditions, in order to create the Wrye Bash taglist. outputFile is the path to use
@@ -349,6 +479,19 @@ BOSS_API uint32_t IsRecognised(boss_db db, const uint8_t *plugin,
 BOSS_API uint32_t DumpMinimal(boss_db db, const uint8_t *outputFile,
                               const bool overwrite);
 
+// Outputs a JSON object giving the time taken by each stage of the work done since
+// Load was last called, and counts of the files checked, plugin headers read, bytes
+// hashed, conditions evaluated, regexes compiled and user rules applied. The data is
+// process-wide, not per db: it covers the work done by every db on every thread, and
+// calling Load on any db clears it. The string is valid until the db is destroyed or
+// until GetProfileData is next called. The string should not be freed by the client.
+BOSS_API uint32_t GetProfileData(boss_db db, uint8_t **profile);
+
+// Outputs how many times the load order and active plugins have been answered from
+// memory (hits), and how many times they had to be re-read because plugins.txt,
+// loadorder.txt or the Data folder may have changed (misses), since the db was created.
+BOSS_API uint32_t GetCacheStats(boss_db db, size_t *hits, size_t *misses);
+
 
 #ifdef __cplusplus
 }
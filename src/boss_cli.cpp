@@ -32,10 +32,16 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <exception>
 #include <iostream>
 #include <locale>
+#include <map>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
@@ -48,13 +54,17 @@
 
 #include <git2.h>
 
+#include "base/fstream.h"
 #include "common/error.h"
 #include "common/game.h"
 #include "common/globals.h"
 #include "common/settings.h"
 #include "output/boss_log.h"
 #include "output/output.h"
+#include "support/change_monitor.h"
+#include "support/command_socket.h"
 #include "support/logger.h"
+#include "support/profiler.h"
 #include "updating/updater.h"
 
 // TODO(MCP): Split this up into its own wrapper file?
@@ -119,6 +129,28 @@ void Fail() {
 	std::exit(1);
 }
 
+// Prints the time spent in each phase and saves it next to the BOSS Log.
+// Also saves the trace events, if tracing is on, to tracePath or next to the BOSS Log.
+void ReportProfile(const Game &game, const std::string &tracePath) {
+	if (g_profiler.IsEnabled()) {
+		std::cout << std::endl << g_profiler.AsText() << std::endl;
+		try {
+			g_profiler.SaveJSON(game.Profile());
+		} catch (boss_error &e) {
+			LOG_ERROR("Error: could not save profile. Details: %s",
+			          e.getString().c_str());
+		}
+	}
+	if (g_tracer.IsEnabled()) {
+		try {
+			g_tracer.SaveJSON(tracePath.empty() ? game.Trace() : fs::path(tracePath));
+		} catch (boss_error &e) {
+			LOG_ERROR("Error: could not save trace. Details: %s",
+			          e.getString().c_str());
+		}
+	}
+}
+
 int progress(const git_transfer_progress *stats, void *payload) {
 	std::printf((bloc::translate("Downloading masterlist: %i of %i objects (%i KB)").str() + "\r").c_str(),
 	             stats->received_objects,
@@ -127,11 +159,524 @@ int progress(const git_transfer_progress *stats, void *payload) {
 	std::fflush(stdout);
 	return 0;
 }
+
+// Prints each game's progress in updating its masterlist on one line. data points to the games' names.
+void multiProgress(const std::vector<MasterlistProgress> &games, void *data) {
+	const std::vector<std::string> &names = *static_cast<std::vector<std::string> *>(data);
+	std::string line;
+	for (std::size_t i = 0, max = games.size(); i < max; i++) {
+		if (i > 0)
+			line += " | ";
+		if (games[i].finished)
+			line += (boost::format(bloc::translate("%1%: done")) % names[i]).str();
+		else
+			line += (boost::format(bloc::translate("%1%: %2% of %3% objects (%4% KB)")) % names[i]
+			         % games[i].receivedObjects % games[i].totalObjects % (games[i].receivedBytes / 1024)).str();
+	}
+	std::printf("%s\r", line.c_str());
+	std::fflush(stdout);
+}
+
+// How often --watch checks for changes, and how long things must stay
+// unchanged before it re-sorts, in milliseconds. Without change notifications,
+// checking reads every file in the Data folder, so it's done less often.
+// Commands are handled as soon as they arrive either way.
+const int WATCH_POLL_INTERVAL = 250;
+const int WATCH_FALLBACK_POLL_INTERVAL = 5000;
+const int WATCH_DEBOUNCE = 1000;
+
+// What --watch keeps between sorts.
+struct WatchState {
+	WatchState() : masterlistStale(true), userlistStale(true) {}
+
+	ItemList masterlist;  // As parsed, before its conditionals are evaluated.
+	RuleList userlist;    // Empty apart from its errors if it failed to parse.
+	bool masterlistStale;
+	bool userlistStale;
+};
+
+// Saves the BOSS Log to log with a critical error and returns a summary of the error.
+std::string SortFailed(Game &game, const fs::path &log, const boss_error &e) {
+	LOG_ERROR("Critical Error: %s", e.getString().c_str());
+	try {
+		game.bosslog.Save(log, true);
+	} catch (boss_error &e) {
+		LOG_ERROR("Critical Error: %s", e.getString().c_str());
+	}
+	return "error " + e.getString();
+}
+
+// Sorts using a masterlist and userlist that have already been parsed, saving
+// the modlist backups and the BOSS Log to the given paths. The BOSS Log should
+// already hold any updater output and parsing errors from before parsing the
+// masterlist. Returns a one-line summary.
+std::string SortParsed(Game &game, const ItemList &masterlist,
+                       const RuleList &userlist, const fs::path &modlist,
+                       const fs::path &oldModlist, const fs::path &log) {
+	try {
+		TRACE_SCOPE("Sort plugins");
+		game.modlist.Load(game, game.DataFolder());
+		game.modlist.Save(modlist, oldModlist);
+
+		game.masterlist = masterlist;
+		game.masterlist.EvalConditions(game);
+		game.masterlist.EvalRegex(game);
+		game.bosslog.globalMessages = game.masterlist.GlobalMessageBuffer();
+		game.bosslog.parsingErrors.push_back(game.masterlist.ErrorBuffer());
+
+		game.userlist = userlist;
+		std::vector<ParsingError> errs = game.userlist.ErrorBuffer();
+		game.bosslog.parsingErrors.insert(game.bosslog.parsingErrors.end(),
+		                                  errs.begin(), errs.end());
+
+		game.ApplyMasterlist();
+		game.ApplyUserlist();
+		game.ScanSEPlugins();
+		game.SortPlugins(gl_trial_run);
+		game.bosslog.Save(log, true);
+	} catch (boss_error &e) {
+		if (e.getCode() == BOSS_ERROR_CONDITION_EVAL_FAIL)
+			game.bosslog.criticalError << LIST_ITEM_CLASS_ERROR << e.getString();
+		else
+			game.bosslog.criticalError << LIST_ITEM_CLASS_ERROR << (boost::format(bloc::translate("Critical Error: %1%")) % e.getString()).str();
+		return SortFailed(game, log, e);
+	}
+
+	return (boost::format("ok recognised=%1% unrecognised=%2% warnings=%3% errors=%4% log=%5%")
+	        % game.bosslog.recognised % game.bosslog.unrecognised
+	        % game.bosslog.warnings % game.bosslog.errors % log.string()).str();
+}
+
+// Puts a masterlist parsing failure in the BOSS Log.
+void RecordMasterlistError(Game &game, const ItemList &masterlist,
+                           const boss_error &e) {
+	if (e.getCode() == BOSS_ERROR_FILE_PARSE_FAIL)
+		game.bosslog.criticalError << masterlist.ErrorBuffer();
+	else
+		game.bosslog.criticalError << LIST_ITEM_CLASS_ERROR << (boost::format(bloc::translate("Critical Error: %1%")) % e.getString()).str();
+}
+
+// Parses a userlist, leaving it empty apart from its errors if it has any.
+void LoadUserlist(const Game &game, const fs::path &file, RuleList &userlist) {
+	TRACE_SCOPE("Parse userlist");
+	try {
+		userlist.Load(game, file);
+	} catch (boss_error &e) {
+		std::vector<ParsingError> errs = userlist.ErrorBuffer();
+		userlist.Clear();  // If userlist has parsing errors, empty it so no rules are applied.
+		userlist.ErrorBuffer(errs);
+		LOG_ERROR("Error: %s", e.getString().c_str());
+	}
+}
+
+// Runs one sort for --watch, re-parsing the masterlist and userlist only if
+// they have changed since they were last parsed. startLog holds the updater
+// and ini output that each run's BOSS Log starts with. Returns a one-line summary.
+std::string WatchSort(Game &game, const BossLog &startLog,
+                      WatchState &state, MasterlistPrecompiler &precompiler) {
+	TRACE_SCOPE("Watched sort");
+	game.bosslog = startLog;
+
+	if (state.masterlistStale) {
+		try {
+			TRACE_SCOPE("Parse masterlist");
+			if (!precompiler.Take(game, state.masterlist))
+				state.masterlist.Load(game, game.Masterlist());
+			state.masterlistStale = false;
+		} catch (boss_error &e) {
+			RecordMasterlistError(game, state.masterlist, e);
+			return SortFailed(game, game.Log(gl_log_format), e);
+		}
+	}
+
+	if (state.userlistStale) {
+		LoadUserlist(game, game.Userlist(), state.userlist);
+		state.userlistStale = false;
+	}
+
+	// The plugins' order is what the last sort left, so they're always scanned again.
+	return SortParsed(game, state.masterlist, state.userlist, game.Modlist(),
+	                  game.OldModlist(), game.Log(gl_log_format));
+}
+
+// Keeps the masterlist and userlist parsed, and re-sorts whenever the plugins,
+// plugins.txt, loadorder.txt, the masterlist or the userlist change and then
+// stay unchanged for WATCH_DEBOUNCE. Scripts can send commands to
+// game.WatchSocket(): "sort" sorts now, "status" gives the last sort's
+// summary, and "quit" stops watching. Each reply is one line.
+int Watch(Game &game, MasterlistPrecompiler &precompiler,
+          const std::string &tracePath) {
+	typedef std::chrono::steady_clock Clock;
+
+	ChangeMonitor masterlistMonitor, userlistMonitor, pluginsMonitor;
+	masterlistMonitor.Watch(std::vector<fs::path>(1, game.Masterlist()));
+	userlistMonitor.Watch(std::vector<fs::path>(1, game.Userlist()));
+	std::vector<fs::path> pluginPaths(1, game.DataFolder());
+	pluginPaths.push_back(game.ActivePluginsFile());
+	if (game.GetLoadOrderMethod() == LOMETHOD_TEXTFILE)
+		pluginPaths.push_back(game.LoadOrderFile());
+	pluginsMonitor.Watch(pluginPaths);
+
+	CommandSocket commands;
+	try {
+		if (commands.Open(game.WatchSocket()))
+			std::cout << (boost::format(bloc::translate("Listening for commands on %1%.")) % game.WatchSocket().string()).str() << std::endl;
+	} catch (boss_error &e) {
+		std::cout << (boost::format(bloc::translate("Error: could not listen for commands. Details: %1%")) % e.getString()).str() << std::endl;
+		LOG_ERROR("Error: could not listen for commands. Details: %s",
+		          e.getString().c_str());
+	}
+
+	const BossLog startLog = game.bosslog;
+	WatchState state;
+	std::string summary = "none";  // Until the first sort.
+	bool pending = true;  // Sort straight away.
+	Clock::time_point lastChange = Clock::now() - std::chrono::milliseconds(WATCH_DEBOUNCE);
+	std::cout << bloc::translate("Watching for changes. Press Ctrl+C to stop.") << std::endl;
+	while (true) {
+		// Changes are taken as they're seen, so that a burst of them keeps
+		// putting the sort off until it's over.
+		if (masterlistMonitor.HasChanged()) {
+			masterlistMonitor.MarkUpToDate();
+			state.masterlistStale = true;
+			pending = true;
+			lastChange = Clock::now();
+		}
+		if (userlistMonitor.HasChanged()) {
+			userlistMonitor.MarkUpToDate();
+			state.userlistStale = true;
+			pending = true;
+			lastChange = Clock::now();
+		}
+		if (pluginsMonitor.HasChanged()) {
+			pluginsMonitor.MarkUpToDate();
+			pending = true;
+			lastChange = Clock::now();
+		}
+
+		// A pending sort is waited for even if that means checking sooner.
+		int pollInterval = pluginsMonitor.IsNotifying() ? WATCH_POLL_INTERVAL : WATCH_FALLBACK_POLL_INTERVAL;
+		if (pending) {
+			const Clock::duration untilSort = lastChange + std::chrono::milliseconds(WATCH_DEBOUNCE) - Clock::now();
+			pollInterval = std::max(0, std::min(pollInterval, int(std::chrono::duration_cast<std::chrono::milliseconds>(untilSort).count())));
+		}
+
+		std::string command;
+		bool hasCommand = commands.Wait(pollInterval, command);
+		if (hasCommand && command != "sort") {
+			if (command == "status") {
+				commands.Reply(summary + "\n");
+			} else if (command == "quit") {
+				commands.Reply("ok\n");
+				break;
+			} else {
+				commands.Reply("error unknown command\n");
+			}
+			continue;
+		}
+
+		if (hasCommand || (pending && Clock::now() - lastChange >= std::chrono::milliseconds(WATCH_DEBOUNCE))) {
+			summary = WatchSort(game, startLog, state, precompiler);
+			// Forget the sort's own changes to the plugins and load order files.
+			// Changes made by others while it ran are missed until the next change.
+			pluginsMonitor.MarkUpToDate();
+			pending = false;
+			std::cout << summary << std::endl;
+			if (hasCommand)
+				commands.Reply(summary + "\n");
+		}
+	}
+	commands.Close();
+	ReportProfile(game, tracePath);
+	return 0;
+}
+
+// Returns the game named name, ignoring case, or AUTODETECT if there isn't one.
+std::uint32_t GameFromName(const std::string &name) {
+	if (boost::iequals("Oblivion", name))
+		return OBLIVION;
+	else if (boost::iequals("Fallout3", name))
+		return FALLOUT3;
+	else if (boost::iequals("Nehrim", name))
+		return NEHRIM;
+	else if (boost::iequals("FalloutNV", name))
+		return FALLOUTNV;
+	else if (boost::iequals("Skyrim", name))
+		return SKYRIM;
+	return AUTODETECT;
+}
+
+// Removes "." and resolves ".." in an absolute path without touching the
+// filesystem. path::lexically_normal() does this, but needs Boost 1.60.
+fs::path NormalisePath(const fs::path &path) {
+	fs::path result;
+	for (fs::path::const_iterator it = path.begin(); it != path.end(); ++it) {
+		if (*it == ".")
+			continue;
+		if (*it != "..")
+			result /= *it;
+		else if (result.has_relative_path() && result.filename() != "..")
+			result.remove_filename();
+		else if (!result.has_root_directory())
+			result /= *it;  // ".." at the root is the root.
+	}
+	return result;
+}
+
+// One line of a --batch manifest.
+struct BatchProfile {
+	BatchProfile() : gameId(AUTODETECT), line(0), failed(false) {}
+
+	std::uint32_t gameId;
+	fs::path path;      // The game's folder.
+	fs::path userlist;  // Empty means the profile's BOSS folder's userlist.txt.
+	std::size_t line;   // In the manifest, for messages.
+	std::string summary;  // One line, set once the profile's been sorted.
+	bool failed;
+};
+
+// Reads a --batch manifest. Each line holds a game's name, its folder and
+// optionally a userlist, separated by tabs. Relative paths are taken from the
+// manifest's folder. Blank lines and lines starting with '#' are skipped.
+std::vector<BatchProfile> LoadManifest(const fs::path &manifest) {
+	boss_fstream::ifstream in(manifest);
+	if (!in.is_open())
+		throw boss_error(BOSS_ERROR_FILE_READ_FAIL, manifest.string());
+
+	const fs::path base = fs::absolute(manifest).parent_path();
+	std::vector<BatchProfile> profiles;
+	std::string line;
+	for (std::size_t lineNo = 1; std::getline(in, line); lineNo++) {
+		boost::trim(line);
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::vector<std::string> fields;
+		boost::split(fields, line, boost::is_any_of("\t"));
+		for (std::size_t i = 0, max = fields.size(); i < max; i++)
+			boost::trim(fields[i]);
+		if (fields.size() < 2 || fields.size() > 3 || fields[1].empty())
+			throw boss_error((boost::format(bloc::translate("%1%, line %2%: expected a game, its folder and optionally a userlist, separated by tabs.")) % manifest.string() % lineNo).str(),
+			                 BOSS_ERROR_INVALID_SYNTAX);
+
+		BatchProfile profile;
+		profile.gameId = GameFromName(fields[0]);
+		if (profile.gameId == AUTODETECT)
+			throw boss_error((boost::format(bloc::translate("%1%, line %2%: '%3%' is not a game. Valid games are 'Oblivion', 'Nehrim', 'Fallout3', 'FalloutNV' and 'Skyrim'.")) % manifest.string() % lineNo % fields[0]).str(),
+			                 BOSS_ERROR_INVALID_SYNTAX);
+		profile.path = NormalisePath(fs::absolute(fields[1], base));
+		if (fields.size() == 3 && !fields[2].empty())
+			profile.userlist = NormalisePath(fs::absolute(fields[2], base));
+		profile.line = lineNo;
+		profiles.push_back(profile);
+	}
+	return profiles;
+}
+
+// Returns a key that is equal for two absolute paths only if they're the same path.
+std::string PathKey(const fs::path &path) {
+#if _WIN32 || _WIN64
+	return boost::to_lower_copy(NormalisePath(fs::absolute(path)).string());
+#else
+	return NormalisePath(fs::absolute(path)).string();
+#endif
+}
+
+// What --batch shares between the profiles of one game.
+struct ParsedMasterlist {
+	ParsedMasterlist() : error(BOSS_OK) {}
+
+	BossLog startLog;   // The updater and ini output each profile's BOSS Log starts with.
+	ItemList items;     // As parsed, before its conditionals are evaluated. Only read once sorting starts.
+	boss_error error;   // Why the masterlist couldn't be parsed, if it couldn't.
+};
+
+// Sorts every profile in manifest on a pool of threads. Each game's masterlist
+// is parsed once, and each profile gets its own Game, userlist, modlist
+// backups and BOSS Log, kept in a BOSS folder inside its game folder. Returns
+// 1 if any profile couldn't be sorted.
+int Batch(const fs::path &manifest, const ParsingError &iniError,
+          const std::string &tracePath) {
+	std::vector<BatchProfile> profiles;
+	try {
+		profiles = LoadManifest(manifest);
+	} catch (boss_error &e) {
+		std::cout << (boost::format(bloc::translate("Error: %1%")) % e.getString()).str() << std::endl;
+		LOG_ERROR("Error: %s", e.getString().c_str());
+		return 1;
+	}
+	if (profiles.empty()) {
+		std::cout << (boost::format(bloc::translate("Error: %1% lists no profiles.")) % manifest.string()).str() << std::endl;
+		return 1;
+	}
+
+	// Set up each profile's Game, refusing profiles that would write over
+	// another's load order or output.
+	std::vector<Game> games(profiles.size());
+	std::vector<fs::path> folders(profiles.size());  // Where each profile's output goes.
+	std::map<std::string, std::size_t> owners;  // Path key -> the first profile using it.
+	for (std::size_t i = 0, max = profiles.size(); i < max; i++) {
+		try {
+			games[i] = Game(profiles[i].gameId, profiles[i].path.string());
+			folders[i] = profiles[i].path / "BOSS" / games[i].Masterlist().parent_path().filename();
+			fs::create_directories(folders[i]);
+			if (profiles[i].userlist.empty())
+				profiles[i].userlist = folders[i] / "userlist.txt";
+
+			std::vector<fs::path> owned(1, games[i].DataFolder());
+			owned.push_back(games[i].ActivePluginsFile());
+			if (games[i].GetLoadOrderMethod() == LOMETHOD_TEXTFILE)
+				owned.push_back(games[i].LoadOrderFile());
+			owned.push_back(folders[i]);
+			for (std::size_t j = 0, jmax = owned.size(); j < jmax; j++) {
+				std::map<std::string, std::size_t>::const_iterator owner = owners.find(PathKey(owned[j]));
+				if (owner != owners.end())
+					throw boss_error((boost::format(bloc::translate("\"%1%\" is also used by the profile on line %2%.")) % owned[j].string() % profiles[owner->second].line).str(),
+					                 BOSS_ERROR_INVALID_SYNTAX);
+			}
+			for (std::size_t j = 0, jmax = owned.size(); j < jmax; j++)
+				owners.insert(std::make_pair(PathKey(owned[j]), i));
+		} catch (boss_error &e) {
+			profiles[i].failed = true;
+			profiles[i].summary = "error " + e.getString();
+		} catch (fs::filesystem_error &e) {
+			profiles[i].failed = true;
+			profiles[i].summary = "error " + boss_error(BOSS_ERROR_FS_CREATE_DIRECTORY_FAIL, folders[i].string(), e.what()).getString();
+		}
+	}
+
+	// The first usable profile of each game stands in for it when updating and parsing its masterlist.
+	std::map<std::uint32_t, std::size_t> representatives;
+	std::size_t firstUsable = profiles.size();  // Its BOSS folder gets the profile and trace.
+	for (std::size_t i = 0, max = profiles.size(); i < max; i++) {
+		if (!profiles[i].failed) {
+			representatives.insert(std::make_pair(profiles[i].gameId, i));
+			if (firstUsable == profiles.size())
+				firstUsable = i;
+		}
+	}
+
+	std::map<std::uint32_t, ParsedMasterlist> masterlists;
+	for (std::map<std::uint32_t, std::size_t>::const_iterator it = representatives.begin(); it != representatives.end(); ++it) {
+		ParsedMasterlist &parsed = masterlists[it->first];
+		parsed.startLog.SetFormat(gl_log_format);
+		parsed.startLog.parsingErrors.push_back(iniError);
+	}
+
+	if (gl_update && !representatives.empty()) {
+		TRACE_SCOPE("Update masterlist");
+		std::cout << std::endl << bloc::translate("Updating to the latest masterlist from the online repository...") << std::endl;
+		std::vector<Game *> updating;
+		std::vector<std::string> names;
+		for (std::map<std::uint32_t, std::size_t>::const_iterator it = representatives.begin(); it != representatives.end(); ++it) {
+			try {
+				games[it->second].CreateBOSSGameFolder();
+			} catch (boss_error &e) {
+				LOG_ERROR("Error: %s", e.getString().c_str());
+			}
+			updating.push_back(&games[it->second]);
+			names.push_back(games[it->second].Name());
+		}
+		std::vector<MasterlistUpdate> updates = UpdateMasterlists(updating, multiProgress, &names);
+		std::cout << std::endl;
+		for (std::size_t i = 0, max = updates.size(); i < max; i++) {
+			BossLog &startLog = masterlists[updating[i]->Id()].startLog;
+			if (updates[i].errorCode == BOSS_OK) {
+				std::string message = (boost::format(bloc::translate("Masterlist updated; at revision: %1%.")) % updates[i].revision).str();
+				startLog.updaterOutput << LIST_ITEM_CLASS_SUCCESS << message;
+				std::cout << (boost::format(bloc::translate("%1% masterlist updated; at revision: %2%.")) % names[i] % updates[i].revision).str() << std::endl;
+			} else {
+				startLog.updaterOutput << LIST_ITEM_CLASS_ERROR << bloc::translate("Error: masterlist update failed.") << LINE_BREAK
+				                       << (boost::format(bloc::translate("Details: %1%")) % updates[i].errorString).str() << LINE_BREAK;
+				std::cout << (boost::format(bloc::translate("Error: %1% masterlist update failed. Details: %2%")) % names[i] % updates[i].errorString).str() << std::endl;
+			}
+		}
+	} else {
+		for (std::map<std::uint32_t, std::size_t>::const_iterator it = representatives.begin(); it != representatives.end(); ++it) {
+			std::string revision = GetMasterlistVersion(games[it->second]);
+			std::string message = (boost::format(bloc::translate("Masterlist updating disabled; at revision: %1%.")) % revision).str();
+			masterlists[it->first].startLog.updaterOutput << LIST_ITEM_CLASS_SUCCESS << message;
+		}
+	}
+
+	for (std::map<std::uint32_t, std::size_t>::const_iterator it = representatives.begin(); it != representatives.end(); ++it) {
+		TRACE_SCOPE("Parse masterlist");
+		ParsedMasterlist &parsed = masterlists[it->first];
+		try {
+			parsed.items.Load(games[it->second], games[it->second].Masterlist());
+		} catch (boss_error &e) {
+			LOG_ERROR("Critical Error: %s", e.getString().c_str());
+			parsed.error = e;
+		}
+	}
+
+	std::cout << std::endl << (boost::format(bloc::translate("BOSS working on %1% profiles...")) % profiles.size()).str() << std::endl;
+
+	std::atomic<std::size_t> next(0);
+	auto sortProfiles = [&]() {
+		for (std::size_t i = next++; i < profiles.size(); i = next++) {
+			if (profiles[i].failed)
+				continue;
+			Game &game = games[i];
+			g_logger.setThreadContext((boost::format("%1% %2%") % game.Name() % profiles[i].path.string()).str());
+			const ParsedMasterlist &masterlist = masterlists.find(profiles[i].gameId)->second;
+			const fs::path log = folders[i] / game.Log(gl_log_format).filename();
+			try {
+				game.bosslog = masterlist.startLog;
+				if (masterlist.error.getCode() != BOSS_OK) {
+					RecordMasterlistError(game, masterlist.items, masterlist.error);
+					profiles[i].summary = SortFailed(game, log, masterlist.error);
+				} else {
+					RuleList userlist;
+					LoadUserlist(game, profiles[i].userlist, userlist);
+					profiles[i].summary = SortParsed(game, masterlist.items, userlist,
+					                                 folders[i] / game.Modlist().filename(),
+					                                 folders[i] / game.OldModlist().filename(),
+					                                 log);
+				}
+			} catch (std::exception &e) {
+				LOG_ERROR("Critical Error: %s", e.what());
+				profiles[i].summary = std::string("error ") + e.what();
+			}
+			profiles[i].failed = profiles[i].summary.compare(0, 3, "ok ") != 0;
+		}
+		g_logger.setThreadContext("");
+	};
+	std::size_t workers = std::max(std::thread::hardware_concurrency(), 1u);
+	workers = std::min(workers, profiles.size());
+	std::vector<std::thread> threads;
+	for (std::size_t i = 1; i < workers; i++) {
+		try {
+			threads.push_back(std::thread(sortProfiles));
+		} catch (std::system_error /*&e*/) {
+			break;  // The threads there are will share the profiles out.
+		}
+	}
+	sortProfiles();
+	for (std::size_t i = 0, max = threads.size(); i < max; i++)
+		threads[i].join();
+
+	int result = 0;
+	for (std::size_t i = 0, max = profiles.size(); i < max; i++) {
+		std::cout << (boost::format("%1%:%2%: %3%") % manifest.string() % profiles[i].line % profiles[i].summary).str() << std::endl;
+		if (profiles[i].failed)
+			result = 1;
+	}
+	if (firstUsable < profiles.size())
+		ReportProfile(games[firstUsable], tracePath);
+	return result;
+}
+
 int bossMain(int argc, char *argv[]) {
 	Settings ini;
 	Game game;
 	std::string gameStr;  // Allow for autodetection override
 	std::string bosslogFormat;
+	std::string tracePath;  // Empty means the default location.
+	bool updateAll = false;  // Update every detected game's masterlist, not just the one being sorted.
+	bool watch = false;  // Keep running and re-sort on changes.
+	std::string batchFile;  // Manifest of profiles to sort instead of the detected game.
+	MasterlistPrecompiler precompiler;  // Parses the masterlist in the background once it's been updated.
 	fs::path sortfile;  // Modlist/masterlist to sort plugins using.
 
 
@@ -139,6 +684,8 @@ int bossMain(int argc, char *argv[]) {
 	// Set up initial conditions
 	///////////////////////////////
 
+	// The logger's writer thread has to be stopped before static destructors run.
+	std::atexit([]() { g_logger.stop(); });
 	LOG_INFO("BOSS starting...");
 
 	LOG_INFO("Parsing Ini...");
@@ -203,6 +750,10 @@ int bossMain(int argc, char *argv[]) {
 	                                 " masterlist to the latest version"
 	                                 " available on the web before sorting").str().c_str())
 	                ("no-update,U", bloc::translate("inhibit the automatic masterlist updater").str().c_str())
+	                ("update-all", po::value(&updateAll)->zero_tokens(),
+	                 bloc::translate("when updating the masterlist, update the"
+	                                 " masterlists of all detected games at"
+	                                 " once").str().c_str())
 	                ("only-update,o", po::value(&gl_update_only)->zero_tokens(),
 	                 bloc::translate("automatically update the local copy of the"
 	                                 " masterlist to the latest version"
@@ -233,8 +784,34 @@ int bossMain(int argc, char *argv[]) {
 	                ("format,f", po::value(&bosslogFormat),
 	                 bloc::translate("select output format. valid values"
 	                                 " are: 'html', 'text'").str().c_str())
+	                ("watch", po::value(&watch)->zero_tokens(),
+	                 bloc::translate("keep running, and sort again whenever the"
+	                                 " plugins, plugins.txt, loadorder.txt, the"
+	                                 " masterlist or the userlist change.  sorts"
+	                                 " can also be requested by sending 'sort' to"
+	                                 " BOSSWatch.sock in the game's BOSS folder,"
+	                                 " which replies with a summary").str().c_str())
+	                ("batch", po::value(&batchFile),
+	                 bloc::translate("sort each profile listed in the given manifest"
+	                                 " instead of the detected game, several at once."
+	                                 "  each line holds a game (as for --game), its"
+	                                 " folder and optionally a userlist, separated by"
+	                                 " tabs.  each profile's BOSS Log, modlist and"
+	                                 " default userlist are kept in a BOSS folder"
+	                                 " inside its game folder").str().c_str())
 	                ("trial-run,t", po::value(&gl_trial_run)->zero_tokens(),
-	                 bloc::translate("run BOSS without actually making any changes to load order").str().c_str());
+	                 bloc::translate("run BOSS without actually making any changes to load order").str().c_str())
+	                ("profile,p", bloc::translate("print how long each stage of the run took, and"
+	                                              " save the breakdown to BOSSProfile.json in"
+	                                              " the game's BOSS folder").str().c_str())
+	                ("trace", po::value(&tracePath)->implicit_value("", ""),
+	                 bloc::translate("record trace events for each stage of the run and"
+	                                 " each file read, and save them for viewing in"
+	                                 " about:tracing or Perfetto.  this parameter"
+	                                 " optionally accepts the file to save them to,"
+	                                 " which defaults to BOSSTrace.json in the game's"
+	                                 " BOSS folder.  setting the BOSS_TRACE environment"
+	                                 " variable to a file path does the same").str().c_str());
 
 	// Parse command line arguments
 	po::variables_map vm;
@@ -269,6 +846,16 @@ int bossMain(int argc, char *argv[]) {
 		ShowVersion();
 		exit(0);
 	}
+	if (vm.count("profile")) {
+		g_profiler.Enable(true);
+		g_profiler.Reset();
+	}
+	if (!vm.count("trace") && std::getenv("BOSS_TRACE") != NULL)
+		tracePath = std::getenv("BOSS_TRACE");
+	if (vm.count("trace") || !tracePath.empty()) {
+		g_tracer.Enable(true);
+		g_tracer.Reset();
+	}
 	if (vm.count("no-update")) {
 		gl_update = false;
 	}
@@ -276,23 +863,22 @@ int bossMain(int argc, char *argv[]) {
 		LOG_ERROR("invalid options: --update,-u and --no-update,-U cannot both be given.");
 		Fail();
 	}
+	if (watch && (vm.count("revert") || gl_update_only)) {
+		LOG_ERROR("invalid options: --watch cannot be given with --revert,-r or --only-update,-o.");
+		Fail();
+	}
+	if (vm.count("batch") && (watch || vm.count("revert") || gl_update_only || vm.count("game"))) {
+		LOG_ERROR("invalid options: --batch cannot be given with --watch, --revert,-r, --only-update,-o or --game,-g.");
+		Fail();
+	}
 	if (vm.count("revert") && (gl_revert < 1 || gl_revert > 2)) {
 		LOG_ERROR("invalid option for 'revert' parameter: %d", gl_revert);
 		Fail();
 	}
 	if (vm.count("game")) {
 		// Sanity check and parse argument
-		if (boost::iequals("Oblivion", gameStr)) {
-			gl_game = OBLIVION;
-		} else if (boost::iequals("Fallout3", gameStr)) {
-			gl_game = FALLOUT3;
-		} else if (boost::iequals("Nehrim", gameStr)) {
-			gl_game = NEHRIM;
-		} else if (boost::iequals("FalloutNV", gameStr)) {
-			gl_game = FALLOUTNV;
-		} else if (boost::iequals("Skyrim", gameStr)) {
-			gl_game = SKYRIM;
-		} else {
+		gl_game = GameFromName(gameStr);
+		if (gl_game == AUTODETECT) {
 			LOG_ERROR("invalid option for 'game' parameter: '%s'",
 			          gameStr.c_str());
 			Fail();
@@ -316,15 +902,19 @@ int bossMain(int argc, char *argv[]) {
 	}
 
 
+	if (vm.count("batch"))
+		return Batch(batchFile, ini.ErrorBuffer(), tracePath);
+
+
 	/////////////////////////////////////////
 	// Check for critical error conditions
 	/////////////////////////////////////////
 
 	// Game checks.
 	LOG_DEBUG("Detecting game...");
+	std::vector<std::uint32_t> detected, undetected;
 	try {
 		gl_last_game = AUTODETECT;  // Clear this setting in case the GUI was run.
-		std::vector<std::uint32_t> detected, undetected;
 		std::uint32_t detectedGame = DetectGame(detected, undetected);
 		if (detectedGame == AUTODETECT) {
 			// Now check what games were found.
@@ -374,18 +964,63 @@ int bossMain(int argc, char *argv[]) {
 	/////////////////////////////////////////////////////////
 
 	if (gl_revert < 1 && (gl_update || gl_update_only)) {
+		TRACE_SCOPE("Update masterlist");
 		std::cout << std::endl << bloc::translate("Updating to the latest masterlist from the online repository...") << std::endl;
 		LOG_DEBUG("Updating masterlist...");
-		try {
-			std::string revision = UpdateMasterlist(game, progress, NULL);
-			std::string message = (boost::format(bloc::translate("Masterlist updated; at revision: %1%.")) % revision).str();
-			game.bosslog.updaterOutput << LIST_ITEM_CLASS_SUCCESS << message;
-			std::cout << std::endl << message << std::endl;
-		} catch (boss_error &e) {
-			game.bosslog.updaterOutput << LIST_ITEM_CLASS_ERROR << bloc::translate("Error: masterlist update failed.") << LINE_BREAK
-			                           << (boost::format(bloc::translate("Details: %1%")) % e.getString()).str() << LINE_BREAK;
-			LOG_ERROR("Error: masterlist update failed. Details: %s",
-			          e.getString().c_str());
+		// The other detected games to update alongside this one, if any.
+		std::vector<Game> otherGames;
+		if (updateAll) {
+			for (std::size_t i = 0, max = detected.size(); i < max; i++) {
+				if (detected[i] == game.Id())
+					continue;
+				try {
+					Game otherGame(detected[i]);
+					otherGame.CreateBOSSGameFolder();
+					otherGames.push_back(otherGame);
+				} catch (boss_error &e) {
+					std::cout << std::endl << (boost::format(bloc::translate("Error: could not update the %1% masterlist. Details: %2%")) % Game(detected[i], "", true).Name() % e.getString()).str() << std::endl;
+					LOG_ERROR("Error: could not set up %s for updating. Details: %s",
+					          Game(detected[i], "", true).Name().c_str(), e.getString().c_str());
+				}
+			}
+		}
+		if (otherGames.empty()) {
+			try {
+				std::string revision = UpdateMasterlist(game, progress, NULL);
+				precompiler.Start(game, revision);
+				std::string message = (boost::format(bloc::translate("Masterlist updated; at revision: %1%.")) % revision).str();
+				game.bosslog.updaterOutput << LIST_ITEM_CLASS_SUCCESS << message;
+				std::cout << std::endl << message << std::endl;
+			} catch (boss_error &e) {
+				game.bosslog.updaterOutput << LIST_ITEM_CLASS_ERROR << bloc::translate("Error: masterlist update failed.") << LINE_BREAK
+				                           << (boost::format(bloc::translate("Details: %1%")) % e.getString()).str() << LINE_BREAK;
+				LOG_ERROR("Error: masterlist update failed. Details: %s",
+				          e.getString().c_str());
+			}
+		} else {
+			std::vector<Game *> games(1, &game);
+			std::vector<std::string> names(1, game.Name());
+			for (std::size_t i = 0, max = otherGames.size(); i < max; i++) {
+				games.push_back(&otherGames[i]);
+				names.push_back(otherGames[i].Name());
+			}
+			std::vector<MasterlistUpdate> updates = UpdateMasterlists(games, multiProgress, &names);
+			std::cout << std::endl;
+			// The game being sorted comes first, and its outcome goes in its BOSS Log as usual.
+			if (updates[0].errorCode == BOSS_OK) {
+				precompiler.Start(game, updates[0].revision);
+				std::string message = (boost::format(bloc::translate("Masterlist updated; at revision: %1%.")) % updates[0].revision).str();
+				game.bosslog.updaterOutput << LIST_ITEM_CLASS_SUCCESS << message;
+			} else {
+				game.bosslog.updaterOutput << LIST_ITEM_CLASS_ERROR << bloc::translate("Error: masterlist update failed.") << LINE_BREAK
+				                           << (boost::format(bloc::translate("Details: %1%")) % updates[0].errorString).str() << LINE_BREAK;
+			}
+			for (std::size_t i = 0, max = updates.size(); i < max; i++) {
+				if (updates[i].errorCode == BOSS_OK)
+					std::cout << (boost::format(bloc::translate("%1% masterlist updated; at revision: %2%.")) % names[i] % updates[i].revision).str() << std::endl;
+				else
+					std::cout << (boost::format(bloc::translate("Error: %1% masterlist update failed. Details: %2%")) % names[i] % updates[i].errorString).str() << std::endl;
+			}
 		}
 	} else {
 		std::string revision = GetMasterlistVersion(game);
@@ -395,17 +1030,30 @@ int bossMain(int argc, char *argv[]) {
 
 	// If true, exit BOSS now. Flush earlyBOSSlogBuffer to the bosslog and exit.
 	if (gl_update_only) {
+		// There's no sort to find a corrupt update, so check that the updated masterlist parses now.
+		try {
+			ItemList updatedMasterlist;
+			precompiler.Take(game, updatedMasterlist);
+		} catch (boss_error &e) {
+			game.bosslog.updaterOutput << LIST_ITEM_CLASS_ERROR << bloc::translate("Error: the updated masterlist could not be parsed.") << LINE_BREAK
+			                           << (boost::format(bloc::translate("Details: %1%")) % e.getString()).str() << LINE_BREAK;
+		}
 		try {
 			game.bosslog.Save(game.Log(gl_log_format), true);
 		} catch (boss_error &e) {
 			LOG_ERROR("Critical Error: %s", e.getString().c_str());
 		}
+		ReportProfile(game, tracePath);
 		if (!gl_silent)
 			Launch(game.Log(gl_log_format).string());  // Displays the BOSSlog.
 		return 0;
 	}
 
 
+	if (watch)
+		return Watch(game, precompiler, tracePath);  // Doesn't return until told to quit.
+
+
 	///////////////////////////////////
 	// Resume Error Condition Checks
 	///////////////////////////////////
@@ -414,6 +1062,7 @@ int bossMain(int argc, char *argv[]) {
 
 	// Build and save modlist.
 	try {
+		TRACE_SCOPE("Build modlist");
 		game.modlist.Load(game, game.DataFolder());
 		if (gl_revert < 1)
 			game.modlist.Save(game.Modlist(), game.OldModlist());
@@ -450,9 +1099,13 @@ int bossMain(int argc, char *argv[]) {
 
 	// Parse masterlist/modlist backup into data structure.
 	try {
+		TRACE_SCOPE("Parse masterlist");
 		LOG_INFO("Starting to parse sorting file: %s",
 		         sortfile.string().c_str());
-		game.masterlist.Load(game, sortfile);
+		// If the masterlist was just updated, it's been parsed in the background.
+		if (sortfile != game.Masterlist() ||
+		    !precompiler.Take(game, game.masterlist))
+			game.masterlist.Load(game, sortfile);
 		LOG_INFO("Starting to parse conditionals from sorting file: %s",
 		         sortfile.string().c_str());
 		game.masterlist.EvalConditions(game);
@@ -482,6 +1135,7 @@ int bossMain(int argc, char *argv[]) {
 
 	LOG_INFO("Starting to parse userlist.");
 	try {
+		TRACE_SCOPE("Parse userlist");
 		game.userlist.Load(game, game.Userlist());
 		std::vector<ParsingError> errs = game.userlist.ErrorBuffer();
 		game.bosslog.parsingErrors.insert(game.bosslog.parsingErrors.end(),
@@ -499,12 +1153,13 @@ int bossMain(int argc, char *argv[]) {
 	//////////////////////////////////
 
 	try {
+		TRACE_SCOPE("Sort plugins");
 		game.ApplyMasterlist();
 		LOG_INFO("masterlist now filled with ordered mods and modlist filled with unknowns.");
 		game.ApplyUserlist();
 		LOG_INFO("userlist sorting process finished.");
 		game.ScanSEPlugins();
-		game.SortPlugins();
+		game.SortPlugins(gl_trial_run);
 		game.bosslog.Save(game.Log(gl_log_format), true);
 	} catch (boss_error &e) {
 		LOG_ERROR("Critical Error: %s", e.getString().c_str());
@@ -521,6 +1176,8 @@ int bossMain(int argc, char *argv[]) {
 		exit(1);  // Fail in screaming heap.
 	}
 
+	ReportProfile(game, tracePath);
+
 	LOG_INFO("Launching boss log in browser.");
 	if (!gl_silent)
 		Launch(game.Log(gl_log_format).string());  // Displays the BOSSlog.txt.
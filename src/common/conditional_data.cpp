@@ -46,6 +46,7 @@
 #include "support/helpers.h"
 #include "support/logger.h"
 #include "support/mod_format.h"
+#include "support/profiler.h"
 
 namespace boss {
 
@@ -87,6 +88,7 @@ bool conditionalData::EvalConditions(
     ParsingError &errorBuffer,
     const Game &parentGame) {
 	if (!conditions.empty()) {
+		PROFILE_COUNT(PC_CONDITIONS_EVALUATED, 1);
 		Skipper skipper;
 		conditional_grammar grammar;
 		std::string::const_iterator begin, end;
@@ -235,8 +237,8 @@ bool Item::IsGameMasterFile(const Game &parentGame) const {
 
 bool Item::IsMasterFile(const Game &parentGame) const {
 	if (IsGhosted(parentGame))
-		return IsPluginMaster(parentGame.DataFolder() / fs::path(Data() + ".ghost"));
-	return IsPluginMaster(parentGame.DataFolder() / Data());
+		return parentGame.pluginCache.IsMaster(parentGame.DataFolder() / fs::path(Data() + ".ghost"));
+	return parentGame.pluginCache.IsMaster(parentGame.DataFolder() / Data());
 }
 
 bool Item::IsFalseFlagged(const Game &parentGame) const {
@@ -250,10 +252,12 @@ bool Item::IsFalseFlagged(const Game &parentGame) const {
 }
 
 bool Item::IsGhosted(const Game &parentGame) const {
+	PROFILE_COUNT(PC_FILES_STATED, 1);
 	return fs::exists(parentGame.DataFolder() / fs::path(Data() + ".ghost"));
 }
 
 bool Item::Exists(const Game &parentGame) const {
+	PROFILE_COUNT(PC_FILES_STATED, 1);
 	return (fs::exists(parentGame.DataFolder() / Data()) ||
 	        fs::exists(parentGame.DataFolder() / fs::path(Data() + ".ghost")));
 }
@@ -262,16 +266,10 @@ Version Item::GetVersion(const Game &parentGame) const {
 	if (!IsPlugin())
 		return Version();
 
-	ModHeader header;
-
-	// Read mod's header now...
-	if (IsGhosted(parentGame))
-		header = ReadHeader(parentGame.DataFolder() / fs::path(Data() + ".ghost"));
-	else
-		header = ReadHeader(parentGame.DataFolder() / Data());
-
 	// The current mod's version if found, or empty otherwise.
-	return Version(header.Version);
+	if (IsGhosted(parentGame))
+		return Version(parentGame.pluginCache.HeaderVersion(parentGame.DataFolder() / fs::path(Data() + ".ghost")));
+	return Version(parentGame.pluginCache.HeaderVersion(parentGame.DataFolder() / Data()));
 }
 
 std::time_t Item::GetModTime(const Game &parentGame) const {  // Can throw exception.
@@ -303,6 +301,7 @@ void Item::UnGhost(const Game &parentGame) const {  // Can throw exception.
 
 void Item::SetModTime(const Game &parentGame,
                       const std::time_t modificationTime) const {
+	PROFILE_COUNT(PC_TIMESTAMPS_WRITTEN, 1);
 	try {
 		if (IsGhosted(parentGame))
 			fs::last_write_time(parentGame.DataFolder() / fs::path(Data() + ".ghost"),
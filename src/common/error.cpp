@@ -63,6 +63,7 @@ BOSS_COMMON const std::uint32_t BOSS_ERROR_FS_FILE_RENAME_FAIL
 BOSS_COMMON const std::uint32_t BOSS_ERROR_FS_FILE_DELETE_FAIL                  = 18;
 BOSS_COMMON const std::uint32_t BOSS_ERROR_FS_CREATE_DIRECTORY_FAIL             = 19;
 BOSS_COMMON const std::uint32_t BOSS_ERROR_FS_ITER_DIRECTORY_FAIL               = 20;
+BOSS_COMMON const std::uint32_t BOSS_ERROR_FS_SOCKET_FAIL                       = 21;
 
 BOSS_COMMON const std::uint32_t BOSS_ERROR_GUI_WINDOW_INIT_FAIL                 = 30;
 
@@ -78,8 +79,9 @@ BOSS_COMMON const std::uint32_t BOSS_ERROR_PLUGIN_BEFORE_MASTER
 BOSS_COMMON const std::uint32_t BOSS_ERROR_INVALID_SYNTAX                       = 40;
 
 BOSS_COMMON const std::uint32_t BOSS_ERROR_GIT_ERROR                            = 41;
+BOSS_COMMON const std::uint32_t BOSS_ERROR_CANCELLED                            = 42;
 
-BOSS_COMMON const std::uint32_t BOSS_ERROR_MAX                                  = BOSS_ERROR_GIT_ERROR;
+BOSS_COMMON const std::uint32_t BOSS_ERROR_MAX                                  = BOSS_ERROR_CANCELLED;
 
 
 ////////////////////////////////
@@ -164,6 +166,8 @@ std::string boss_error::getString() const {
 		return (boost::format(bloc::translate("\"%1%\" cannot be created! Filesystem response: \"%2%\".")) % errSubject % errString).str();
 	else if (errCode == BOSS_ERROR_FS_ITER_DIRECTORY_FAIL)
 		return (boost::format(bloc::translate("\"%1%\" cannot be scanned! Filesystem response: \"%2%\".")) % errSubject % errString).str();
+	else if (errCode == BOSS_ERROR_FS_SOCKET_FAIL)
+		return (boost::format(bloc::translate("Cannot listen on the socket \"%1%\"! Details: \"%2%\".")) % errSubject % errString).str();
 	else if (errCode == BOSS_ERROR_GUI_WINDOW_INIT_FAIL)
 		return (boost::format(bloc::translate("The window \"%1%\" failed to initialise. Details: \"%2%\".")) % errSubject % errString).str();
 	else if (errCode == BOSS_ERROR_NO_MEM)
@@ -180,6 +184,8 @@ std::string boss_error::getString() const {
 		return errString;
 	else if (errCode == BOSS_ERROR_GIT_ERROR)
 		return (boost::format(bloc::translate("Git operation failed. Error: %1%")) % errString).str();
+	else if (errCode == BOSS_ERROR_CANCELLED)
+		return bloc::translate("The operation was cancelled.");
 	return bloc::translate("No error.");
 }
 
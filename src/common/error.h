@@ -66,6 +66,7 @@ BOSS_COMMON extern const std::uint32_t BOSS_ERROR_FS_FILE_RENAME_FAIL;
 BOSS_COMMON extern const std::uint32_t BOSS_ERROR_FS_FILE_DELETE_FAIL;
 BOSS_COMMON extern const std::uint32_t BOSS_ERROR_FS_CREATE_DIRECTORY_FAIL;
 BOSS_COMMON extern const std::uint32_t BOSS_ERROR_FS_ITER_DIRECTORY_FAIL;
+BOSS_COMMON extern const std::uint32_t BOSS_ERROR_FS_SOCKET_FAIL;
 
 BOSS_COMMON extern const std::uint32_t BOSS_ERROR_GUI_WINDOW_INIT_FAIL;
 
@@ -81,6 +82,7 @@ BOSS_COMMON extern const std::uint32_t BOSS_ERROR_PLUGIN_BEFORE_MASTER;
 BOSS_COMMON extern const std::uint32_t BOSS_ERROR_INVALID_SYNTAX;
 
 BOSS_COMMON extern const std::uint32_t BOSS_ERROR_GIT_ERROR;
+BOSS_COMMON extern const std::uint32_t BOSS_ERROR_CANCELLED;
 
 BOSS_COMMON extern const std::uint32_t BOSS_ERROR_MAX;
 
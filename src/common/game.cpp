@@ -43,11 +43,16 @@
 #include <cstdlib>
 #include <ctime>
 
+#include <algorithm>
+#include <condition_variable>
 #include <functional>
 //#include <iostream>
 #include <iterator>
 #include <locale>
+#include <mutex>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
@@ -68,6 +73,7 @@
 #include "support/helpers.h"
 #include "support/logger.h"
 #include "support/platform.h"
+#include "support/profiler.h"
 
 
 
@@ -139,6 +145,115 @@ BOSS_COMMON std::uint32_t DetectGame(
 	return AutodetectGame(detectedGames);
 }
 
+// A plugin that Game::SortPlugins needs to redate.
+struct RedateJob {
+	std::size_t pos;                  // The plugin's position in the sorted list.
+	fs::path file;                    // The plugin file, or its ghost.
+	std::time_t time;                 // The timestamp to give it.
+	boost::system::error_code error;  // Set if redating failed.
+};
+
+/*
+ * Redates plugins across a few threads, which are started once per sort. Each
+ * thread takes every workers-th job, but only once the caller has released it,
+ * so that a cancelled sort stops redating at the end of its current batch.
+ */
+class Redater {
+ public:
+	explicit Redater(std::vector<RedateJob> &inJobs);
+	~Redater();
+
+	// Redates the jobs before end, and waits for them to finish.
+	void RunUntil(const std::size_t end);
+
+ private:
+	std::vector<RedateJob> &jobs;
+	std::size_t workers;
+	std::vector<std::thread> threads;
+	std::vector<std::size_t> callerOffsets;  // The shares done by the calling thread: its own, and any that a thread couldn't be started for.
+	std::mutex mutex;
+	std::condition_variable releasedCv;      // Signalled when limit rises, or when stopping.
+	std::condition_variable completedCv;     // Signalled when completed reaches limit.
+	std::size_t limit;                       // Jobs before this have been released.
+	std::size_t completed;
+	bool stopping;
+
+	void Redate(const std::size_t i);
+	void Work(const std::size_t offset);
+
+	Redater(const Redater &);  // Not copyable.
+	Redater &operator = (const Redater &);
+};
+
+Redater::Redater(std::vector<RedateJob> &inJobs)
+    : jobs(inJobs), limit(0), completed(0), stopping(false) {
+	workers = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), 4);
+	workers = std::min(workers, jobs.size());
+	callerOffsets.push_back(0);
+	for (std::size_t i = 1; i < workers; i++) {
+		try {
+			threads.push_back(std::thread(&Redater::Work, this, i));
+		} catch (std::system_error /*&e*/) {
+			callerOffsets.push_back(i);  // Do this share on the calling thread instead.
+		}
+	}
+}
+
+Redater::~Redater() {
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		stopping = true;
+	}
+	releasedCv.notify_all();
+	for (std::size_t i = 0, max = threads.size(); i < max; i++)
+		threads[i].join();
+}
+
+void Redater::RunUntil(const std::size_t end) {
+	std::size_t start;
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		if (end <= limit)
+			return;
+		start = limit;
+		limit = end;
+	}
+	releasedCv.notify_all();
+
+	for (std::size_t j = 0, max = callerOffsets.size(); j < max; j++) {
+		std::size_t i = start - start % workers + callerOffsets[j];
+		if (i < start)
+			i += workers;
+		for (; i < end; i += workers)
+			Redate(i);
+	}
+
+	std::unique_lock<std::mutex> guard(mutex);
+	while (completed < end)
+		completedCv.wait(guard);
+}
+
+void Redater::Redate(const std::size_t i) {
+	PROFILE_COUNT(PC_TIMESTAMPS_WRITTEN, 1);
+	fs::last_write_time(jobs[i].file, jobs[i].time, jobs[i].error);
+	std::lock_guard<std::mutex> guard(mutex);
+	if (++completed == limit)
+		completedCv.notify_one();
+}
+
+void Redater::Work(const std::size_t offset) {
+	for (std::size_t i = offset, max = jobs.size(); i < max; i += workers) {
+		{
+			std::unique_lock<std::mutex> guard(mutex);
+			while (i >= limit && !stopping)
+				releasedCv.wait(guard);
+			if (stopping)
+				return;
+		}
+		Redate(i);
+	}
+}
+
 // Structures necessary for case-insensitive hashsets used in BuildWorkingModlist.
 // Taken from the BOOST docs.
 struct iequal_to : std::binary_function<std::string, std::string, bool> {
@@ -401,6 +516,18 @@ fs::path Game::Log(std::uint32_t format) const {
 	return boss_path / bossFolderName / "BOSSlog.txt";
 }
 
+fs::path Game::Profile() const {
+	return boss_path / bossFolderName / "BOSSProfile.json";
+}
+
+fs::path Game::Trace() const {
+	return boss_path / bossFolderName / "BOSSTrace.json";
+}
+
+fs::path Game::WatchSocket() const {
+	return boss_path / bossFolderName / "BOSSWatch.sock";
+}
+
 void Game::CreateBOSSGameFolder() {
 	// Make sure that the BOSS game path exists.
 	try {
@@ -414,6 +541,7 @@ void Game::CreateBOSSGameFolder() {
 }
 
 void Game::ApplyMasterlist() {
+	PROFILE_SCOPE("Game::ApplyMasterlist");
 	// Add all modlist and userlist mods and groups referenced in userlist to a hashset to optimise comparison against masterlist.
 	std::unordered_set<std::string, ihash, iequal_to> mHashset, uHashset, addedItems;  // Holds mods and groups for checking against masterlist.
 	std::unordered_set<std::string>::iterator setPos;
@@ -476,6 +604,7 @@ void Game::ApplyMasterlist() {
 }
 
 void Game::ApplyUserlist() {
+	PROFILE_SCOPE("Game::ApplyUserlist");
 	// TODO(MCP): Delete temporary debug statements
 	std::vector<Rule> rules = userlist.Rules();
 	if (rules.empty())
@@ -517,12 +646,11 @@ void Game::ApplyUserlist() {
 			if (ruleIter->Key() != FOR) {  // First non-rule line is a sort line.
 				if (lines[i].Key() == BEFORE || lines[i].Key() == AFTER) {
 					//std::clog << "Rule is BEFORE or AFTER" << std::endl;
-					Item mod;
 					modlistPos1 = modlist.FindItem(ruleItem.Name(), MOD);
 					//std::clog << "Found: " << ruleItem.Name() << std::endl;
 					// Do checks.
 					if (ruleIter->Key() == ADD &&
-					    modlistPos1 == modlist.Items().size()) {
+					    modlistPos1 == modlist.Size()) {
 						bosslog.userRules << TABLE_ROW_CLASS_WARN << TABLE_DATA << *ruleIter << TABLE_DATA << "✗" << TABLE_DATA << VAR_OPEN << ruleIter->Object() << VAR_CLOSE << bloc::translate(" is not installed or in the masterlist.");
 						LOG_WARN(" * \"%s\" is not in the masterlist or installed.",
 						         ruleIter->Object().c_str());
@@ -549,7 +677,7 @@ void Game::ApplyUserlist() {
 					modlistPos2 = modlist.FindItem(lines[i].Object(), MOD);  // Find sort mod.
 					//std::clog << "Found: " << lines[i].Object().c_str() << std::endl;
 					// Do checks.
-					if (modlistPos2 == modlist.Items().size()) {  // Handle case of mods that don't exist at all.
+					if (modlistPos2 == modlist.Size()) {  // Handle case of mods that don't exist at all.
 						bosslog.userRules << TABLE_ROW_CLASS_WARN << TABLE_DATA << *ruleIter << TABLE_DATA << "✗" << TABLE_DATA << VAR_OPEN << lines[i].Object() << VAR_CLOSE << bloc::translate(" is not installed, and is not in the masterlist.");
 						LOG_WARN(" * \"%s\" is not installed or in the masterlist.",
 						         lines[i].Object().c_str());
@@ -566,26 +694,15 @@ void Game::ApplyUserlist() {
 						lastRecognisedItem = modlist.ItemAt(modlistPos1);
 						//std::clog << "Moving last item" << std::endl;
 					}
-					//std::clog << "Recording rule mod in new variable" << std::endl;
-					mod = modlist.ItemAt(modlistPos1);  // Record the rule mod in a new variable.
-					//std::clog << "Removing mod from old position" << std::endl;
-					modlist.Erase(modlistPos1);  // Now remove the rule mod from its old position. This breaks all modlist iterators active.
-					// Need to find sort mod pos again, to fix iterator.
-					//std::clog << "Finding position again now that iterator has changed" << std::endl;
-					modlistPos2 = modlist.FindItem(lines[i].Object(), MOD);  // Find sort mod.
 					// Insert the mod into its new position.
-					if (lines[i].Key() == AFTER) {
+					if (lines[i].Key() == AFTER)
 						++modlistPos2;
-						//std::clog << "Incremented modlistPos2: " << modlistPos2 << std::endl;
-					}
-					modlist.Insert(modlistPos2, mod);
-					//std::clog << "Mod inserted into position 2" << std::endl;
+					modlist.Splice(modlistPos2, modlistPos1, modlistPos1 + 1);  // This breaks all modlist iterators active.
 				} else if (lines[i].Key() == TOP || lines[i].Key() == BOTTOM) {
-					Item mod;
 					modlistPos1 = modlist.FindItem(ruleItem.Name(), MOD);
 					// Do checks.
 					if (ruleIter->Key() == ADD &&
-					    modlistPos1 == modlist.Items().size()) {
+					    modlistPos1 == modlist.Size()) {
 						bosslog.userRules << TABLE_ROW_CLASS_WARN << TABLE_DATA << *ruleIter << TABLE_DATA << "✗" << TABLE_DATA << VAR_OPEN << ruleIter->Object() << VAR_CLOSE << bloc::translate(" is not installed or in the masterlist.");
 						LOG_WARN(" * \"%s\" is not installed.",
 						         ruleIter->Object().c_str());
@@ -599,7 +716,7 @@ void Game::ApplyUserlist() {
 						continue;
 					} else if (ruleIter->Key() == OVERRIDE &&
 					          (modlistPos1 > modlist.LastRecognisedPos() ||
-					           modlistPos1 == modlist.Items().size())) {
+					           modlistPos1 == modlist.Size())) {
 						bosslog.userRules << TABLE_ROW_CLASS_ERROR << TABLE_DATA << *ruleIter << TABLE_DATA << "✗" << TABLE_DATA << VAR_OPEN << ruleIter->Object() << VAR_CLOSE << bloc::translate(" is not in the masterlist, cannot override.");
 						LOG_WARN(" * \"%s\" is not in the masterlist, cannot override.",
 						         ruleIter->Object().c_str());
@@ -612,21 +729,13 @@ void Game::ApplyUserlist() {
 						modlistPos2 = modlist.FindLastItem(lines[i].Object(),
 						                                   ENDGROUP);  // Find the end.
 					// Check that the sort group actually exists.
-					if (modlistPos2 == modlist.Items().size()) {
+					if (modlistPos2 >= modlist.Size()) {
 						bosslog.userRules << TABLE_ROW_CLASS_ERROR << TABLE_DATA << *ruleIter << TABLE_DATA << "✗" << TABLE_DATA << bloc::translate("The group ") << VAR_OPEN << lines[i].Object() << VAR_CLOSE << bloc::translate(" is not in the masterlist or is malformatted.");
 						LOG_WARN(" * \"%s\" is not in the masterlist, or is malformatted.",
 						         lines[i].Object().c_str());
 						continue;
 					}
-					mod = modlist.ItemAt(modlistPos1);  // Record the rule mod in a new variable.
-					modlist.Erase(modlistPos1);  // Now remove the rule mod from its old position. This breaks all modlist iterators active.
-					// Need to find group pos again, to fix iterators.
-					if (lines[i].Key() == TOP)
-						modlistPos2 = modlist.FindItem(lines[i].Object(), BEGINGROUP) + 1;  // Find the start, and increment by 1 so that mod is inserted after start.
-					else
-						modlistPos2 = modlist.FindLastItem(lines[i].Object(),
-						                                   ENDGROUP);  // Find the end.
-					modlist.Insert(modlistPos2, mod);  // Now insert the mod into the group. This breaks all modlist iterators active.
+					modlist.Splice(modlistPos2, modlistPos1, modlistPos1 + 1);  // Now move the mod into the group. This breaks all modlist iterators active.
 				}
 				//std::clog << "Incrementing i: ";
 				i++;
@@ -638,26 +747,20 @@ void Game::ApplyUserlist() {
 				// Find the mod which will have its messages edited.
 				modlistPos1 = modlist.FindItem(ruleItem.Name(), MOD);
 				//std::clog << "Found: " << ruleItem.Name() << std::endl;
-				if (modlistPos1 == modlist.Items().size()) {  // Rule mod isn't in the modlist (ie. not in masterlist or installed), so can neither add it nor override it.
+				if (modlistPos1 == modlist.Size()) {  // Rule mod isn't in the modlist (ie. not in masterlist or installed), so can neither add it nor override it.
 					bosslog.userRules << TABLE_ROW_CLASS_WARN << TABLE_DATA << *ruleIter << TABLE_DATA << "✗" << TABLE_DATA << VAR_OPEN << ruleIter->Object() << VAR_CLOSE << bloc::translate(" is not installed or in the masterlist.");
 					LOG_WARN(" * \"%s\" is not installed.",
 					         ruleIter->Object().c_str());
 					messageLineFail = true;
 					break;
 				}
-				std::vector<Item> items = modlist.Items();
 				if (lines[i].Key() == REPLACE)  // If the rule is to replace messages, clear existing messages.
-					items[modlistPos1].ClearMessages();
-				// Append message to message list of mod.
-				//std::clog << "Adding message to message list" << std::endl;
-				items[modlistPos1].InsertMessage(items[modlistPos1].Messages().size(),
-				                                 lines[i].ObjectAsMessage());
-				modlist.Items(items);
-				//std::clog << "Added message to message list" << std::endl;
+					modlist.ReplaceMessages(modlistPos1, lines[i].ObjectAsMessage());
+				else  // Append message to message list of mod.
+					modlist.AppendMessage(modlistPos1, lines[i].ObjectAsMessage());
 			}
 		} else if (lines[i].Key() == BEFORE || lines[i].Key() == AFTER) {  // Group: Can only sort.
 			//std::clog << "Found group" << std::endl;
-			std::vector<Item> group;
 			// Look for group to sort. Find start and end positions.
 			//std::clog << "Finding start for " << ruleItem.Name() << std::endl;
 			modlistPos1 = modlist.FindItem(ruleItem.Name(), BEGINGROUP);
@@ -665,8 +768,8 @@ void Game::ApplyUserlist() {
 			modlistPos2 = modlist.FindLastItem(ruleItem.Name(), ENDGROUP);
 			//std::clog << "Found start and end for " << ruleItem.Name() << std::endl;
 			// Check to see group actually exists.
-			if (modlistPos1 == modlist.Items().size() ||
-			    modlistPos2 == modlist.Items().size()) {
+			if (modlistPos1 == modlist.Size() ||
+			    modlistPos2 == modlist.Size()) {
 				bosslog.userRules << TABLE_ROW_CLASS_ERROR << TABLE_DATA << *ruleIter << TABLE_DATA << "✗" << TABLE_DATA << bloc::translate("The group ") << VAR_OPEN << ruleIter->Object() << VAR_CLOSE << bloc::translate(" is not in the masterlist or is malformatted.");
 				LOG_WARN(" * \"%s\" is not in the masterlist, or is malformatted.",
 				         ruleIter->Object().c_str());
@@ -674,20 +777,15 @@ void Game::ApplyUserlist() {
 			} else if (ruleItem.Name() == lastRecognisedItem.Name()) {  // Last recognised item is being moved. Set the item before the start of this group to the lastRecognisedItem.
 				lastRecognisedItem = modlist.ItemAt(modlistPos1 - 1);
 			}
-			// Copy the start, end and everything in between to a new variable.
-			std::vector<Item> items = modlist.Items();
-			group.assign(items.begin() + modlistPos1,
-			             items.begin() + modlistPos2 + 1);
-			// Now erase group from modlist.
-			modlist.Erase(modlistPos1, modlistPos2 + 1);
-			// Find the group to sort relative to and insert it before or after it as appropriate.
+			// Find the group to sort relative to. The group being moved stays in place until the target is known, so a failed rule needs no undo.
+			std::size_t groupEnd = modlistPos2 + 1;
 			if (lines[i].Key() == BEFORE)
 				modlistPos2 = modlist.FindItem(lines[i].Object(), BEGINGROUP);  // Find the start.
 			else
-				modlistPos2 = modlist.FindLastItem(lines[i].Object(), ENDGROUP);  // Find the end, and add one, as inserting works before the given element.
-			// Check that the sort group actually exists.
-			if (modlistPos2 == modlist.Items().size()) {
-				modlist.Insert(modlistPos1, group, 0, group.size());  // Insert the group back in its old position.
+				modlistPos2 = modlist.FindLastItem(lines[i].Object(), ENDGROUP);  // Find the end.
+			// Check that the sort group actually exists outside of the group being moved.
+			if (modlistPos2 == modlist.Size() ||
+			    (modlistPos2 >= modlistPos1 && modlistPos2 < groupEnd)) {
 				bosslog.userRules << TABLE_ROW_CLASS_ERROR << TABLE_DATA << *ruleIter << TABLE_DATA << "✗" << TABLE_DATA << bloc::translate("The group ") << VAR_OPEN << lines[i].Object() << VAR_CLOSE << bloc::translate(" is not in the masterlist or is malformatted.");
 				LOG_WARN(" * \"%s\" is not in the masterlist, or is malformatted.",
 				         lines[i].Object().c_str());
@@ -698,13 +796,14 @@ void Game::ApplyUserlist() {
 			}
 
 			if (lines[i].Key() == AFTER)
-				modlistPos2++;
-			// Now insert the group.
-			modlist.Insert(modlistPos2, group, 0, group.size());
+				modlistPos2++;  // Add one, as splicing works before the given element.
+			// Now move the group.
+			modlist.Splice(modlistPos2, modlistPos1, groupEnd);
 		}
 		//std::clog << "Checking if message line failed..." << std::endl;
 		if (!messageLineFail) {  // Print success message.
 			LOG_DEBUG("Rule #%" PRIuS " applied successfully.", ruleNo);
+			PROFILE_COUNT(PC_RULES_APPLIED, 1);
 			bosslog.userRules << TABLE_ROW_CLASS_SUCCESS << TABLE_DATA << *ruleIter << TABLE_DATA << "✓" << TABLE_DATA;
 			//std::clog << "Succeeded at: " << ruleNo << std::endl;
 		}
@@ -738,6 +837,7 @@ void Game::ApplyUserlist() {
 
 // Scans the data folder for script extender plugins and outputs their info to the bosslog.
 void Game::ScanSEPlugins() {
+	PROFILE_SCOPE("Game::ScanSEPlugins");
 	LOG_INFO("Looking for Script Extender...");
 	if (!fs::exists(SEExecutable())) {
 		LOG_DEBUG("Script Extender not detected.");
@@ -781,7 +881,9 @@ void Game::ScanSEPlugins() {
 }
 
 // Sorts the plugins in the data folder, changing timestamps or plugins.txt/loadorder.txt as required.
-void Game::SortPlugins() {
+void Game::SortPlugins(const bool trialRun, SortProgress progress,
+                       void *data) {
+	PROFILE_SCOPE("Game::SortPlugins");
 	// Get the master esm time.
 	std::time_t esmtime = MasterFile().GetModTime(*this);
 
@@ -789,16 +891,7 @@ void Game::SortPlugins() {
 	// Load active plugin list.
 	std::unordered_set<std::string> hashset;
 	if (fs::exists(ActivePluginsFile())) {
-		LOG_INFO("Loading plugins.txt into ItemList.");
-		ItemList pluginsList;
-		pluginsList.Load(*this, ActivePluginsFile());
-		std::vector<Item> pluginsEntries = pluginsList.Items();
-		std::size_t pluginsMax = pluginsEntries.size();
-		LOG_INFO("Populating hashset with ItemList contents.");
-		for (std::size_t i = 0; i < pluginsMax; i++) {
-			if (pluginsEntries[i].Type() == MOD)
-				hashset.insert(boost::to_lower_copy(pluginsEntries[i].Name()));
-		}
+		hashset = loadOrderState.ActiveSet(*this);
 		if (Id() == SKYRIM) {  // Update.esm and Skyrim.esm are always active.
 			if (hashset.find("skyrim.esm") == hashset.end())
 				hashset.insert("skyrim.esm");
@@ -842,41 +935,91 @@ void Game::SortPlugins() {
 	std::time_t modfiletime = 0;
 	items = modlist.Items();
 	std::unordered_set<std::string>::iterator setPos;
-	bosslog.recognisedPlugins.SetHTMLSpecialEscape(false);
-	bosslog.unrecognisedPlugins.SetHTMLSpecialEscape(false);
+	// Plugin entries are written straight into their log section, so give the sections the escaping a standalone buffer would have.
+	bosslog.recognisedPlugins.SetFormat(gl_log_format);
+	bosslog.unrecognisedPlugins.SetFormat(gl_log_format);
+
+	/*
+	 * In timestamp mode, find the plugins whose timestamps need to change before redating any. Each plugin is stated once, and only
+	 * those not already at their new times are written to, so a sort that changes nothing writes nothing. time_t is an integer number of
+	 * seconds, so adding 60 on increases it by a minute.
+	 */
+	std::vector<RedateJob> redates;
+	if (GetLoadOrderMethod() == LOMETHOD_TIMESTAMP && !trialRun) {
+		std::time_t firstTime = esmtime + (bosslog.recognised + bosslog.unrecognised) * 60;
+		for (std::size_t i = 0, max = items.size(); i < max; i++) {
+			if (items[i].IsGameMasterFile(*this))
+				continue;
+			RedateJob redate;
+			redate.pos = i;
+			redate.file = DataFolder() / items[i].Name();
+			redate.time = firstTime + i * 60;
+			PROFILE_COUNT(PC_FILES_STATED, 1);
+			std::time_t current = fs::last_write_time(redate.file, redate.error);
+			if (redate.error) {
+				fs::path ghost = DataFolder() / fs::path(items[i].Name() + ".ghost");
+				PROFILE_COUNT(PC_FILES_STATED, 1);
+				current = fs::last_write_time(ghost, redate.error);
+				if (!redate.error)
+					redate.file = ghost;
+			}
+			if (redate.error || current != redate.time) {
+				LOG_DEBUG(" -- Setting last modified time for file: \"%s\"",
+				          items[i].Name().c_str());
+				redate.error.clear();
+				redates.push_back(redate);
+			}
+		}
+		LOG_INFO("%" PRIuS " of %" PRIuS " plugins need redating.", redates.size(), items.size());
+	}
+	std::size_t nextRedate = 0;
+	Redater redater(redates);
 
 	LOG_INFO("Applying calculated ordering to user files...");
+	// Progress is reported, cancellation checked for, and plugins redated, once per batch of plugins.
+	const std::size_t progressBatch = 16;
+	std::size_t done = 0;
 	// MCP Note: Look at replacing this with a for-each loop?
 	for (std::vector<Item>::iterator itemIter = items.begin();
-	     itemIter != items.end(); ++itemIter) {
-		Outputter buffer(gl_log_format);
+	     itemIter != items.end(); ++itemIter, ++done) {
+		if (done % progressBatch == 0) {
+			if (progress != NULL && !progress(done, items.size(), data)) {
+				LOG_INFO("Sort cancelled after %" PRIuS " of %" PRIuS " plugins.", done, items.size());
+				throw boss_error(BOSS_ERROR_CANCELLED);
+			}
+			std::size_t batchEnd = nextRedate;
+			while (batchEnd < redates.size() && redates[batchEnd].pos < done + progressBatch)
+				batchEnd++;
+			redater.RunUntil(batchEnd);
+		}
+		bool isRecognised = unrecognised.find(itemIter->Name()) == unrecognised.end();
+		Outputter &buffer = isRecognised ? bosslog.recognisedPlugins : bosslog.unrecognisedPlugins;
 		buffer << LIST_ITEM << SPAN_CLASS_MOD_OPEN << itemIter->Name() << SPAN_CLOSE;
 		std::string version = itemIter->GetVersion(*this).AsString();
 		if (!version.empty())
 			buffer << SPAN_CLASS_VERSION_OPEN << bloc::translate("Version ") << version << SPAN_CLOSE;
-		if (hashset.find(boost::to_lower_copy(itemIter->Name())) != hashset.end())  // Plugin is active.
+		bool isActive = hashset.find(boost::to_lower_copy(itemIter->Name())) != hashset.end();
+		if (isActive)
 			buffer << SPAN_CLASS_ACTIVE_OPEN << bloc::translate("Active") << SPAN_CLOSE;
 		else
 			bosslog.inactive++;
-		if (gl_show_CRCs && itemIter->IsGhosted(*this)) {
-			buffer << SPAN_CLASS_CRC_OPEN << bloc::translate("Checksum: ") << IntToHexString(GetCrc32(DataFolder() / fs::path(itemIter->Name() + ".ghost"))) << SPAN_CLOSE;
-		} else if (gl_show_CRCs) {
-			buffer << SPAN_CLASS_CRC_OPEN << bloc::translate("Checksum: ") << IntToHexString(GetCrc32(DataFolder() / itemIter->Name())) << SPAN_CLOSE;
+		std::uint32_t crc = 0;
+		if (gl_show_CRCs) {
+			if (itemIter->IsGhosted(*this))
+				crc = pluginCache.Crc(DataFolder() / fs::path(itemIter->Name() + ".ghost"));
+			else
+				crc = pluginCache.Crc(DataFolder() / itemIter->Name());
+			buffer << SPAN_CLASS_CRC_OPEN << bloc::translate("Checksum: ") << IntToHexString(crc) << SPAN_CLOSE;
 		}
 
 		/*if (itemIter->IsFalseFlagged()) {
 			itemIter->InsertMessage(0, Message(WARN, "This plugin's internal master bit flag value does not match its file extension. This issue should be reported to the mod's author, and can be fixed by changing the file extension from .esp to .esm or vice versa."));
 			counters.warnings++;
 		}*/
-		if (GetLoadOrderMethod() == LOMETHOD_TIMESTAMP && !gl_trial_run &&
-		    !itemIter->IsGameMasterFile(*this)) {
-			// time_t is an integer number of seconds, so adding 60 on increases it by a minute.
-			// Using recModNo instead of i to avoid increases for group entries.
-			LOG_DEBUG(" -- Setting last modified time for file: \"%s\"",
-			          itemIter->Name().c_str());
-			try {
-				itemIter->SetModTime(*this, esmtime + (bosslog.recognised + bosslog.unrecognised) * 60);
-			} catch(boss_error &e) {
+		if (nextRedate < redates.size() && redates[nextRedate].pos == done) {
+			const RedateJob &redate = redates[nextRedate++];
+			if (redate.error) {
+				boss_error e(BOSS_ERROR_FS_FILE_MOD_TIME_WRITE_FAIL, itemIter->Name(), redate.error.message());
 				itemIter->InsertMessage(0, Message(ERR, bloc::translate("Error: ").str() + e.getString()));
 				LOG_ERROR(" * Error: %s", e.getString().c_str());
 			}
@@ -896,15 +1039,16 @@ void Game::SortPlugins() {
 			}
 			buffer << LIST_CLOSE;
 		}
-		if (unrecognised.find(itemIter->Name()) == unrecognised.end()) {  // Recognised plugin.
+		if (isRecognised) {
 			bosslog.recognised++;
-			bosslog.recognisedPlugins << buffer.AsString();
-		} else {  // Unrecognised plugin.
+			bosslog.RecordRecognised(*itemIter, version, isActive, crc);
+		} else {
 			bosslog.unrecognised++;
-			bosslog.unrecognisedPlugins << buffer.AsString();
 		}
 	}
 	LOG_INFO("User plugin ordering applied successfully.");
+	if (progress != NULL && !progress(done, items.size(), data))
+		throw boss_error(BOSS_ERROR_CANCELLED);
 
 	// Now set the load order using Skyrim method.
 	if (GetLoadOrderMethod() == LOMETHOD_TEXTFILE) {
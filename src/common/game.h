@@ -28,6 +28,7 @@
 #ifndef COMMON_GAME_H_
 #define COMMON_GAME_H_
 
+#include <cstddef>
 #include <cstdint>
 
 #include <string>
@@ -37,6 +38,8 @@
 
 #include "common/dll_def.h"
 #include "common/item_list.h"
+#include "common/load_order_state.h"
+#include "common/plugin_cache.h"
 #include "common/rule_line.h"
 #include "output/boss_log.h"
 
@@ -50,6 +53,9 @@ class Version;
 BOSS_COMMON extern const std::uint32_t LOMETHOD_TIMESTAMP;
 BOSS_COMMON extern const std::uint32_t LOMETHOD_TEXTFILE;
 
+// Called by Game::SortPlugins as it applies the sorted order, with the number of plugins done so far and the total. Returning false cancels the sort.
+typedef bool (*SortProgress)(std::size_t done, std::size_t total, void *data);
+
 BOSS_COMMON std::uint32_t DetectGame(std::vector<std::uint32_t> &detectedGames,
                                      std::vector<std::uint32_t> &undetectedGames);  // Throws exception if error.
 
@@ -82,6 +88,9 @@ class BOSS_COMMON Game {  // Constructor depends on gl_update_only.
 	boost::filesystem::path Modlist() const;
 	boost::filesystem::path OldModlist() const;
 	boost::filesystem::path Log(std::uint32_t format) const;
+	boost::filesystem::path Profile() const;  // Where --profile saves its timings.
+	boost::filesystem::path Trace() const;    // Where --trace saves its events by default.
+	boost::filesystem::path WatchSocket() const;  // Where --watch listens for commands.
 
 	// Creates directory in BOSS folder for BOSS's game-specific files.
 	void CreateBOSSGameFolder();
@@ -96,12 +105,17 @@ class BOSS_COMMON Game {  // Constructor depends on gl_update_only.
 	void ScanSEPlugins();
 
 	// Sorts the plugins in the data folder, changing timestamps or plugins.txt/loadorder.txt as required. Alters bosslog.
-	void SortPlugins();
+	// If trialRun is true, timestamps are left alone. If progress is given, it is called between batches of plugins, and if it returns false
+	// the sort stops there and throws BOSS_ERROR_CANCELLED. Plugins already redated keep their new timestamps, but loadorder.txt and plugins.txt are left unwritten.
+	void SortPlugins(const bool trialRun, SortProgress progress = NULL,
+	                 void *data = NULL);
 
 	ItemList modlist;
 	ItemList masterlist;
 	RuleList userlist;
 	BossLog bosslog;
+	mutable LoadOrderState loadOrderState;  // Read by const consumers, so mutable.
+	mutable PluginCache pluginCache;        // Likewise. Kept across sorts of the same game.
 
  private:
 	// Can be used to get the location of the LOCALAPPDATA folder (and its Windows XP equivalent).
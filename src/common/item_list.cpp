@@ -56,6 +56,7 @@
 #include "support/helpers.h"
 #include "support/logger.h"
 #include "support/platform.h"
+#include "support/profiler.h"
 
 namespace boss {
 
@@ -92,6 +93,7 @@ struct itemComparator {
 ItemList::ItemList() : lastRecognisedPos(0) {}
 
 void ItemList::Load(const Game &parentGame, const fs::path path) {
+	PROFILE_SCOPE("ItemList::Load");
 	Clear();
 	if (fs::exists(path) && fs::is_directory(path)) {
 		LOG_DEBUG("Reading user mods...");
@@ -141,6 +143,7 @@ void ItemList::Load(const Game &parentGame, const fs::path path) {
 		// Now scan through Data folder. Add any plugins that aren't already in loadorder to loadorder, at the end.
 		for (fs::directory_iterator itr(path); itr != fs::directory_iterator();
 		     ++itr) {
+			PROFILE_COUNT(PC_FILES_STATED, 1);
 			if (fs::is_regular_file(itr->status())) {
 				fs::path filename = itr->path().filename();
 				std::string ext = filename.extension().string();
@@ -168,38 +171,14 @@ void ItemList::Load(const Game &parentGame, const fs::path path) {
 		std::sort(items.begin(), items.end(), ic);
 	} else if (path == parentGame.LoadOrderFile() ||
 	           path == parentGame.ActivePluginsFile()) {
-		// loadorder.txt is simple enough that we can avoid needing the full modlist parser which has the crashing issue.
-		// It's just a text file with a plugin filename on each line. Skip lines which are blank or start with '#'.
-
-		// MCP Note: changed from path.c_str() to path.string(); needs testing as error was about not being able to convert wchar_t to char
-		//std::ifstream in(path.c_str());
-		//std::ifstream in(path.string());
-		boss_fstream::ifstream in(path);
-		if (in.fail())
-			throw boss_error(BOSS_ERROR_FILE_PARSE_FAIL, path.string());
-
-		std::string line;
-		while (in.good()) {
-			std::getline(in, line);
-
-			if (line.empty() || line[0] == '#')  // Character comparison is OK because it's ASCII.
-				continue;
-
-			if (path == parentGame.ActivePluginsFile())
-				line = From1252ToUTF8(line);
-			items.push_back(Item(line));
-		}
-		in.close();
-
-
-		// Then scan through items, removing any plugins that aren't in the data folder.
-		std::vector<Item>::iterator itemIter = items.begin();
-		while (itemIter != items.end()) {
-			if (!itemIter->Exists(parentGame))
-				itemIter = items.erase(itemIter);
-			else
-				++itemIter;
-		}
+		// loadorder.txt and plugins.txt are read once and shared through the game's LoadOrderState.
+		std::vector<std::string> plugins;
+		if (path == parentGame.ActivePluginsFile())
+			plugins = parentGame.loadOrderState.ActivePlugins(parentGame);
+		else
+			plugins = parentGame.loadOrderState.LoadOrder(parentGame);
+		for (std::size_t i = 0, max = plugins.size(); i < max; i++)
+			items.push_back(Item(plugins[i]));
 
 		itemComparator ic(parentGame);
 		std::sort(items.begin(), items.end(), ic);  // Does this work?
@@ -296,47 +275,42 @@ void ItemList::SavePluginNames(const Game &parentGame,
                                const bool activeOnly,
                                const bool doEncodingConversion) {
 	std::string badFilename = "", contents;
-	ItemList activePlugins;
-	std::size_t numActivePlugins;
+	std::unordered_set<std::string> activePlugins;  // Lowercased, as plugin names are case-insensitive.
 	if (activeOnly) {
-		// To save needing a new parser, load plugins.txt into an ItemList then fill a hashset from that.
-		// Also check if gl_current_game.ActivePluginsFile() then detect encoding if it is and translate outputted text from UTF-8 to the detected encoding.
-		LOG_INFO("Loading plugins.txt into ItemList.");
-		if (fs::exists(parentGame.ActivePluginsFile())) {
-			activePlugins.Load(parentGame, parentGame.ActivePluginsFile());
-			numActivePlugins = activePlugins.Items().size();
-		}
+		LOG_INFO("Getting active plugins.");
+		activePlugins = parentGame.loadOrderState.ActiveSet(parentGame);
 	}
 
-	LOG_INFO("Writing new \"%s\"", file.string().c_str());
-	//ofstream outfile;
-	//std::ofstream outfile;
-	boss_fstream::ofstream outfile;
-
-	// MCP Note: changed from file.c_str() to file.string(); needs testing as error was about not being able to convert wchar_t to char
-	outfile.open(file, std::ios_base::trunc);
-	if (outfile.fail())
-		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
-
+	// Build the whole file, then write it in one go.
+#if _WIN32 || _WIN64
+	const char *lineEnd = "\r\n";
+#else
+	const char *lineEnd = "\n";
+#endif
 	std::size_t max = items.size();
 	for (std::size_t i = 0; i < max; i++) {
 		if (items[i].Type() == MOD) {
-			if (activeOnly && (activePlugins.FindItem(items[i].Name(), MOD) == numActivePlugins || (parentGame.Id() == SKYRIM && items[i].Name() == "Skyrim.esm")))
+			if (activeOnly && (activePlugins.find(boost::to_lower_copy(items[i].Name())) == activePlugins.end() || (parentGame.Id() == SKYRIM && items[i].Name() == "Skyrim.esm")))
 				continue;
 			LOG_DEBUG("Writing \"%s\" to \"%s\"", items[i].Name().c_str(),
 			          file.string().c_str());
 			if (doEncodingConversion) {  // Not UTF-8.
 				try {
-					outfile << FromUTF8To1252(items[i].Name()) << std::endl;
+					contents += FromUTF8To1252(items[i].Name()) + lineEnd;
 				} catch (boss_error /*&e*/) {
 					badFilename = items[i].Name();
 				}
 			} else {
-				outfile << items[i].Name() << std::endl;
+				contents += items[i].Name() + lineEnd;
 			}
 		}
 	}
-	outfile.close();
+
+	LOG_INFO("Writing new \"%s\"", file.string().c_str());
+	bufferToFile(file, contents);
+	if (file == parentGame.LoadOrderFile() ||
+	    file == parentGame.ActivePluginsFile())
+		parentGame.loadOrderState.Invalidate();
 
 	if (!badFilename.empty())
 		throw boss_error(BOSS_ERROR_ENCODING_CONVERSION_FAIL, badFilename,
@@ -344,18 +318,12 @@ void ItemList::SavePluginNames(const Game &parentGame,
 }
 
 void ItemList::EvalConditions(const Game &parentGame) {
+	PROFILE_SCOPE("ItemList::EvalConditions");
 	std::unordered_set<std::string> setVars;
 	std::unordered_set<std::string> activePlugins;
 	bool res;
 
-	if (fs::exists(parentGame.ActivePluginsFile())) {
-		ItemList active;
-		active.Load(parentGame, parentGame.ActivePluginsFile());
-		std::vector<Item> items = active.Items();
-		for (std::size_t i = 0, max = items.size(); i < max; i++) {
-			activePlugins.insert(boost::to_lower_copy(items[i].Name()));
-		}
-	}
+	activePlugins = parentGame.loadOrderState.ActiveSet(parentGame);
 
 	// First eval variables.
 	// Need to convert these from a vector to an unordered set.
@@ -441,11 +409,13 @@ void ItemList::EvalConditions(const Game &parentGame) {
 }
 
 void ItemList::EvalRegex(const Game &parentGame) {
+	PROFILE_SCOPE("ItemList::EvalRegex");
 	// Store installed mods in a hashset. Case insensitivity not required as regex itself is case-insensitive.
 	std::unordered_set<std::string> hashset;
 	std::unordered_set<std::string>::iterator setPos;
 	for (fs::directory_iterator itr(parentGame.DataFolder());
 	     itr != fs::directory_iterator(); ++itr) {
+		PROFILE_COUNT(PC_FILES_STATED, 1);
 		if (fs::is_regular_file(itr->status())) {
 			fs::path filename = itr->path().filename();
 			std::string ext = filename.extension().string();
@@ -469,6 +439,7 @@ void ItemList::EvalRegex(const Game &parentGame) {
 			//std::regex reg;  // Form a regex.
 			// TODO(MCP): Swap out Boost Regex for STL Regex once the infinite loop that occurs with VS is sorted out
 			boss_regex::regex reg;  // Form a regex.
+			PROFILE_COUNT(PC_REGEXES_COMPILED, 1);
 			try {
 				//reg = std::regex(itemIter->Name()+"(\\.ghost)?",
 				                   //std::regex::ECMAScript|std::regex::icase);  // Ghost extension is added so ghosted mods will also be found.
@@ -602,6 +573,10 @@ Item ItemList::ItemAt(const std::size_t pos) const {
 	return Item();
 }
 
+std::size_t ItemList::Size() const {
+	return items.size();
+}
+
 void ItemList::Items(const std::vector<Item> inItems) {
 	items = inItems;
 }
@@ -668,6 +643,28 @@ void ItemList::Move(std::size_t newPos, const Item item) {
 	}
 }
 
+void ItemList::Splice(const std::size_t newPos,
+                      const std::size_t startPos,
+                      const std::size_t endPos) {
+	// Rotating only touches the span between the range and its destination,
+	// so moving a group a short distance doesn't shift the rest of the list.
+	if (newPos < startPos)
+		std::rotate(items.begin() + newPos, items.begin() + startPos,
+		            items.begin() + endPos);
+	else if (newPos > endPos)
+		std::rotate(items.begin() + startPos, items.begin() + endPos,
+		            items.begin() + newPos);
+}
+
+void ItemList::AppendMessage(const std::size_t pos, const Message message) {
+	items[pos].InsertMessage(items[pos].Messages().size(), message);
+}
+
+void ItemList::ReplaceMessages(const std::size_t pos, const Message message) {
+	items[pos].ClearMessages();
+	items[pos].InsertMessage(0, message);
+}
+
 // Searches a hashset for the first matching string of a regex and returns its iterator position. Usage internal to BOSS-Common.
 std::unordered_set<std::string>::iterator ItemList::FindRegexMatch(
     const std::unordered_set<std::string> set,
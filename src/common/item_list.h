@@ -80,6 +80,7 @@ class BOSS_COMMON ItemList {
 	                             std::size_t currPos) const;     // Can throw exception.
 
 	Item ItemAt(std::size_t pos) const;
+	std::size_t Size() const;  // Number of items. Cheaper than Items().size(), which copies the whole list.
 
 	std::vector<Item> Items() const;
 	ParsingError ErrorBuffer() const;
@@ -102,6 +103,11 @@ class BOSS_COMMON ItemList {
 	            std::size_t sourceStart, std::size_t sourceEnd);
 	void Insert(const std::size_t pos, const Item item);
 	void Move(std::size_t newPos, const Item item);  // Adds the item if it isn't already present.
+	void Splice(const std::size_t newPos, const std::size_t startPos,
+	            const std::size_t endPos);                      // Moves the range [startPos, endPos) so that it starts before the item currently at newPos.
+	                                                            // Only the items between the old and new positions are shifted.
+	void AppendMessage(const std::size_t pos, const Message message);    // Appends a message to the item at pos in place.
+	void ReplaceMessages(const std::size_t pos, const Message message);  // Replaces all messages of the item at pos with the given message in place.
 
  private:
 	// Searches a hashset for the first matching string of a
@@ -0,0 +1,164 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 3135 $, $Date: 2011-08-17 22:01:17 +0100 (Wed, 17 Aug 2011) $
+*/
+
+#include "common/load_order_state.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "base/fstream.h"
+#include "common/conditional_data.h"
+#include "common/error.h"
+#include "common/game.h"
+#include "support/helpers.h"
+#include "support/logger.h"
+#include "support/platform.h"
+
+namespace boss {
+
+namespace fs = boost::filesystem;
+
+//////////////////////////////
+// LoadOrderState Class Functions
+//////////////////////////////
+
+LoadOrderState::File::File()
+    : read(false), exists(false), contentsHash(0), dataModTime(0) {}
+
+LoadOrderState::LoadOrderState() {}
+
+LoadOrderState::LoadOrderState(const LoadOrderState & /*other*/) {}
+
+LoadOrderState &LoadOrderState::operator=(const LoadOrderState &other) {
+	if (this != &other)
+		Invalidate();
+	return *this;
+}
+
+std::vector<std::string> LoadOrderState::LoadOrder(const Game &parentGame) {
+	std::lock_guard<std::mutex> guard(mutex);
+	Refresh(parentGame, parentGame.LoadOrderFile(), false, loadOrder);
+	if (!loadOrder.exists)
+		throw boss_error(BOSS_ERROR_FILE_PARSE_FAIL,
+		                 parentGame.LoadOrderFile().string());
+	return loadOrder.plugins;
+}
+
+std::vector<std::string> LoadOrderState::ActivePlugins(const Game &parentGame) {
+	std::lock_guard<std::mutex> guard(mutex);
+	Refresh(parentGame, parentGame.ActivePluginsFile(), true, activePlugins);
+	if (!activePlugins.exists)
+		throw boss_error(BOSS_ERROR_FILE_PARSE_FAIL,
+		                 parentGame.ActivePluginsFile().string());
+	return activePlugins.plugins;
+}
+
+std::unordered_set<std::string> LoadOrderState::ActiveSet(const Game &parentGame) {
+	std::lock_guard<std::mutex> guard(mutex);
+	Refresh(parentGame, parentGame.ActivePluginsFile(), true, activePlugins);
+	return activePlugins.folded;
+}
+
+bool LoadOrderState::IsActive(const Game &parentGame,
+                              const std::string &plugin) {
+	std::lock_guard<std::mutex> guard(mutex);
+	Refresh(parentGame, parentGame.ActivePluginsFile(), true, activePlugins);
+	return activePlugins.folded.find(boost::to_lower_copy(plugin)) != activePlugins.folded.end();
+}
+
+void LoadOrderState::Invalidate() {
+	std::lock_guard<std::mutex> guard(mutex);
+	loadOrder.read = false;
+	activePlugins.read = false;
+}
+
+void LoadOrderState::Refresh(const Game &parentGame, const fs::path &path,
+                             const bool isActivePlugins, File &file) {
+	// The file is small, so it's compared by its contents rather than by its
+	// timestamp, which only has whole seconds and would miss quick rewrites.
+	std::string contents;
+	boost::system::error_code ec;
+	bool exists = fs::exists(path, ec);
+	if (exists) {
+		boss_fstream::ifstream in(path);
+		if (in.fail())
+			throw boss_error(BOSS_ERROR_FILE_PARSE_FAIL, path.string());
+		contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		in.close();
+	}
+	std::size_t contentsHash = boost::hash_value(contents);
+	std::uint64_t dataModTime = GetPreciseModTime(parentGame.DataFolder());
+
+	if (file.read && file.exists == exists && file.contentsHash == contentsHash &&
+	    file.dataModTime == dataModTime)
+		return;
+
+	file.read = false;
+	file.plugins.clear();
+	file.folded.clear();
+	file.exists = exists;
+	file.contentsHash = contentsHash;
+	file.dataModTime = dataModTime;
+
+	if (exists) {
+		LOG_INFO("Reading \"%s\".", path.string().c_str());
+		// Just a plugin filename on each line. Skip lines which are blank or start with '#'.
+		std::istringstream in(contents);
+		std::string line;
+		while (in.good()) {
+			std::getline(in, line);
+
+			if (line.empty() || line[0] == '#')  // Character comparison is OK because it's ASCII.
+				continue;
+
+			if (isActivePlugins)
+				line = From1252ToUTF8(line);
+			// Skip plugins that aren't in the data folder.
+			if (!Item(line).Exists(parentGame))
+				continue;
+			file.plugins.push_back(line);
+			file.folded.insert(boost::to_lower_copy(line));
+		}
+		LOG_DEBUG("Read %" PRIuS " installed plugins from \"%s\".",
+		          file.plugins.size(), path.string().c_str());
+	}
+	file.read = true;
+}
+
+}  // namespace boss
@@ -0,0 +1,95 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 3135 $, $Date: 2011-08-17 22:01:17 +0100 (Wed, 17 Aug 2011) $
+*/
+
+#ifndef COMMON_LOAD_ORDER_STATE_H_
+#define COMMON_LOAD_ORDER_STATE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "common/dll_def.h"
+
+namespace boss {
+
+class BOSS_COMMON Game;
+
+//////////////////////////////
+// LoadOrderState Class
+//////////////////////////////
+
+// Holds the contents of a game's loadorder.txt and plugins.txt, so that every
+// consumer shares one parse of each file. A file is re-parsed after Invalidate(),
+// which everything that writes the files calls, or if its contents, or the data
+// folder's timestamp, have changed since it was parsed.
+// Thread-safe. Copies start out empty.
+class BOSS_COMMON LoadOrderState {
+ public:
+	LoadOrderState();
+	LoadOrderState(const LoadOrderState &other);
+	LoadOrderState &operator=(const LoadOrderState &other);
+
+	// Installed plugins listed in the file, in file order. Throw if the file can't be read.
+	std::vector<std::string> LoadOrder(const Game &parentGame);
+	std::vector<std::string> ActivePlugins(const Game &parentGame);  // Converted to UTF-8.
+
+	// Lowercased names of installed plugins listed in plugins.txt. Empty if the file doesn't exist.
+	std::unordered_set<std::string> ActiveSet(const Game &parentGame);
+	bool IsActive(const Game &parentGame, const std::string &plugin);  // Case-insensitive.
+
+	void Invalidate();
+
+ private:
+	struct File {
+		File();
+
+		bool read;
+		bool exists;
+		std::size_t contentsHash;
+		std::uint64_t dataModTime;  // In the platform's own units, which are finer than seconds.
+		std::vector<std::string> plugins;
+		std::unordered_set<std::string> folded;
+	};
+
+	// Re-reads the file into 'file' if it has changed. Must hold the mutex.
+	void Refresh(const Game &parentGame,
+	             const boost::filesystem::path &path,
+	             const bool isActivePlugins, File &file);
+
+	std::mutex mutex;
+	File loadOrder;
+	File activePlugins;
+};
+
+}  // namespace boss
+#endif  // COMMON_LOAD_ORDER_STATE_H_
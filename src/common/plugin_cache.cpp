@@ -0,0 +1,138 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 3135 $, $Date: 2011-08-17 22:01:17 +0100 (Wed, 17 Aug 2011) $
+*/
+
+
+#include "common/plugin_cache.h"
+
+#include <cstdint>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/filesystem.hpp>
+
+#include "support/helpers.h"
+#include "support/mod_format.h"
+
+namespace boss {
+
+namespace fs = boost::filesystem;
+
+//////////////////////////////
+// PluginCache Class Functions
+//////////////////////////////
+
+PluginCache::Entry::Entry()
+    : size(0), modTime(0), masterRead(false), isMaster(false),
+      versionRead(false), crcRead(false), crc(0) {}
+
+PluginCache::PluginCache() {}
+
+PluginCache::PluginCache(const PluginCache & /*other*/) {}
+
+PluginCache &PluginCache::operator=(const PluginCache &other) {
+	if (this != &other)
+		Clear();
+	return *this;
+}
+
+// The file is read without holding the mutex, so that reading one plugin
+// doesn't hold up lookups of others. It's stat'ed first, so a change made
+// while it's being read gives it a new size or time and so isn't missed.
+bool PluginCache::IsMaster(const fs::path &file) {
+	boost::system::error_code ec;
+	std::uintmax_t size = fs::file_size(file, ec);
+	std::uint64_t modTime = GetPreciseModTime(file);
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		Entry &entry = GetEntry(file, size, modTime);
+		if (entry.masterRead)
+			return entry.isMaster;
+	}
+	bool isMaster = IsPluginMaster(file);
+	std::lock_guard<std::mutex> guard(mutex);
+	Entry &entry = GetEntry(file, size, modTime);
+	entry.isMaster = isMaster;
+	entry.masterRead = true;
+	return isMaster;
+}
+
+std::string PluginCache::HeaderVersion(const fs::path &file) {
+	boost::system::error_code ec;
+	std::uintmax_t size = fs::file_size(file, ec);
+	std::uint64_t modTime = GetPreciseModTime(file);
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		Entry &entry = GetEntry(file, size, modTime);
+		if (entry.versionRead)
+			return entry.version;
+	}
+	std::string version = ReadHeader(file).Version;
+	std::lock_guard<std::mutex> guard(mutex);
+	Entry &entry = GetEntry(file, size, modTime);
+	entry.version = version;
+	entry.versionRead = true;
+	return version;
+}
+
+std::uint32_t PluginCache::Crc(const fs::path &file) {
+	boost::system::error_code ec;
+	std::uintmax_t size = fs::file_size(file, ec);
+	std::uint64_t modTime = GetPreciseModTime(file);
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		Entry &entry = GetEntry(file, size, modTime);
+		if (entry.crcRead)
+			return entry.crc;
+	}
+	std::uint32_t crc = GetCrc32(file);
+	std::lock_guard<std::mutex> guard(mutex);
+	Entry &entry = GetEntry(file, size, modTime);
+	entry.crc = crc;
+	entry.crcRead = true;
+	return crc;
+}
+
+void PluginCache::Clear() {
+	std::lock_guard<std::mutex> guard(mutex);
+	entries.clear();
+}
+
+PluginCache::Entry &PluginCache::GetEntry(const fs::path &file,
+                                          const std::uintmax_t size,
+                                          const std::uint64_t modTime) {
+	Entry &entry = entries[file.string()];
+	if (entry.size != size || entry.modTime != modTime) {
+		entry = Entry();
+		entry.size = size;
+		entry.modTime = modTime;
+	}
+	return entry;
+}
+
+}  // namespace boss
@@ -0,0 +1,89 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 3135 $, $Date: 2011-08-17 22:01:17 +0100 (Wed, 17 Aug 2011) $
+*/
+
+
+#ifndef COMMON_PLUGIN_CACHE_H_
+#define COMMON_PLUGIN_CACHE_H_
+
+#include <cstdint>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/filesystem.hpp>
+
+#include "common/dll_def.h"
+
+namespace boss {
+
+//////////////////////////////
+// PluginCache Class
+//////////////////////////////
+
+// Holds what has been read from each plugin file: its master flag, the version
+// in its header and its CRC, so that sorting again doesn't read them again.
+// Each is read when first asked for, and a file's are all dropped once its size
+// or modification time has changed. Thread-safe. Copies start out empty.
+class BOSS_COMMON PluginCache {
+ public:
+	PluginCache();
+	PluginCache(const PluginCache &other);
+	PluginCache &operator=(const PluginCache &other);
+
+	// Each takes the path of the plugin's file, including any ghost extension.
+	bool IsMaster(const boost::filesystem::path &file);
+	std::string HeaderVersion(const boost::filesystem::path &file);  // Empty if the header has none.
+	std::uint32_t Crc(const boost::filesystem::path &file);
+
+	void Clear();
+
+ private:
+	struct Entry {
+		Entry();
+
+		std::uintmax_t size;
+		std::uint64_t modTime;
+		bool masterRead;
+		bool isMaster;
+		bool versionRead;
+		std::string version;
+		bool crcRead;
+		std::uint32_t crc;
+	};
+
+	// Gets the file's entry, emptied if the file has changed since it was
+	// filled. Must hold the mutex.
+	Entry &GetEntry(const boost::filesystem::path &file,
+	                const std::uintmax_t size, const std::uint64_t modTime);
+
+	std::mutex mutex;
+	std::unordered_map<std::string, Entry> entries;  // Keyed by the file's path.
+};
+
+}  // namespace boss
+#endif  // COMMON_PLUGIN_CACHE_H_
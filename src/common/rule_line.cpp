@@ -31,8 +31,10 @@
 #include <cstdint>
 
 #include <fstream>
+#include <algorithm>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
@@ -48,6 +50,7 @@
 #include "parsing/grammar.h"
 #include "support/helpers.h"
 #include "support/logger.h"
+#include "support/profiler.h"
 
 namespace boss {
 
@@ -208,6 +211,82 @@ RuleLine Rule::LineAt(const std::size_t pos) const {
 	return RuleLine();
 }
 
+void Rule::CheckSyntax(const Game &parentGame) const {
+	if (!fs::exists(parentGame.DataFolder() / Object()) && !fs::exists(parentGame.DataFolder() / Object() / fs::path(Object() + ".ghost")))
+		return;
+	std::string ruleKeyString = KeyToString();
+	Item ruleObject = Item(Object());
+	if (ruleObject.IsPlugin()) {
+		if (ruleKeyString != "FOR" &&
+		    ruleObject.IsGameMasterFile(parentGame))
+			throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingMasterEsm).str());
+	} else {
+		if (boost::iequals(ruleObject.Name(), "esms"))
+			throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingGroupEsms).str());
+		if (ruleKeyString == "ADD")
+			throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EAddingModGroup).str());
+		else if (ruleKeyString == "FOR")
+			throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EAttachingMessageToGroup).str());
+	}
+	bool hasSortLine = false, hasReplaceLine = false;
+	for (std::size_t i = 0, max = lines.size(); i < max; i++) {
+		Item subject = Item(lines[i].Object());
+		if (lines[i].Key() == BEFORE || lines[i].Key() == AFTER) {
+			if (hasSortLine)
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EMultipleSortLines).str());
+			if (i != 0)
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortNotSecond).str());
+			if (ruleKeyString == "FOR")
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortLineInForRule).str());
+			if (boost::iequals(ruleObject.Name(), subject.Name()))
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingToItself).str());
+			if ((ruleObject.IsPlugin() && !subject.IsPlugin()) ||
+			    (!ruleObject.IsPlugin() && subject.IsPlugin()))
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EReferencingModAndGroup).str());
+			if (lines[i].Key() == BEFORE) {
+				if (boost::iequals(subject.Name(), "esms"))
+					throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingGroupBeforeEsms).str());
+				else if (subject.IsGameMasterFile(parentGame))
+					throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingModBeforeGameMaster).str());
+				else if (!ruleObject.IsMasterFile(parentGame) &&
+				         subject.IsMasterFile(parentGame))
+					throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingPluginBeforeMaster).str());
+			} else if (ruleObject.IsMasterFile(parentGame) &&
+			           !subject.IsMasterFile(parentGame)) {
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingMasterAfterPlugin).str());
+			}
+			hasSortLine = true;
+		} else if (lines[i].Key() == TOP || lines[i].Key() == BOTTOM) {
+			if (hasSortLine)
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EMultipleSortLines).str());
+			if (i != 0)
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortNotSecond).str());
+			if (ruleKeyString == "FOR")
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortLineInForRule).str());
+			if (lines[i].Key() == TOP &&
+			    boost::iequals(subject.Name(), "esms"))
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EInsertingToTopOfEsms).str());
+			if (!ruleObject.IsPlugin() || subject.IsPlugin())
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EInsertingGroupOrIntoMod).str());
+			hasSortLine = true;
+		} else if (lines[i].Key() == APPEND ||
+		           lines[i].Key() == REPLACE) {
+			if (!ruleObject.IsPlugin())
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EAttachingMessageToGroup).str());
+			if (lines[i].Key() == REPLACE) {
+				if (hasReplaceLine)
+					throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EMultipleReplaceLines).str());
+				if ((ruleKeyString == "FOR" && i != 0) ||
+				    (ruleKeyString != "FOR" && i != 1))
+					throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EReplaceNotFirst).str());
+				hasReplaceLine = true;
+			}
+			if (!lines[i].IsObjectMessage())
+				throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EAttachingNonMessage).str());
+		}
+	}
+}
+
 void Rule::Enabled(const bool e) {
 	enabled = e;
 }
@@ -227,6 +306,7 @@ RuleList::RuleList() {
 }
 
 void RuleList::Load(const Game &parentGame, const fs::path file) {
+	PROFILE_SCOPE("RuleList::Load");
 	Skipper skipper;
 	userlist_grammar grammar;
 	std::string::const_iterator begin, end;
@@ -236,6 +316,7 @@ void RuleList::Load(const Game &parentGame, const fs::path file) {
 
 	skipper.SkipIniComments(false);
 	grammar.SetErrorBuffer(&errorBuffer);
+	grammar.SetParentGame(&parentGame);
 
 	if (!fs::exists(file)) {
 		// MCP Note: changed from file.c_str() to file.string(); needs testing as error was about not being able to convert wchar_t to char
@@ -260,7 +341,7 @@ void RuleList::Load(const Game &parentGame, const fs::path file) {
 	if (!r || begin != end)  // This might not work correctly.
 		throw boss_error(BOSS_ERROR_FILE_PARSE_FAIL, file.string());
 
-	CheckSyntax(parentGame);
+	BuildIndex();
 }
 
 void RuleList::Save(const fs::path file) {
@@ -291,15 +372,15 @@ void RuleList::Save(const fs::path file) {
 
 std::size_t RuleList::FindRule(const std::string ruleObject,
                                const bool onlyEnabled) const {
-	std::size_t max = rules.size();
-	for (std::size_t i = 0; i < max; i++) {
-		// TODO(MCP): Move !onlyEnabled to front of if-statement to take advantage of short-cirtuit evaluation.
-		if ((onlyEnabled && rules[i].Enabled()) || !onlyEnabled) {
-			if (boost::iequals(rules[i].Object(), ruleObject))
-				return i;
-		}
+	std::unordered_map<std::string, std::vector<std::size_t> >::const_iterator it = ruleIndex.find(boost::to_lower_copy(ruleObject));
+	if (it == ruleIndex.end())
+		return rules.size();
+	for (std::vector<std::size_t>::const_iterator posIter = it->second.begin();
+	     posIter != it->second.end(); ++posIter) {
+		if (!onlyEnabled || rules[*posIter].Enabled())
+			return *posIter;
 	}
-	return max;
+	return rules.size();
 }
 
 std::vector<Rule> RuleList::Rules() const {
@@ -316,8 +397,13 @@ Rule RuleList::RuleAt(const std::size_t pos) const {
 	return Rule();
 }
 
+std::size_t RuleList::Size() const {
+	return rules.size();
+}
+
 void RuleList::Rules(const std::vector<Rule> inRules) {
 	rules = inRules;
+	BuildIndex();
 }
 
 void RuleList::ErrorBuffer(const std::vector<ParsingError> buffer) {
@@ -325,109 +411,58 @@ void RuleList::ErrorBuffer(const std::vector<ParsingError> buffer) {
 }
 
 void RuleList::Erase(const std::size_t pos) {
+	std::vector<std::size_t> &positions = ruleIndex[boost::to_lower_copy(rules[pos].Object())];
+	positions.erase(std::find(positions.begin(), positions.end(), pos));
+	if (positions.empty())
+		ruleIndex.erase(boost::to_lower_copy(rules[pos].Object()));
 	rules.erase(rules.begin() + pos);
+	ShiftIndex(pos, false);
 }
 
 void RuleList::Insert(const std::size_t pos, const Rule rule) {
 	rules.insert(rules.begin() + pos, rule);
+	ShiftIndex(pos, true);
+	std::vector<std::size_t> &positions = ruleIndex[boost::to_lower_copy(rule.Object())];
+	positions.insert(std::lower_bound(positions.begin(), positions.end(), pos), pos);
 }
 
 void RuleList::Replace(const std::size_t pos, const Rule rule) {
-	if (pos < rules.size())
-		rules[pos] = rule;
+	if (pos >= rules.size())
+		return;
+	std::string oldKey = boost::to_lower_copy(rules[pos].Object());
+	std::string newKey = boost::to_lower_copy(rule.Object());
+	rules[pos] = rule;
+	if (oldKey == newKey)
+		return;
+	std::vector<std::size_t> &oldPositions = ruleIndex[oldKey];
+	oldPositions.erase(std::find(oldPositions.begin(), oldPositions.end(), pos));
+	if (oldPositions.empty())
+		ruleIndex.erase(oldKey);
+	std::vector<std::size_t> &newPositions = ruleIndex[newKey];
+	newPositions.insert(std::lower_bound(newPositions.begin(), newPositions.end(), pos), pos);
 }
 
 void RuleList::Clear() {
 	rules.clear();
 	errorBuffer.clear();
+	ruleIndex.clear();
 }
 
-void RuleList::CheckSyntax(const Game &parentGame) {
-	// Loop through rules, check syntax of each. If a rule has invalid syntax, remove it.
-	std::vector<Rule>::iterator it = rules.begin();
-	while(it != rules.end()) {
-		std::string ruleKeyString = it->KeyToString();
-		if(!fs::exists(parentGame.DataFolder() / it->Object()) && !fs::exists(parentGame.DataFolder() / it->Object() / fs::path(it->Object() + ".ghost"))) {
-			++it;
-			continue;
-		}
-		Item ruleObject = Item(it->Object());
-		try {
-			if (ruleObject.IsPlugin()) {
-				if (ruleKeyString != "FOR" &&
-				    ruleObject.IsGameMasterFile(parentGame))
-					throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingMasterEsm).str());
-			} else {
-				if (boost::iequals(ruleObject.Name(), "esms"))
-					throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingGroupEsms).str());
-				if (ruleKeyString == "ADD")
-					throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EAddingModGroup).str());
-				else if (ruleKeyString == "FOR")
-					throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EAttachingMessageToGroup).str());
-			}
-			std::vector<RuleLine> lines = it->Lines();
-			bool hasSortLine = false, hasReplaceLine = false;
-			for (std::size_t i = 0, max = lines.size(); i < max; i++) {
-				Item subject = Item(lines[i].Object());
-				if (lines[i].Key() == BEFORE || lines[i].Key() == AFTER) {
-					if (hasSortLine)
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EMultipleSortLines).str());
-					if (i != 0)
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortNotSecond).str());
-					if (ruleKeyString == "FOR")
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortLineInForRule).str());
-					if (boost::iequals(ruleObject.Name(), subject.Name()))
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingToItself).str());
-					if ((ruleObject.IsPlugin() && !subject.IsPlugin()) ||
-					    (!ruleObject.IsPlugin() && subject.IsPlugin()))
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EReferencingModAndGroup).str());
-					if (lines[i].Key() == BEFORE) {
-						if (boost::iequals(subject.Name(), "esms"))
-							throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingGroupBeforeEsms).str());
-						else if (subject.IsGameMasterFile(parentGame))
-							throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingModBeforeGameMaster).str());
-						else if (!ruleObject.IsMasterFile(parentGame) &&
-						         subject.IsMasterFile(parentGame))
-							throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingPluginBeforeMaster).str());
-					} else if (ruleObject.IsMasterFile(parentGame) &&
-					           !subject.IsMasterFile(parentGame)) {
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortingMasterAfterPlugin).str());
-					}
-					hasSortLine = true;
-				} else if (lines[i].Key() == TOP || lines[i].Key() == BOTTOM) {
-					if (hasSortLine)
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EMultipleSortLines).str());
-					if (i != 0)
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortNotSecond).str());
-					if (ruleKeyString == "FOR")
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % ESortLineInForRule).str());
-					if (lines[i].Key() == TOP &&
-					    boost::iequals(subject.Name(), "esms"))
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EInsertingToTopOfEsms).str());
-					if (!ruleObject.IsPlugin() || subject.IsPlugin())
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EInsertingGroupOrIntoMod).str());
-					hasSortLine = true;
-				} else if (lines[i].Key() == APPEND ||
-				           lines[i].Key() == REPLACE) {
-					if (!ruleObject.IsPlugin())
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EAttachingMessageToGroup).str());
-					if (lines[i].Key() == REPLACE) {
-						if (hasReplaceLine)
-							throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EMultipleReplaceLines).str());
-						if ((ruleKeyString == "FOR" && i != 0) ||
-						    (ruleKeyString != "FOR" && i != 1))
-							throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EReplaceNotFirst).str());
-						hasReplaceLine = true;
-					}
-					if (!lines[i].IsObjectMessage())
-						throw ParsingError((RuleListSyntaxErrorMessage % ruleKeyString % ruleObject.Name() % EAttachingNonMessage).str());
-				}
-			}
-			++it;
-		} catch (ParsingError &e) {
-			it = rules.erase(it);
-			errorBuffer.push_back(e);
-			LOG_ERROR(Outputter(PLAINTEXT, e).AsString().c_str());
+void RuleList::BuildIndex() {
+	ruleIndex.clear();
+	for (std::size_t i = 0, max = rules.size(); i < max; i++)
+		ruleIndex[boost::to_lower_copy(rules[i].Object())].push_back(i);
+}
+
+void RuleList::ShiftIndex(const std::size_t pos, const bool inserted) {
+	std::unordered_map<std::string, std::vector<std::size_t> >::iterator it;
+	for (it = ruleIndex.begin(); it != ruleIndex.end(); ++it) {
+		std::vector<std::size_t>::iterator posIter = std::lower_bound(it->second.begin(), it->second.end(), pos);
+		for (; posIter != it->second.end(); ++posIter) {
+			if (inserted)
+				++(*posIter);
+			else
+				--(*posIter);
 		}
 	}
 }
@@ -32,6 +32,7 @@
 #include <cstdint>
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/filesystem.hpp>
@@ -78,6 +79,8 @@ class BOSS_COMMON Rule : public RuleLine {
 
 	RuleLine LineAt(const std::size_t pos) const;
 
+	void CheckSyntax(const Game &parentGame) const;  // Checks for syntax (not parsing) errors. Throws ParsingError on fail.
+
 	void Enabled(const bool e);
 	void Lines(const std::vector<RuleLine> inLines);
  private:
@@ -92,12 +95,13 @@ class BOSS_COMMON RuleList {
 	void Load(const Game &parentGame, const boost::filesystem::path file);  // Throws exception on fail.
 	void Save(const boost::filesystem::path file);                          // Throws exception on fail.
 	std::size_t FindRule(const std::string ruleObject,
-	                     const bool onlyEnabled) const;
+	                     const bool onlyEnabled) const;  // Case-insensitive. Returns Rules().size() if not found.
 
 	std::vector<Rule> Rules() const;
 	std::vector<ParsingError> ErrorBuffer() const;
 
 	Rule RuleAt(const std::size_t pos) const;
+	std::size_t Size() const;  // Number of rules. Cheaper than Rules().size(), which copies the whole list.
 
 	void Rules(const std::vector<Rule> inRules);
 	void ErrorBuffer(const std::vector<ParsingError> buffer);
@@ -109,10 +113,12 @@ class BOSS_COMMON RuleList {
 	void Clear();
 
  private:
-	void CheckSyntax(const Game &parentGame);  // Rule checker function, checks for syntax (not parsing) errors.
+	void BuildIndex();
+	void ShiftIndex(const std::size_t pos, const bool inserted);  // Keeps indexed positions after pos valid when a rule is inserted or erased there.
 
 	std::vector<Rule> rules;
 	std::vector<ParsingError> errorBuffer;
+	std::unordered_map<std::string, std::vector<std::size_t> > ruleIndex;  // Lowercased rule object -> ascending rule positions.
 };
 
 }  // namespace boss
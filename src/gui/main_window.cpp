@@ -116,6 +116,8 @@ namespace bloc = boost::locale;  // MCP Note: Will this interfere with std::loca
 // Draws the main window when program starts.
 bool BossGUI::OnInit() {
 	Settings ini;
+	// The logger's writer thread has to be stopped before static destructors run.
+	std::atexit([]() { g_logger.stop(); });
 	// Set up variable defaults.
 	if (fs::exists(ini_path)) {
 		try {
@@ -653,7 +655,7 @@ void MainFrame::OnRunBOSS(wxCommandEvent &event) {
 		game.ApplyUserlist();
 		LOG_INFO("userlist sorting process finished.");
 		game.ScanSEPlugins();
-		game.SortPlugins();
+		game.SortPlugins(gl_trial_run);
 		game.bosslog.Save(game.Log(gl_log_format), true);
 	} catch (boss_error &e) {
 		LOG_ERROR("Critical Error: %s", e.getString().c_str());
@@ -29,23 +29,30 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 
+#include <algorithm>
 #include <fstream>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <boost/crc.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/locale.hpp>
 
 #include "config.h"
 #include "base/fstream.h"
+#include "common/conditional_data.h"
 #include "common/error.h"
 #include "common/globals.h"
 #include "output/output.h"
 #include "support/helpers.h"
+#include "support/logger.h"
+#include "support/profiler.h"
 
 namespace boss {
 
@@ -67,7 +74,8 @@ BossLog::BossLog()
       messages(0),
       warnings(0),
       errors(0),
-      logFormat(HTML) {
+      logFormat(HTML),
+      recognisedHasChanged(false) {
 	updaterOutput.SetFormat(HTML);
 	criticalError.SetFormat(HTML);
 	userRules.SetFormat(HTML);
@@ -83,7 +91,8 @@ BossLog::BossLog(const std::uint32_t format)
       messages(0),
       warnings(0),
       errors(0),
-      logFormat(format) {
+      logFormat(format),
+      recognisedHasChanged(false) {
 	updaterOutput.SetFormat(format);
 	criticalError.SetFormat(format);
 	userRules.SetFormat(format);
@@ -103,12 +112,20 @@ void BossLog::SetFormat(const std::uint32_t format) {
 }
 
 void BossLog::Save(const fs::path file, const bool overwrite) {
-	if (fs::exists(file))
-		recognisedHasChanged = HasRecognisedListChanged(file);
+	PROFILE_SCOPE("BossLog::Save");
+	fs::path digestFile = DigestPath(file);
+	if (fs::exists(digestFile))
+		recognisedHasChanged = HasRecognisedListChanged(digestFile);
+
+	// Sections are streamed straight to the file, so give it a large buffer
+	// to keep the number of writes down. It is flushed each time it fills.
+	static const std::size_t buffer_size = 65536;
+	std::vector<char> buffer(buffer_size);
 
 	//ofstream outFile;
 	//std::ofstream outFile;
 	boss_fstream::ofstream outFile;
+	outFile.rdbuf()->pubsetbuf(&buffer[0], buffer_size);  // Must be set before opening.
 	if (overwrite)
 		// MCP Note: changed from file.c_str() to file.string(); needs testing as error was about not being able to convert wchar_t to char
 		outFile.open(file);
@@ -118,8 +135,32 @@ void BossLog::Save(const fs::path file, const bool overwrite) {
 	if (outFile.fail())
 		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
 
-	outFile << PrintLog();
+	PrintLog(outFile);
 	outFile.close();
+	if (outFile.fail())
+		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
+
+	if (!recognisedOrder.empty())  // Don't lose the last digest because of an early exit.
+		SaveRecognisedDigest(digestFile);
+}
+
+void BossLog::RecordRecognised(const Item &plugin, const std::string &version,
+                               const bool isActive, const std::uint32_t crc) {
+	boost::crc_32_type checksum;
+	std::string name = plugin.Name();
+	checksum.process_bytes(name.data(), name.length() + 1);  // Include the terminator to separate fields.
+	checksum.process_bytes(version.data(), version.length() + 1);
+	checksum.process_byte(isActive ? 1 : 0);
+	checksum.process_bytes(&crc, sizeof(crc));
+	std::vector<Message> messages = plugin.Messages();
+	for (std::size_t i = 0, max = messages.size(); i < max; i++) {
+		std::uint32_t key = messages[i].Key();
+		std::string data = messages[i].Data();
+		checksum.process_bytes(&key, sizeof(key));
+		checksum.process_bytes(data.data(), data.length() + 1);
+	}
+	recognisedOrder.push_back(name);
+	recognisedChecksums.push_back(checksum.checksum());
 }
 
 void BossLog::Clear() {
@@ -142,10 +183,14 @@ void BossLog::Clear() {
 
 	parsingErrors.clear();
 	globalMessages.clear();
+
+	recognisedHasChanged = false;
+	recognisedOrder.clear();
+	recognisedChecksums.clear();
+	movedPlugins.clear();
 }
 
-std::string BossLog::PrintLog() {
-	std::stringstream out;
+void BossLog::PrintLog(std::ostream &out) {
 	Outputter formattedOut(logFormat);
 
 	// Print header
@@ -257,16 +302,31 @@ std::string BossLog::PrintLog() {
 
 	formattedOut << HT << LIST_OPEN << NEWLINE;
 
-	formattedOut << updaterOutput.AsString();  // This contains BOSS & masterlist update strings.
+	out << formattedOut.AsString();
+	formattedOut.Clear();
+	updaterOutput.WriteTo(out);  // This contains BOSS & masterlist update strings.
 
-	if (recognisedHasChanged)
+	if (recognisedHasChanged) {
 		formattedOut << HT << HT << LIST_ITEM_CLASS_SUCCESS << bloc::translate("No change in recognised plugin list since last run.") << NEWLINE;
+	} else if (!movedPlugins.empty()) {
+		formattedOut << HT << HT << LIST_ITEM << bloc::translate("Recognised plugins moved since last run: ");
+		formattedOut.SetHTMLSpecialEscape(true);
+		for (std::size_t i = 0, max = movedPlugins.size(); i < max; i++) {
+			if (i != 0)
+				formattedOut << ", ";
+			formattedOut << movedPlugins[i];
+		}
+		formattedOut.SetHTMLSpecialEscape(false);
+		formattedOut << NEWLINE;
+	}
 
 	std::size_t size = parsingErrors.size();  // First print parser/syntax error messages.
 	for (std::size_t i = 0; i < size; i++)
 		formattedOut << parsingErrors[i];
 
-	formattedOut << criticalError.AsString();  // Print any critical errors.
+	out << formattedOut.AsString();
+	formattedOut.Clear();
+	criticalError.WriteTo(out);  // Print any critical errors.
 
 	formattedOut.SetHTMLSpecialEscape(true);
 	size = globalMessages.size();
@@ -281,7 +341,7 @@ std::string BossLog::PrintLog() {
 
 	if (!criticalError.Empty()) {  // Exit early.
 		out << PrintFooter();
-		return out.str();
+		return;
 	}
 
 
@@ -299,9 +359,11 @@ std::string BossLog::PrintLog() {
 		             << HT << HT << HT << HT << TABLE_HEADING << bloc::translate("Rule") << NEWLINE
 		             << HT << HT << HT << HT << TABLE_HEADING << bloc::translate("Applied") << NEWLINE
 		             << HT << HT << HT << HT << TABLE_HEADING << bloc::translate("Details (if applicable)") << NEWLINE
-		             << HT << HT << TABLE_BODY << NEWLINE
-		             << userRules.AsString()
-		             << HT << TABLE_CLOSE << NEWLINE
+		             << HT << HT << TABLE_BODY << NEWLINE;
+		out << formattedOut.AsString();
+		formattedOut.Clear();
+		userRules.WriteTo(out);
+		formattedOut << HT << TABLE_CLOSE << NEWLINE
 		             << SECTION_CLOSE << NEWLINE;
 		out << formattedOut.AsString();
 		formattedOut.Clear();
@@ -316,9 +378,11 @@ std::string BossLog::PrintLog() {
 			formattedOut << SECTION_ID_SE_OPEN << "\n";
 		else
 			formattedOut << SECTION_ID_SE_OPEN << HEADING_OPEN << scriptExtender << bloc::translate(" Plugins") << HEADING_CLOSE;
-		formattedOut << HT << LIST_OPEN << NEWLINE
-		             << sePlugins.AsString()
-		             << HT << LIST_CLOSE << NEWLINE
+		formattedOut << HT << LIST_OPEN << NEWLINE;
+		out << formattedOut.AsString();
+		formattedOut.Clear();
+		sePlugins.WriteTo(out);
+		formattedOut << HT << LIST_CLOSE << NEWLINE
 		             << SECTION_CLOSE << NEWLINE;
 		out << formattedOut.AsString();
 		formattedOut.Clear();
@@ -341,9 +405,11 @@ std::string BossLog::PrintLog() {
 		}
 		formattedOut << PARAGRAPH
 		             << bloc::translate("These plugins are recognised by BOSS and have been sorted according to its masterlist. Please read any attached messages and act on any that require action.")
-		             << LIST_OPEN
-		             << recognisedPlugins.AsString()
-		             << LIST_CLOSE << SECTION_CLOSE;
+		             << LIST_OPEN;
+		out << formattedOut.AsString();
+		formattedOut.Clear();
+		recognisedPlugins.WriteTo(out);
+		formattedOut << LIST_CLOSE << SECTION_CLOSE;
 		out << formattedOut.AsString();
 		formattedOut.Clear();
 	}
@@ -359,9 +425,11 @@ std::string BossLog::PrintLog() {
 			formattedOut << SECTION_ID_UNRECOGNISED_OPEN << HEADING_OPEN << bloc::translate("Unrecognised Plugins") << HEADING_CLOSE;
 
 		formattedOut << PARAGRAPH << bloc::translate("The following plugins were not found in the masterlist, and must be positioned manually, using your favourite mod manager or by using BOSS's user rules functionality.")
-		             << SPAN_ID_UNRECPLUGINSSUBMITNOTE_OPEN << bloc::translate(" You can submit unrecognised plugins for addition to the masterlist directly from this log by clicking on a plugin and supplying a link and/or description of its contents in the panel that is displayed.") << SPAN_CLOSE << LIST_OPEN
-		             << unrecognisedPlugins.AsString()
-		             << LIST_CLOSE << SECTION_CLOSE;
+		             << SPAN_ID_UNRECPLUGINSSUBMITNOTE_OPEN << bloc::translate(" You can submit unrecognised plugins for addition to the masterlist directly from this log by clicking on a plugin and supplying a link and/or description of its contents in the panel that is displayed.") << SPAN_CLOSE << LIST_OPEN;
+		out << formattedOut.AsString();
+		formattedOut.Clear();
+		unrecognisedPlugins.WriteTo(out);
+		formattedOut << LIST_CLOSE << SECTION_CLOSE;
 		out << formattedOut.AsString();
 		formattedOut.Clear();
 	}
@@ -371,8 +439,6 @@ std::string BossLog::PrintLog() {
 	//-------------------------
 
 	out << PrintFooter();
-
-	return out.str();
 }
 
 std::string BossLog::PrintHeaderTop() {
@@ -495,26 +561,102 @@ std::string BossLog::PrintFooter() {
 	return out.str();
 }
 
-bool BossLog::HasRecognisedListChanged(const fs::path file) {
-	std::size_t pos1, pos2;
-	std::string result;
-	fileToBuffer(file, result);
-	if (logFormat == HTML) {
-		pos1 = result.find("<section id='recPlugins'>");
-		if (pos1 != std::string::npos)
-			pos1 = result.find("<ul>", pos1);
-		if (pos1 != std::string::npos)
-			pos2 = result.find("</section>", pos1);
-		if (pos2 != std::string::npos)
-			result = result.substr(pos1 + 4, pos2 - pos1 - 9);
-	} else {
-		pos1 = result.find(bloc::translate("Please read any attached messages and act on any that require action."));
-		if (pos1 != std::string::npos)
-			pos2 = result.find("======================================", pos1);
-		if (pos2 != std::string::npos)
-			result = result.substr(pos1 + 69, pos2 - pos1 - 69 - 3);
+/*
+ * The digest holds one line per recognised plugin, in load order:
+ * the entry checksum as hex, a tab, then the plugin filename.
+ * It is written next to the log so that it works for both log formats.
+ */
+fs::path BossLog::DigestPath(const fs::path logFile) {
+	return logFile.parent_path() / (logFile.stem().string() + ".digest");
+}
+
+bool BossLog::HasRecognisedListChanged(const fs::path digestFile) {
+	movedPlugins.clear();
+
+	boss_fstream::ifstream in(digestFile);
+	if (in.fail()) {
+		LOG_WARN("Could not read the recognised plugin digest \"%s\".",
+		         digestFile.string().c_str());
+		return false;
+	}
+	std::vector<std::string> oldOrder;
+	std::vector<std::uint32_t> oldChecksums;
+	std::string line;
+	while (std::getline(in, line)) {
+		std::size_t pos = line.find('\t');
+		if (pos == std::string::npos)
+			continue;
+		oldChecksums.push_back(std::strtoul(line.substr(0, pos).c_str(), NULL, 16));
+		oldOrder.push_back(line.substr(pos + 1));
+	}
+	in.close();
+
+	bool unchanged = (oldOrder == recognisedOrder &&
+	                  oldChecksums == recognisedChecksums);
+	if (unchanged)
+		return true;
+
+	/*
+	 * Work out which plugins moved. Take the old positions of the plugins
+	 * that are in both lists, in their new order. The longest increasing run
+	 * of old positions kept its relative order; everything else moved.
+	 */
+	std::unordered_map<std::string, std::size_t> oldPositions;
+	for (std::size_t i = 0, max = oldOrder.size(); i < max; i++)
+		oldPositions.insert(std::make_pair(oldOrder[i], i));
+
+	std::vector<std::size_t> common;  // Indices into recognisedOrder.
+	std::vector<std::size_t> commonOldPos;
+	for (std::size_t i = 0, max = recognisedOrder.size(); i < max; i++) {
+		std::unordered_map<std::string, std::size_t>::const_iterator it = oldPositions.find(recognisedOrder[i]);
+		if (it != oldPositions.end()) {
+			common.push_back(i);
+			commonOldPos.push_back(it->second);
+		}
+	}
+
+	std::vector<std::size_t> tails;  // tails[k] = index into common of the smallest tail of an increasing run of length k + 1.
+	std::vector<std::size_t> previous(common.size(), common.size());
+	for (std::size_t i = 0, max = common.size(); i < max; i++) {
+		std::size_t lo = 0, hi = tails.size();
+		while (lo < hi) {
+			std::size_t mid = (lo + hi) / 2;
+			if (commonOldPos[tails[mid]] < commonOldPos[i])
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo > 0)
+			previous[i] = tails[lo - 1];
+		if (lo == tails.size())
+			tails.push_back(i);
+		else
+			tails[lo] = i;
+	}
+
+	std::vector<bool> kept(common.size(), false);
+	if (!tails.empty()) {
+		for (std::size_t i = tails.back(); i != common.size(); i = previous[i])
+			kept[i] = true;
+	}
+	for (std::size_t i = 0, max = common.size(); i < max; i++) {
+		if (!kept[i])
+			movedPlugins.push_back(recognisedOrder[common[i]]);
+	}
+
+	return false;
+}
+
+void BossLog::SaveRecognisedDigest(const fs::path digestFile) {
+	boss_fstream::ofstream out(digestFile, std::ios_base::trunc);
+	if (out.fail()) {
+		LOG_WARN("Could not write the recognised plugin digest \"%s\".",
+		         digestFile.string().c_str());
+		return;
 	}
-	return (result == recognisedPlugins.AsString());
+	for (std::size_t i = 0, max = recognisedOrder.size(); i < max; i++)
+		out << IntToHexString(recognisedChecksums[i]) << '\t' << recognisedOrder[i] << '\n';
+	out.close();
 }
 
 }  // namespace boss
@@ -30,6 +30,7 @@
 
 #include <cstdint>
 
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -51,6 +52,11 @@ class BossLog {
 	void Save(const boost::filesystem::path file, const bool overwrite);  // Saves contents to file. Throws boss_error exception on fail.
 	void Clear();
 
+	// Records a recognised plugin's position and a checksum of what its log entry shows,
+	// so that changes since the last run can be detected without reading the old log.
+	void RecordRecognised(const Item &plugin, const std::string &version,
+	                      const bool isActive, const std::uint32_t crc);
+
 	std::uint32_t recognised;
 	std::uint32_t unrecognised;
 	std::uint32_t inactive;
@@ -72,15 +78,21 @@ class BossLog {
 	std::vector<Message> globalMessages;
 
  private:
-	std::string PrintLog();
+	void PrintLog(std::ostream &out);  // Streams the log section by section, without assembling it in memory first.
 	std::string PrintHeaderTop();
 	std::string PrintHeaderBottom();
 	std::string PrintFooter();
 
-	bool HasRecognisedListChanged(const boost::filesystem::path file);
+	bool HasRecognisedListChanged(const boost::filesystem::path digestFile);  // Also fills movedPlugins.
+	void SaveRecognisedDigest(const boost::filesystem::path digestFile);
+	static boost::filesystem::path DigestPath(const boost::filesystem::path logFile);
 
 	std::uint32_t logFormat;
 	bool recognisedHasChanged;
+
+	std::vector<std::string> recognisedOrder;       // Recognised plugin names, in load order.
+	std::vector<std::uint32_t> recognisedChecksums;  // Checksums of their log entries.
+	std::vector<std::string> movedPlugins;           // Recognised plugins that moved since the last run.
 };
 
 }  // namespace boss
@@ -29,6 +29,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include <fstream>
 #include <ostream>
@@ -53,6 +54,98 @@ namespace boss {
 namespace fs = boost::filesystem;
 namespace bloc = boost::locale;
 
+namespace {
+
+// Bytes that may start something needing HTML escaping. 0xC2 and 0xE2 are
+// the UTF-8 lead bytes of ©, ✗ and ✓, which need the following bytes checked.
+inline bool IsHTMLSpecialByte(const unsigned char c) {
+	switch (c) {
+		case '&':
+		case '"':
+		case '\'':
+		case '<':
+		case '>':
+		case '\n':
+		case 0xC2:
+		case 0xE2:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// Returns the replacement for the special character at text[pos], setting
+// length to the number of bytes it replaces, or NULL if there is nothing to escape.
+inline const char *HTMLEntityAt(const std::string &text, const std::size_t pos,
+                                std::size_t &length) {
+	length = 1;
+	switch (static_cast<unsigned char>(text[pos])) {
+		case '&':
+			return "&amp;";
+		case '"':
+			return "&quot;";
+		case '\'':
+			return "&#039;";
+		case '<':
+			return "&lt;";
+		case '>':
+			return "&gt;";
+		case '\n':
+			return "<br />";  // Not an HTML special char escape, but this needs to happen here to get the details of parser errors formatted correctly.
+		case 0xC2:
+			if (text.compare(pos, 2, "\xC2\xA9") == 0) {  // ©
+				length = 2;
+				return "&copy;";
+			}
+			return NULL;
+		case 0xE2:
+			if (text.compare(pos, 3, "\xE2\x9C\x97") == 0) {  // ✗
+				length = 3;
+				return "&#x2717;";
+			} else if (text.compare(pos, 3, "\xE2\x9C\x93") == 0) {  // ✓
+				length = 3;
+				return "&#x2713;";
+			}
+			return NULL;
+		default:
+			return NULL;
+	}
+}
+
+inline void Append(std::string &out, const char *data, const std::size_t length) {
+	out.append(data, length);
+}
+
+inline void Append(std::ostream &out, const char *data, const std::size_t length) {
+	out.write(data, length);
+}
+
+// Escapes text into out in a single pass. Runs of ordinary bytes are copied in bulk.
+template <typename Sink>
+void AppendHTMLEscaped(const std::string &text, Sink &out) {
+	const char *data = text.data();
+	std::size_t runStart = 0, pos = 0, length;
+	const std::size_t max = text.size();
+	while (pos < max) {
+		if (!IsHTMLSpecialByte(static_cast<unsigned char>(data[pos]))) {
+			++pos;
+			continue;
+		}
+		const char *entity = HTMLEntityAt(text, pos, length);
+		if (entity == NULL) {
+			++pos;
+			continue;
+		}
+		Append(out, data + runStart, pos - runStart);
+		Append(out, entity, std::strlen(entity));
+		pos += length;
+		runStart = pos;
+	}
+	Append(out, data + runStart, max - runStart);
+}
+
+}  // namespace
+
 ////////////////////////////////
 // Outputter Class Functions
 ////////////////////////////////
@@ -123,7 +216,8 @@ void Outputter::Clear() {
 }
 
 bool Outputter::Empty() const {
-	return outStream.str().empty();
+	// Check the write position rather than copying the contents out.
+	return outStream.rdbuf()->pubseekoff(0, std::ios_base::cur, std::ios_base::out) == std::streampos(0);
 }
 
 std::uint32_t Outputter::GetFormat() const {
@@ -138,7 +232,17 @@ std::string Outputter::AsString() const {
 	return outStream.str();
 }
 
+void Outputter::WriteTo(std::ostream &out) const {
+	if (Empty())
+		return;  // Inserting an empty streambuf would set failbit on out.
+	outStream.rdbuf()->pubseekpos(0, std::ios_base::in);
+	out << outStream.rdbuf();
+}
+
 Outputter& Outputter::operator= (const Outputter &o) {
+	if (this == &o)
+		return *this;
+	Clear();  // Replace, rather than add to, the existing content.
 	outStream << o.AsString();
 	outFormat = o.GetFormat();
 	escapeHTMLSpecialChars = o.GetHTMLSpecialEscape();
@@ -146,12 +250,15 @@ Outputter& Outputter::operator= (const Outputter &o) {
 }
 
 Outputter& Outputter::operator<< (const std::string s) {
-	outStream << EscapeHTMLSpecial(s);
+	if (escapeHTMLSpecialChars && outFormat == HTML)
+		AppendHTMLEscaped(s, outStream);
+	else
+		outStream << s;
 	return *this;
 }
 
 Outputter& Outputter::operator<< (const char *s) {
-	outStream << EscapeHTMLSpecial(s);
+	*this << std::string(s);
 	return *this;
 }
 
@@ -587,17 +694,12 @@ Outputter& Outputter::operator<< (const Rule r) {
 	return *this;
 }
 
-std::string Outputter::EscapeHTMLSpecial(std::string text) {
+std::string Outputter::EscapeHTMLSpecial(const std::string &text) {
 	if (escapeHTMLSpecialChars && outFormat == HTML) {
-		boost::replace_all(text, "&", "&amp;");
-		boost::replace_all(text, "\"", "&quot;");
-		boost::replace_all(text, "'", "&#039;");
-		boost::replace_all(text, "<", "&lt;");
-		boost::replace_all(text, ">", "&gt;");
-		boost::replace_all(text, "©", "&copy;");
-		boost::replace_all(text, "✗", "&#x2717;");
-		boost::replace_all(text, "✓", "&#x2713;");
-		boost::replace_all(text, "\n", "<br />");  // Not an HTML special char escape, but this needs to happen here to get the details of parser errors formatted correctly.
+		std::string escaped;
+		escaped.reserve(text.size());
+		AppendHTMLEscaped(text, escaped);
+		return escaped;
 	}
 	return text;
 }
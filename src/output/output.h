@@ -32,6 +32,7 @@
 
 #include <cstdint>
 
+#include <ostream>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -117,6 +118,7 @@ class BOSS_COMMON Outputter {
 	bool GetHTMLSpecialEscape() const;
 
 	std::string AsString() const;  // Outputs contents as a string.
+	void WriteTo(std::ostream &out) const;  // Streams contents to out without copying them into a string first.
 
 	Outputter& operator= (const Outputter &o);
 	Outputter& operator<< (const std::string s);
@@ -132,7 +134,7 @@ class BOSS_COMMON Outputter {
 	Outputter& operator<< (const Rule r);
 
  private:
-	std::string EscapeHTMLSpecial(std::string text);  // Performs the HTML escaping.
+	std::string EscapeHTMLSpecial(const std::string &text);  // Performs the HTML escaping in a single pass.
 	std::string EscapeHTMLSpecial(char c);
 
 	std::stringstream outStream;
@@ -56,6 +56,7 @@
 #include "output/output.h"
 #include "support/helpers.h"
 #include "support/logger.h"
+#include "support/profiler.h"
 
 namespace boss {
 
@@ -582,6 +583,7 @@ void conditional_grammar::CheckRegex(bool &result, std::string reg) {
 	}
 	//std::regex regex;
 	boss_regex::regex regex;
+	PROFILE_COUNT(PC_REGEXES_COMPILED, 1);
 	try {
 		//regex = std::regex(reg, std::regex::ECMAScript|std::regex::icase);
 		regex = boss_regex::regex(reg, boss_regex::regex::ECMAScript|boss_regex::regex::icase);
@@ -760,13 +762,16 @@ void ini_grammar::SyntaxError(const grammarIter /*&first*/,
 
 userlist_grammar::userlist_grammar()
     : userlist_grammar::base_type(ruleList, "userlist grammar"),
-      errorBuffer(NULL) {
+      errorBuffer(NULL),
+      parentGame(NULL),
+      hasParsingError(false) {
 
 	ruleKeys_ ruleKeys;
 	messageKeys_ sortOrMessageKeys;
 
 	// A list is a vector of rules. Rules are separated by line endings.
-	ruleList %= *eol > (eoi | (userlistRule % eol));
+	// Each rule is syntax-checked as it is parsed, so the list is only walked once.
+	ruleList = *eol > (eoi | (userlistRule[phoenix::bind(&userlist_grammar::StoreRule, this, _val, _1)] % eol));
 
 	// A rule consists of a rule line containing a rule keyword and a rule object, followed by one or more message or sort lines.
 	userlistRule %= *eol > stateKey > ruleKey > ':' > object > +eol >
@@ -803,6 +808,27 @@ userlist_grammar::userlist_grammar()
 void userlist_grammar::SetErrorBuffer(
     std::vector<ParsingError> *inErrorBuffer) {
 	errorBuffer = inErrorBuffer;
+	hasParsingError = false;
+}
+
+void userlist_grammar::SetParentGame(const Game *game) {
+	parentGame = game;
+}
+
+void userlist_grammar::StoreRule(std::vector<Rule> &list,
+                                 const Rule &currentRule) {
+	if (parentGame == NULL) {
+		list.push_back(currentRule);
+		return;
+	}
+	try {
+		currentRule.CheckSyntax(*parentGame);
+		list.push_back(currentRule);
+	} catch (ParsingError &e) {
+		if (errorBuffer != NULL)
+			errorBuffer->push_back(e);
+		LOG_ERROR(Outputter(PLAINTEXT, e).AsString().c_str());
+	}
 }
 
 // MCP Note: Can grammarIter const& first be removed?
@@ -810,8 +836,9 @@ void userlist_grammar::SyntaxError(const grammarIter /*&first*/,
                                    const grammarIter &last,
                                    const grammarIter &errorpos,
                                    const boost::spirit::info &what) {
-	if (errorBuffer == NULL || !errorBuffer->empty())
+	if (errorBuffer == NULL || hasParsingError)
 		return;
+	hasParsingError = true;
 
 	std::ostringstream out;
 	out << what;
@@ -306,12 +306,17 @@ class userlist_grammar
  public:
 	userlist_grammar();
 	void SetErrorBuffer(std::vector<ParsingError> *inErrorBuffer);
+	void SetParentGame(const Game *game);
  private:
 	void SyntaxError(const grammarIter /*&first*/,
 	                 const grammarIter &last,
 	                 const grammarIter &errorpos,
 	                 const boost::spirit::info &what);
 
+	// Checks the syntax of the given rule as soon as it has been parsed,
+	// storing it if valid and recording the syntax error otherwise.
+	void StoreRule(std::vector<Rule> &list, const Rule &currentRule);
+
 	qi::rule<grammarIter, std::vector<Rule>(), Skipper> ruleList;
 	qi::rule<grammarIter, Rule(), Skipper> userlistRule;
 	qi::rule<grammarIter, RuleLine(), Skipper> sortOrMessageLine;
@@ -320,6 +325,8 @@ class userlist_grammar
 	qi::rule<grammarIter, bool(), Skipper> stateKey;
 
 	std::vector<ParsingError> *errorBuffer;
+	const Game *parentGame;
+	bool hasParsingError;  // Only the first (innermost) parsing error is recorded.
 };
 
 }  // namespace boss
@@ -0,0 +1,76 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#include "support/arena.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <string>
+
+namespace boss {
+
+Arena::Arena() : block(NULL), capacity(0), used(0) {}
+
+Arena::~Arena() {
+	delete[] block;
+}
+
+void Arena::Reset(const std::size_t size) {
+	used = 0;
+	if (size <= capacity)
+		return;
+	// Grow to at least double the old size, so that a slowly growing output
+	// doesn't reallocate on every call.
+	std::size_t newCapacity = std::max(size, capacity * 2);
+	delete[] block;
+	block = NULL;
+	capacity = 0;
+	block = new std::uint8_t[newCapacity];
+	capacity = newCapacity;
+}
+
+void Arena::Release() {
+	delete[] block;
+	block = NULL;
+	capacity = 0;
+	used = 0;
+}
+
+std::uint8_t *Arena::CopyString(const std::string &str) {
+	std::uint8_t *p = Allocate<std::uint8_t>(str.length() + 1);
+	std::copy(str.begin(), str.end(), p);  // UTF-8, so this is byte by byte, but that's all that's needed.
+	p[str.length()] = '\0';
+	return p;
+}
+
+std::size_t Arena::SizeOf(const std::string &str) {
+	return str.length() + 1;
+}
+
+}  // namespace boss
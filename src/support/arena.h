@@ -0,0 +1,98 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#ifndef SUPPORT_ARENA_H_
+#define SUPPORT_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "common/dll_def.h"
+
+namespace boss {
+
+/*
+ * A bump allocator for API outputs. Everything a call outputs is packed into
+ * one block: the call adds up the room it needs, resets the arena to that size,
+ * then takes arrays and strings from it in turn. The next reset discards them
+ * all at once and reuses the block if it is big enough, so there is at most one
+ * allocation per call and no per-string frees.
+ */
+class BOSS_COMMON Arena {
+ public:
+	Arena();
+	~Arena();
+
+	// Discards everything taken from the arena and makes room for size bytes,
+	// which should be the sum of the SizeOf() values for what will be taken.
+	// Throws std::bad_alloc on fail.
+	void Reset(const std::size_t size);
+
+	// Discards everything taken from the arena and frees its block.
+	void Release();
+
+	// Returns room for count objects of type T, or NULL if count is 0. Throws
+	// std::bad_alloc if the room wasn't made by the last Reset.
+	template <typename T>
+	T *Allocate(const std::size_t count) {
+		if (count == 0)
+			return NULL;
+		const std::size_t align = std::alignment_of<T>::value;
+		std::size_t start = (used + align - 1) / align * align;
+		if (start + count * sizeof(T) > capacity)
+			throw std::bad_alloc();
+		used = start + count * sizeof(T);
+		return reinterpret_cast<T *>(block + start);
+	}
+
+	// Copies str into the arena as a null-terminated string.
+	std::uint8_t *CopyString(const std::string &str);
+
+	// The room taken by Allocate<T>(count), allowing for alignment.
+	template <typename T>
+	static std::size_t SizeOf(const std::size_t count) {
+		return count == 0 ? 0 : count * sizeof(T) + std::alignment_of<T>::value - 1;
+	}
+
+	// The room taken by CopyString(str).
+	static std::size_t SizeOf(const std::string &str);
+
+ private:
+	std::uint8_t *block;
+	std::size_t capacity;
+	std::size_t used;
+
+	Arena(const Arena &);  // Not copyable.
+	Arena &operator = (const Arena &);
+};
+
+}  // namespace boss
+#endif  // SUPPORT_ARENA_H_
@@ -0,0 +1,289 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#include "support/change_monitor.h"
+
+#if __linux__
+#	include <sys/inotify.h>
+#	include <unistd.h>
+#elif _WIN32 || _WIN64
+#	ifndef UNICODE
+#		define UNICODE
+#	endif
+#	ifndef _UNICODE
+#		define _UNICODE
+#	endif
+#	include <windows.h>
+#endif
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "support/logger.h"
+#include "support/profiler.h"
+
+namespace boss {
+
+namespace fs = boost::filesystem;
+
+#if __linux__
+// Events that mean a file's contents, timestamp or presence have changed.
+// Setting only the modification time is reported as IN_MODIFY, not IN_ATTRIB.
+static const std::uint32_t NOTIFY_MASK = IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE |
+                                         IN_CREATE | IN_DELETE |
+                                         IN_MOVED_FROM | IN_MOVED_TO |
+                                         IN_DELETE_SELF | IN_MOVE_SELF;
+#elif _WIN32 || _WIN64
+// Changes to the names, sizes or modification times of the files in a folder.
+// Only the folder itself can be watched, so a file's notifications also fire
+// for changes to the other files beside it.
+static const DWORD NOTIFY_FILTER = FILE_NOTIFY_CHANGE_FILE_NAME |
+                                   FILE_NOTIFY_CHANGE_SIZE |
+                                   FILE_NOTIFY_CHANGE_LAST_WRITE;
+#endif
+
+
+//////////////////////////////////
+// ChangeMonitor Class Functions
+//////////////////////////////////
+
+bool ChangeMonitor::Stamp::operator == (const Stamp &rhs) const {
+	return exists == rhs.exists && mtime == rhs.mtime && size == rhs.size;
+}
+
+ChangeMonitor::ChangeMonitor() : upToDate(false), notifyFd(-1) {}
+
+ChangeMonitor::~ChangeMonitor() {
+	StopNotifications();
+}
+
+void ChangeMonitor::Watch(const std::vector<fs::path> &inPaths) {
+	std::lock_guard<std::mutex> guard(mutex);
+	StopNotifications();
+	paths = inPaths;
+	stamps.clear();
+	upToDate = false;
+	StartNotifications();
+}
+
+bool ChangeMonitor::HasChanged() {
+	std::lock_guard<std::mutex> guard(mutex);
+	if (!upToDate)
+		return true;
+	if (UsingNotifications()) {
+		if (ReadNotifications())
+			upToDate = false;
+		// ReadNotifications() may have given up on notifications, in which
+		// case the stamps it left are empty and the monitor is out of date.
+		return !upToDate;
+	}
+	for (std::size_t i = 0; i < paths.size(); i++) {
+		if (!(GetStamp(paths[i]) == stamps[i])) {
+			upToDate = false;
+			break;
+		}
+	}
+	return !upToDate;
+}
+
+void ChangeMonitor::MarkUpToDate() {
+	std::lock_guard<std::mutex> guard(mutex);
+	if (!UsingNotifications())
+		StartNotifications();  // Retry, in case a missing folder has since been created.
+	if (UsingNotifications()) {
+		ReadNotifications();  // Anything pending happened before now.
+	} else {
+		stamps.clear();
+		for (std::size_t i = 0; i < paths.size(); i++)
+			stamps.push_back(GetStamp(paths[i]));
+	}
+	upToDate = UsingNotifications() || stamps.size() == paths.size();
+}
+
+void ChangeMonitor::Invalidate() {
+	std::lock_guard<std::mutex> guard(mutex);
+	upToDate = false;
+}
+
+ChangeMonitor::Stamp ChangeMonitor::GetStamp(const fs::path &path) const {
+	Stamp stamp;
+	stamp.exists = false;
+	stamp.mtime = 0;
+	stamp.size = 0;
+	try {
+		PROFILE_COUNT(PC_FILES_STATED, 1);
+		fs::file_status status = fs::status(path);
+		if (!fs::exists(status))
+			return stamp;
+		stamp.exists = true;
+		stamp.mtime = fs::last_write_time(path);
+		if (fs::is_directory(status)) {
+			// A folder's own time only changes when files are added or removed,
+			// so also look at the files inside.
+			std::size_t hash = 0;
+			for (fs::directory_iterator itr(path); itr != fs::directory_iterator(); ++itr) {
+				PROFILE_COUNT(PC_FILES_STATED, 1);
+				if (!fs::is_regular_file(itr->status()))
+					continue;
+				boost::hash_combine(hash, itr->path().filename().string());
+				boost::hash_combine(hash, fs::last_write_time(itr->path()));
+				boost::hash_combine(hash, fs::file_size(itr->path()));
+			}
+			stamp.size = hash;
+		} else {
+			stamp.size = fs::file_size(path);
+		}
+	} catch (fs::filesystem_error &e) {
+		LOG_DEBUG("Could not read the state of \"%s\": %s",
+		          path.string().c_str(), e.what());
+		stamp.exists = false;  // Treat it as missing, which will differ from a good reading.
+	}
+	return stamp;
+}
+
+void ChangeMonitor::StartNotifications() {
+#if __linux__
+	if (paths.empty())
+		return;
+	notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notifyFd < 0) {
+		LOG_DEBUG("inotify is unavailable, falling back to timestamp checks.");
+		return;
+	}
+	for (std::size_t i = 0; i < paths.size(); i++) {
+		// Files are watched through their folder, so that they are still
+		// watched after being replaced by a rename.
+		fs::path folder = paths[i];
+		std::string name;
+		if (!fs::is_directory(paths[i])) {
+			folder = paths[i].parent_path();
+			name = paths[i].filename().string();
+		}
+		int wd = inotify_add_watch(notifyFd, folder.string().c_str(), NOTIFY_MASK);
+		if (wd < 0) {
+			LOG_DEBUG("Could not watch \"%s\", falling back to timestamp checks.",
+			          folder.string().c_str());
+			StopNotifications();
+			return;
+		}
+		notifyWatches.push_back(std::make_pair(wd, name));
+	}
+#elif _WIN32 || _WIN64
+	for (std::size_t i = 0; i < paths.size(); i++) {
+		fs::path folder = fs::is_directory(paths[i]) ? paths[i] : paths[i].parent_path();
+		HANDLE handle = FindFirstChangeNotificationW(folder.wstring().c_str(), FALSE, NOTIFY_FILTER);
+		if (handle == INVALID_HANDLE_VALUE) {
+			LOG_DEBUG("Could not watch \"%s\", falling back to timestamp checks.",
+			          folder.string().c_str());
+			StopNotifications();
+			return;
+		}
+		notifyHandles.push_back(handle);
+	}
+#endif
+}
+
+void ChangeMonitor::StopNotifications() {
+#if __linux__
+	if (notifyFd >= 0)
+		close(notifyFd);  // Also removes the watches.
+#elif _WIN32 || _WIN64
+	for (std::size_t i = 0; i < notifyHandles.size(); i++)
+		FindCloseChangeNotification(notifyHandles[i]);
+#endif
+	notifyFd = -1;
+	notifyWatches.clear();
+	notifyHandles.clear();
+}
+
+bool ChangeMonitor::IsNotifying() const {
+	std::lock_guard<std::mutex> guard(mutex);
+	return UsingNotifications();
+}
+
+bool ChangeMonitor::UsingNotifications() const {
+	return notifyFd >= 0 || !notifyHandles.empty();
+}
+
+bool ChangeMonitor::ReadNotifications() {
+	bool changed = false;
+#if __linux__
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	while (notifyFd >= 0) {
+		ssize_t length = read(notifyFd, buffer, sizeof(buffer));
+		if (length <= 0) {
+			if (length < 0 && errno != EAGAIN && errno != EINTR) {
+				StopNotifications();
+				return true;
+			}
+			break;
+		}
+		for (char *ptr = buffer; ptr < buffer + length;
+		     ptr += sizeof(struct inotify_event) + reinterpret_cast<struct inotify_event *>(ptr)->len) {
+			const struct inotify_event *event = reinterpret_cast<struct inotify_event *>(ptr);
+			if (event->mask & (IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+				// Events were lost or a watched folder went away, so from now
+				// on fall back to timestamps.
+				StopNotifications();
+				return true;
+			}
+			std::string name = event->len > 0 ? std::string(event->name) : std::string();
+			for (std::size_t i = 0; i < notifyWatches.size(); i++) {
+				if (notifyWatches[i].first == event->wd &&
+				    (notifyWatches[i].second.empty() || notifyWatches[i].second == name)) {
+					changed = true;
+					break;
+				}
+			}
+		}
+	}
+#elif _WIN32 || _WIN64
+	for (std::size_t i = 0; i < notifyHandles.size(); i++) {
+		if (WaitForSingleObject(notifyHandles[i], 0) != WAIT_OBJECT_0)
+			continue;
+		changed = true;
+		// Re-arm it. Changes made since it fired signal it again straight away.
+		if (!FindNextChangeNotification(notifyHandles[i])) {
+			StopNotifications();
+			return true;
+		}
+	}
+#endif
+	return changed;
+}
+
+}  // namespace boss
@@ -0,0 +1,108 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#ifndef SUPPORT_CHANGE_MONITOR_H_
+#define SUPPORT_CHANGE_MONITOR_H_
+
+#include <cstdint>
+#include <ctime>
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "common/dll_def.h"
+
+namespace boss {
+
+/*
+ * Tells whether any of a set of files, or any of the files directly inside a
+ * set of folders, may have changed since the monitor was last marked up to
+ * date. Where inotify (on Linux) or change notifications (on Windows) are
+ * available, changes are picked up from them, so checking doesn't touch the
+ * filesystem. Otherwise the modification times and sizes recorded when the
+ * monitor was last marked up to date are compared, which means reading every
+ * file in the watched folders.
+ *
+ * Checking for changes updates the monitor's state, so it's guarded by a mutex,
+ * allowing threads that only share a lock on the cached data to check at once.
+ */
+class BOSS_COMMON ChangeMonitor {
+ public:
+	ChangeMonitor();
+	~ChangeMonitor();
+
+	// Replaces the watched paths. The monitor starts out of date.
+	void Watch(const std::vector<boost::filesystem::path> &inPaths);
+
+	bool HasChanged();
+
+	// Records the watched paths' current state as up to date.
+	void MarkUpToDate();
+
+	// Marks the monitor as out of date, eg. if reading the watched paths failed.
+	void Invalidate();
+
+	// Returns true if changes are picked up from notifications, so that
+	// checking for them is cheap enough to do often.
+	bool IsNotifying() const;
+
+ private:
+	mutable std::mutex mutex;  // Guards everything below.
+
+	struct Stamp {
+		bool exists;
+		std::time_t mtime;
+		std::uintmax_t size;  // For folders, a hash of the names, times and sizes of the files inside.
+
+		bool operator == (const Stamp &rhs) const;
+	};
+
+	Stamp GetStamp(const boost::filesystem::path &path) const;
+
+	void StartNotifications();
+	void StopNotifications();
+	bool ReadNotifications();  // Returns true if any watched path was affected.
+	bool UsingNotifications() const;  // IsNotifying(), for callers already holding mutex.
+
+	std::vector<boost::filesystem::path> paths;
+	std::vector<Stamp> stamps;
+	bool upToDate;
+
+	int notifyFd;  // inotify instance, or -1 if it isn't being used.
+	std::vector<std::pair<int, std::string> > notifyWatches;  // Watch descriptor, and the file name to match or empty to match any file.
+	std::vector<void *> notifyHandles;  // Windows change notification handles, one per watched path.
+
+	ChangeMonitor(const ChangeMonitor &);  // Not copyable.
+	ChangeMonitor &operator = (const ChangeMonitor &);
+};
+
+}  // namespace boss
+#endif  // SUPPORT_CHANGE_MONITOR_H_
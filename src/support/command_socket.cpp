@@ -0,0 +1,205 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#include "support/command_socket.h"
+
+#if !(_WIN32 || _WIN64)
+#	include <fcntl.h>
+#	include <poll.h>
+#	include <sys/socket.h>
+#	include <sys/stat.h>
+#	include <sys/un.h>
+#	include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include "common/error.h"
+#include "support/logger.h"
+
+namespace boss {
+
+namespace fs = boost::filesystem;
+
+// Commands longer than this are rejected, as are clients too slow to send one.
+static const std::size_t MAX_COMMAND_LENGTH = 1024;
+static const int COMMAND_TIMEOUT = 1000;  // Milliseconds.
+
+
+//////////////////////////////////
+// CommandSocket Class Functions
+//////////////////////////////////
+
+CommandSocket::CommandSocket() : listenFd(-1), clientFd(-1) {}
+
+CommandSocket::~CommandSocket() {
+	Close();
+}
+
+bool CommandSocket::Open(const fs::path &inPath) {
+	Close();
+#if _WIN32 || _WIN64
+	return false;
+#else
+	struct sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (inPath.string().size() >= sizeof(address.sun_path))
+		throw boss_error(BOSS_ERROR_FS_SOCKET_FAIL, inPath.string(), "The path is too long for a socket.");
+	std::strcpy(address.sun_path, inPath.string().c_str());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		throw boss_error(BOSS_ERROR_FS_SOCKET_FAIL, inPath.string(), std::strerror(errno));
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	// A socket file that nothing is listening on was left behind by a run
+	// that didn't exit cleanly. One that something is listening on isn't ours.
+	if (connect(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) == 0) {
+		close(fd);
+		throw boss_error(BOSS_ERROR_FS_SOCKET_FAIL, inPath.string(), "Another BOSS is already listening on it.");
+	}
+	close(fd);
+	boost::system::error_code ec;
+	fs::remove(inPath, ec);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		throw boss_error(BOSS_ERROR_FS_SOCKET_FAIL, inPath.string(), std::strerror(errno));
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	if (bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 ||
+	    chmod(address.sun_path, S_IRUSR | S_IWUSR) != 0 ||  // Only the user's own scripts may connect.
+	    listen(fd, 4) != 0) {
+		std::string error = std::strerror(errno);
+		close(fd);
+		fs::remove(inPath, ec);
+		throw boss_error(BOSS_ERROR_FS_SOCKET_FAIL, inPath.string(), error);
+	}
+	listenFd = fd;
+	path = inPath;
+	LOG_INFO("Listening for commands on \"%s\".", path.string().c_str());
+	return true;
+#endif
+}
+
+void CommandSocket::Close() {
+	DropClient();
+#if !(_WIN32 || _WIN64)
+	if (listenFd >= 0) {
+		close(listenFd);
+		boost::system::error_code ec;
+		fs::remove(path, ec);
+	}
+#endif
+	listenFd = -1;
+	path.clear();
+}
+
+bool CommandSocket::Wait(const int timeout, std::string &command) {
+	command.clear();
+	DropClient();  // In case the last command wasn't replied to.
+#if !(_WIN32 || _WIN64)
+	if (listenFd >= 0) {
+		struct pollfd listener = { listenFd, POLLIN, 0 };
+		if (poll(&listener, 1, timeout) <= 0 || !(listener.revents & POLLIN))
+			return false;
+		clientFd = accept(listenFd, NULL, NULL);
+		if (clientFd < 0) {
+			clientFd = -1;
+			return false;
+		}
+		fcntl(clientFd, F_SETFD, FD_CLOEXEC);
+
+		// Read up to the end of the first line.
+		char buffer[256];
+		while (command.find('\n') == std::string::npos) {
+			struct pollfd client = { clientFd, POLLIN, 0 };
+			if (poll(&client, 1, COMMAND_TIMEOUT) <= 0)
+				break;
+			ssize_t length = read(clientFd, buffer, sizeof(buffer));
+			if (length < 0 && errno == EINTR)
+				continue;
+			if (length <= 0)
+				break;
+			command.append(buffer, length);
+			if (command.size() > MAX_COMMAND_LENGTH)
+				break;
+		}
+		std::size_t end = command.find_first_of("\r\n");
+		if (end == std::string::npos || end > MAX_COMMAND_LENGTH) {
+			LOG_DEBUG("Dropped a client that didn't send a complete command.");
+			command.clear();
+			DropClient();
+			return false;
+		}
+		command.erase(end);
+		LOG_DEBUG("Received command: \"%s\"", command.c_str());
+		return true;
+	}
+#endif
+	std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+	return false;
+}
+
+void CommandSocket::Reply(const std::string &response) {
+#if !(_WIN32 || _WIN64)
+	std::size_t written = 0;
+	while (clientFd >= 0 && written < response.size()) {
+#	ifdef MSG_NOSIGNAL
+		ssize_t length = send(clientFd, response.data() + written,
+		                      response.size() - written, MSG_NOSIGNAL);
+#	else
+		ssize_t length = write(clientFd, response.data() + written,
+		                       response.size() - written);
+#	endif
+		if (length < 0 && errno == EINTR)
+			continue;
+		if (length <= 0)
+			break;  // The client has gone away.
+		written += length;
+	}
+#endif
+	DropClient();
+}
+
+void CommandSocket::DropClient() {
+#if !(_WIN32 || _WIN64)
+	if (clientFd >= 0)
+		close(clientFd);
+#endif
+	clientFd = -1;
+}
+
+}  // namespace boss
@@ -0,0 +1,73 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#ifndef SUPPORT_COMMAND_SOCKET_H_
+#define SUPPORT_COMMAND_SOCKET_H_
+
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "common/dll_def.h"
+
+namespace boss {
+
+/*
+ * A local Unix socket that scripts can send one-line commands to. Each client
+ * sends a single command terminated by a newline, waits for the reply, and is
+ * then disconnected. Only one client is served at a time. Where Unix sockets
+ * aren't available, the socket never opens and Wait() just sleeps.
+ */
+class BOSS_COMMON CommandSocket {
+ public:
+	CommandSocket();
+	~CommandSocket();
+
+	// Starts listening at path, replacing any socket file left behind by an
+	// earlier run. Returns false if Unix sockets aren't available, and throws
+	// boss_error if the socket can't be created.
+	bool Open(const boost::filesystem::path &inPath);
+	void Close();  // Also removes the socket file.
+
+	// Waits up to timeout milliseconds for a client's command. Returns true
+	// and sets command if one arrived, in which case Reply() must be called.
+	bool Wait(const int timeout, std::string &command);
+	void Reply(const std::string &response);
+
+ private:
+	void DropClient();
+
+	boost::filesystem::path path;
+	int listenFd;  // -1 if not open.
+	int clientFd;  // -1 if no client is waiting for a reply.
+
+	CommandSocket(const CommandSocket &);  // Not copyable.
+	CommandSocket &operator = (const CommandSocket &);
+};
+
+}  // namespace boss
+#endif  // SUPPORT_COMMAND_SOCKET_H_
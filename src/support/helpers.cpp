@@ -39,14 +39,23 @@
 #include "support/helpers.h"
 
 #include <sys/types.h>  // MCP Note: Possibly remove this one?
+#if !(_WIN32 || _WIN64)
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
 
+#include <cerrno>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
 
 #include <algorithm>
 #include <fstream>
 #include <iterator>
+#include <mutex>
 //#include <regex>
 #include <sstream>
 #include <string>
@@ -64,6 +73,7 @@
 #include "base/regex.h"
 #include "common/error.h"
 #include "support/logger.h"
+#include "support/profiler.h"
 
 
 
@@ -73,8 +83,114 @@ namespace fs = boost::filesystem;
 namespace karma = boost::spirit::karma;
 namespace bloc = boost::locale;
 
+namespace {
+// Unicode code points of Windows-1252 bytes 0x80-0x9F. The five bytes the
+// code page leaves undefined are 0, and are left to boost::locale.
+const std::uint16_t cp1252Block[32] = {
+	0x20AC, 0, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+	0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0, 0x017D, 0,
+	0, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+	0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0, 0x017E, 0x0178
+};
+
+// The same block the other way round, sorted by code point.
+struct Cp1252Byte {
+	std::uint16_t codePoint;
+	unsigned char byte;
+
+	bool operator<(const std::uint32_t other) const {
+		return codePoint < other;
+	}
+};
+
+const Cp1252Byte unicodeTo1252[27] = {
+	{0x0152, 0x8C}, {0x0153, 0x9C}, {0x0160, 0x8A}, {0x0161, 0x9A},
+	{0x0178, 0x9F}, {0x017D, 0x8E}, {0x017E, 0x9E}, {0x0192, 0x83},
+	{0x02C6, 0x88}, {0x02DC, 0x98}, {0x2013, 0x96}, {0x2014, 0x97},
+	{0x2018, 0x91}, {0x2019, 0x92}, {0x201A, 0x82}, {0x201C, 0x93},
+	{0x201D, 0x94}, {0x201E, 0x84}, {0x2020, 0x86}, {0x2021, 0x87},
+	{0x2022, 0x95}, {0x2026, 0x85}, {0x2030, 0x89}, {0x2039, 0x8B},
+	{0x203A, 0x9B}, {0x20AC, 0x80}, {0x2122, 0x99}
+};
+
+struct Utf8Sequence {
+	unsigned char length;  // 0 if the byte can't be converted.
+	char bytes[3];
+};
+
+// The UTF-8 encoding of every Windows-1252 byte, built on first use.
+Utf8Sequence cp1252Table[256];
+std::once_flag cp1252TableBuilt;
+
+void BuildCp1252Table() {
+	for (std::uint32_t byte = 0; byte < 256; byte++) {
+		std::uint32_t codePoint = byte;
+		if (byte >= 0x80 && byte <= 0x9F)
+			codePoint = cp1252Block[byte - 0x80];
+		Utf8Sequence &seq = cp1252Table[byte];
+		if (byte >= 0x80 && codePoint == 0) {
+			seq.length = 0;
+		} else if (codePoint < 0x80) {
+			seq.length = 1;
+			seq.bytes[0] = static_cast<char>(codePoint);
+		} else if (codePoint < 0x800) {
+			seq.length = 2;
+			seq.bytes[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+			seq.bytes[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+		} else {
+			seq.length = 3;
+			seq.bytes[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+			seq.bytes[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			seq.bytes[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+	}
+}
+
+const Utf8Sequence *Cp1252Table() {
+	std::call_once(cp1252TableBuilt, BuildCp1252Table);
+	return cp1252Table;
+}
+
+// boost::locale's conversions, for strings the tables don't cover. What happens
+// to them depends on its backend: on Windows, the undefined bytes are converted
+// to and from U+0081, U+008D, U+008F, U+0090 and U+009D, and characters without
+// a Windows-1252 byte are given their best fit, while iconv rejects both.
+std::string LocaleFrom1252ToUTF8(const std::string &str) {
+	try {
+		return bloc::conv::to_utf<char>(str, "Windows-1252", bloc::conv::stop);
+	} catch (bloc::conv::conversion_error &e) {
+		throw boss_error(BOSS_ERROR_FILE_NOT_UTF8, "\"" + str + "\" cannot be encoded in Windows-1252.");
+	}
+}
+
+std::string LocaleFromUTF8To1252(const std::string &str) {
+	try {
+		return bloc::conv::from_utf<char>(str, "Windows-1252", bloc::conv::stop);
+	} catch (bloc::conv::conversion_error &e) {
+		throw boss_error(BOSS_ERROR_FILE_NOT_UTF8, "\"" + str + "\" cannot be encoded in Windows-1252.");
+	}
+}
+
+// Returns the position of the first non-ASCII byte in data[pos, size), or size.
+// Checks eight bytes at a time while it can.
+std::size_t AsciiRunEnd(const char *data, std::size_t pos,
+                        const std::size_t size) {
+	while (size - pos >= 8) {
+		std::uint64_t word;
+		std::memcpy(&word, data + pos, 8);
+		if (word & 0x8080808080808080ULL)
+			break;
+		pos += 8;
+	}
+	while (pos < size && !(static_cast<unsigned char>(data[pos]) & 0x80))
+		pos++;
+	return pos;
+}
+}  // namespace
+
 // Calculate the CRC of the given file for comparison purposes.
 std::uint32_t GetCrc32(const fs::path &filename) {
+	TRACE_FILE_SCOPE("GetCrc32", filename);
 	std::uint32_t chksum = 0;
 	static const std::size_t buffer_size = 8192;
 	char buffer[buffer_size];
@@ -89,6 +205,7 @@ std::uint32_t GetCrc32(const fs::path &filename) {
 		do {
 			ifile.read(buffer, buffer_size);
 			result.process_bytes(buffer, ifile.gcount());
+			PROFILE_COUNT(PC_BYTES_HASHED, ifile.gcount());
 		} while (ifile);
 		chksum = result.checksum();
 	} else {
@@ -99,6 +216,24 @@ std::uint32_t GetCrc32(const fs::path &filename) {
 	return chksum;
 }
 
+std::uint64_t GetPreciseModTime(const fs::path &path) {
+#if _WIN32 || _WIN64
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if (!GetFileAttributesEx(path.wstring().c_str(), GetFileExInfoStandard, &info))
+		return 0;
+	return (std::uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+#elif __linux__
+	struct stat info;
+	if (stat(path.string().c_str(), &info) != 0)
+		return 0;
+	return std::uint64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#else
+	boost::system::error_code ec;
+	std::time_t modTime = fs::last_write_time(path, ec);
+	return ec ? 0 : std::uint64_t(modTime);
+#endif
+}
+
 // Reads an entire file into a string buffer.
 void fileToBuffer(const fs::path file, std::string &buffer) {
 	// MCP Note: changed from file.c_str() to file.string(); needs testing as error was about not being able to convert wchar_t to char
@@ -114,6 +249,47 @@ void fileToBuffer(const fs::path file, std::string &buffer) {
 	          std::back_inserter(buffer));
 }
 
+void bufferToFile(const fs::path file, const std::string &buffer) {
+	TRACE_FILE_SCOPE("bufferToFile", file);
+	fs::path tempFile = file.string() + ".tmp";
+	bool written = false;
+#if _WIN32 || _WIN64
+	HANDLE handle = CreateFile(tempFile.wstring().c_str(), GENERIC_WRITE, 0,
+	                           NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle != INVALID_HANDLE_VALUE) {
+		DWORD count = 0;
+		written = WriteFile(handle, buffer.data(), DWORD(buffer.size()), &count, NULL)
+		          && count == buffer.size()
+		          && FlushFileBuffers(handle);
+		written = CloseHandle(handle) && written;
+		written = written && MoveFileEx(tempFile.wstring().c_str(),
+		                                file.wstring().c_str(),
+		                                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+	}
+#else
+	int fd = open(tempFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd != -1) {
+		written = true;
+		std::size_t pos = 0;
+		while (written && pos < buffer.size()) {
+			ssize_t count = write(fd, buffer.data() + pos, buffer.size() - pos);
+			if (count >= 0)
+				pos += count;
+			else if (errno != EINTR)
+				written = false;
+		}
+		written = fsync(fd) == 0 && written;
+		written = close(fd) == 0 && written;
+		written = written && rename(tempFile.c_str(), file.c_str()) == 0;
+	}
+#endif
+	if (!written) {
+		boost::system::error_code ec;
+		fs::remove(tempFile, ec);
+		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
+	}
+}
+
 // Converts an integer to a string using BOOST's Spirit.Karma, which is apparently a lot faster than a stringstream conversion...
 BOSS_COMMON std::string IntToString(const std::uint32_t n) {
 	std::string out;
@@ -145,22 +321,87 @@ bool StringToBool(std::string str) {
 
 // Convert a Windows-1252 string to UTF-8.
 std::string From1252ToUTF8(const std::string &str) {
-	try {
-		return bloc::conv::to_utf<char>(str, "Windows-1252", bloc::conv::stop);
-	}
-	catch (bloc::conv::conversion_error &e) {
-		throw boss_error(BOSS_ERROR_FILE_NOT_UTF8, "\"" + str + "\" cannot be encoded in Windows-1252.");
+	const char *data = str.data();
+	const std::size_t size = str.size();
+	std::size_t i = AsciiRunEnd(data, 0, size);
+	if (i == size)
+		return str;
+
+	const Utf8Sequence *table = Cp1252Table();
+	std::string out;
+	out.reserve(size + size / 2);
+	out.append(data, i);
+	while (i < size) {
+		const Utf8Sequence &seq = table[static_cast<unsigned char>(data[i])];
+		if (seq.length == 0)
+			return LocaleFrom1252ToUTF8(str);
+		out.append(seq.bytes, seq.length);
+		std::size_t end = AsciiRunEnd(data, ++i, size);
+		out.append(data + i, end - i);
+		i = end;
 	}
+	return out;
 }
 
 // Convert a UTF-8 string to Windows-1252.
 std::string FromUTF8To1252(const std::string &str) {
-	try {
-		return bloc::conv::from_utf<char>(str, "Windows-1252", bloc::conv::stop);
-	}
-	catch (bloc::conv::conversion_error &e) {
-		throw boss_error(BOSS_ERROR_FILE_NOT_UTF8, "\"" + str + "\" cannot be encoded in Windows-1252.");
+	const char *data = str.data();
+	const std::size_t size = str.size();
+	std::size_t i = AsciiRunEnd(data, 0, size);
+	if (i == size)
+		return str;
+
+	std::string out;
+	out.reserve(size);
+	out.append(data, i);
+	while (i < size) {
+		// Decode one multi-byte sequence. Anything malformed or overlong is left
+		// to boost::locale to reject.
+		const unsigned char lead = static_cast<unsigned char>(data[i]);
+		std::size_t length;
+		std::uint32_t codePoint, minimum;
+		if (lead >= 0xC2 && lead <= 0xDF) {
+			length = 2;
+			codePoint = lead & 0x1F;
+			minimum = 0x80;
+		} else if (lead >= 0xE0 && lead <= 0xEF) {
+			length = 3;
+			codePoint = lead & 0x0F;
+			minimum = 0x800;
+		} else if (lead >= 0xF0 && lead <= 0xF4) {
+			length = 4;
+			codePoint = lead & 0x07;
+			minimum = 0x10000;
+		} else {
+			length = 0;
+		}
+		if (length == 0 || size - i < length)
+			return LocaleFromUTF8To1252(str);
+		for (std::size_t j = 1; j < length; j++) {
+			const unsigned char next = static_cast<unsigned char>(data[i + j]);
+			if ((next & 0xC0) != 0x80)
+				return LocaleFromUTF8To1252(str);
+			codePoint = (codePoint << 6) | (next & 0x3F);
+		}
+		if (codePoint < minimum)
+			return LocaleFromUTF8To1252(str);
+
+		// 0xA0-0xFF are the same in both, and 0x80-0x9F are looked up.
+		if (codePoint >= 0xA0 && codePoint <= 0xFF) {
+			out += static_cast<char>(codePoint);
+		} else {
+			const Cp1252Byte *end = unicodeTo1252 + sizeof(unicodeTo1252) / sizeof(unicodeTo1252[0]);
+			const Cp1252Byte *found = std::lower_bound(unicodeTo1252, end, codePoint);
+			if (found == end || found->codePoint != codePoint)
+				return LocaleFromUTF8To1252(str);
+			out += static_cast<char>(found->byte);
+		}
+		i += length;
+		std::size_t runEnd = AsciiRunEnd(data, i, size);
+		out.append(data + i, runEnd - i);
+		i = runEnd;
 	}
+	return out;
 }
 
 // Check if registry subkey exists.
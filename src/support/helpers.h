@@ -45,9 +45,17 @@ namespace boss {
 // Calculate the CRC of the given file for comparison purposes.
 std::uint32_t GetCrc32(const boost::filesystem::path &filename);
 
+// Gets a file's or folder's modification time as finely as the platform records it, in the platform's own units, so that
+// changes made within the same second can be told apart. Returns 0 if it can't be read.
+std::uint64_t GetPreciseModTime(const boost::filesystem::path &path);
+
 // Reads an entire file into a string buffer.
 void fileToBuffer(const boost::filesystem::path file, std::string &buffer);
 
+// Replaces a file with the contents of a string buffer, by writing them to a temporary file in one go, flushing it to disk, then
+// renaming it over the file. The file is never left half-written. Throws BOSS_ERROR_FILE_WRITE_FAIL on fail.
+void bufferToFile(const boost::filesystem::path file, const std::string &buffer);
+
 // Converts an integer to a string using BOOST's Spirit.Karma. Faster than a stringstream conversion.
 BOSS_COMMON std::string IntToString(const std::uint32_t n);
 
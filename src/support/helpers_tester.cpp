@@ -0,0 +1,164 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+
+// Checks that the Windows-1252 conversions give the same results as the
+// boost::locale conversions they replaced, on whichever backend boost::locale
+// was built with. On Windows that's WConv, so the five bytes Windows-1252
+// leaves undefined and characters it has no byte for are also checked against
+// what WConv is known to give. Returns non-zero if any check fails.
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <iostream>
+#include <string>
+
+#include <boost/locale.hpp>
+
+#include "common/error.h"
+#include "support/helpers.h"
+
+namespace bloc = boost::locale;
+
+namespace {
+
+std::size_t failures = 0;
+
+// Prints a string's bytes in hex, for failure messages.
+std::string Hex(const std::string &str) {
+	static const char digits[] = "0123456789ABCDEF";
+	std::string out;
+	for (std::size_t i = 0; i < str.size(); i++) {
+		const unsigned char byte = static_cast<unsigned char>(str[i]);
+		if (i > 0)
+			out += ' ';
+		out += digits[byte >> 4];
+		out += digits[byte & 0xF];
+	}
+	return out;
+}
+
+// Gives the converted string, or "error" if the conversion failed.
+std::string From1252(const std::string &str) {
+	try {
+		return boss::From1252ToUTF8(str);
+	} catch (boss::boss_error &e) {
+		return "error";
+	}
+}
+
+std::string To1252(const std::string &str) {
+	try {
+		return boss::FromUTF8To1252(str);
+	} catch (boss::boss_error &e) {
+		return "error";
+	}
+}
+
+std::string LocaleFrom1252(const std::string &str) {
+	try {
+		return bloc::conv::to_utf<char>(str, "Windows-1252", bloc::conv::stop);
+	} catch (bloc::conv::conversion_error &e) {
+		return "error";
+	}
+}
+
+std::string LocaleTo1252(const std::string &str) {
+	try {
+		return bloc::conv::from_utf<char>(str, "Windows-1252", bloc::conv::stop);
+	} catch (bloc::conv::conversion_error &e) {
+		return "error";
+	}
+}
+
+void Check(const std::string &what, const std::string &input,
+           const std::string &result, const std::string &expected) {
+	if (result == expected)
+		return;
+	failures++;
+	std::cerr << what << " of [" << Hex(input) << "] gave [" << Hex(result)
+	          << "], expected [" << Hex(expected) << "]" << std::endl;
+}
+
+// Checks both directions against boost::locale, alone and inside ASCII text,
+// which takes the conversions' fast paths.
+void CheckFrom1252(const std::string &str) {
+	Check("From1252ToUTF8", str, From1252(str), LocaleFrom1252(str));
+	const std::string padded = "Plugin " + str + " Name.esp";
+	Check("From1252ToUTF8", padded, From1252(padded), LocaleFrom1252(padded));
+}
+
+void CheckToUTF8(const std::string &str) {
+	Check("FromUTF8To1252", str, To1252(str), LocaleTo1252(str));
+	const std::string padded = "Plugin " + str + " Name.esp";
+	Check("FromUTF8To1252", padded, To1252(padded), LocaleTo1252(padded));
+}
+
+}  // namespace
+
+int main() {
+	// Every byte.
+	for (int byte = 0; byte < 256; byte++)
+		CheckFrom1252(std::string(1, static_cast<char>(byte)));
+
+	// The five undefined bytes, as C1 controls.
+	const char *undefined[] = {"\xC2\x81", "\xC2\x8D", "\xC2\x8F", "\xC2\x90", "\xC2\x9D"};
+	for (std::size_t i = 0; i < 5; i++)
+		CheckToUTF8(undefined[i]);
+
+	// Characters Windows-1252 has bytes for, and some it doesn't: Latin
+	// Extended-A and -B letters that have best fits, other BMP characters,
+	// characters outside the BMP, tag characters, and malformed UTF-8.
+	const char *utf8[] = {
+		"\xC2\xA0", "\xC3\xBF", "\xE2\x82\xAC", "\xE2\x84\xA2", "\xC5\xB8",
+		"\xC4\x80", "\xC5\x81", "\xC7\x8D", "\xE2\x88\x92", "\xE4\xB8\x80",
+		"\xF0\x9F\x98\x80", "\xF3\xA0\x81\x81",
+		"\xC2", "\xC0\xAF", "\xE0\x80\xAF", "\xED\xA0\x80", "\xFF", "\x80"
+	};
+	for (std::size_t i = 0; i < sizeof(utf8) / sizeof(utf8[0]); i++)
+		CheckToUTF8(utf8[i]);
+
+#if _WIN32 || _WIN64
+	// What WConv gives, which iconv doesn't: the undefined bytes round-trip
+	// through the C1 controls, and letters without a byte get their best fit.
+	const char undefinedBytes[] = {'\x81', '\x8D', '\x8F', '\x90', '\x9D'};
+	for (std::size_t i = 0; i < 5; i++) {
+		const std::string byte(1, undefinedBytes[i]);
+		Check("From1252ToUTF8", byte, From1252(byte), undefined[i]);
+		Check("FromUTF8To1252", undefined[i], To1252(undefined[i]), byte);
+	}
+	Check("FromUTF8To1252", "\xC4\x80", To1252("\xC4\x80"), "A");
+#endif
+
+	if (failures != 0) {
+		std::cerr << failures << " conversions differed." << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "All conversions matched." << std::endl;
+	return EXIT_SUCCESS;
+}
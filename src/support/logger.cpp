@@ -28,8 +28,19 @@
 #include "support/logger.h"
 
 #include <cstdarg>
+#include <cstddef>
 #include <cstdio>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "support/thread_specific.h"
+
 
 // The values in the LogVerbosity enum refer to indices in this array
 // MCP Note: Are the spaces inside the quotes supposed to be there?
@@ -42,6 +53,11 @@ namespace boss {
 // The global logger instance
 BOSS_COMMON Logger g_logger;
 
+// Set by setThreadContext(), and put before each of the thread's messages.
+// Only looked up once some thread has set one.
+static ThreadSpecific<std::string> threadContext;
+static std::atomic<bool> threadContextSet(false);
+
 /*
  * Ensures the given verbosity is within the valid range
  * Returns false if the verbosity is beyond LV_OFF
@@ -65,7 +81,35 @@ static inline bool _checkVerbosity(LogVerbosity &verbosity) {
 }
 
 // Sets the default verbosity to WARN and origin tracking off
-Logger::Logger() : m_verbosity(LV_WARN), m_out(stdout) {}
+Logger::Logger()
+    : m_verbosity(LV_WARN),
+      m_out(stdout),
+      m_enqueuePos(0),
+      m_dequeuePos(0),
+      m_writtenPos(0),
+      m_stop(false),
+      m_writerDone(false),
+      m_stopping(false) {
+	for (std::size_t i = 0; i < RING_SIZE; i++)
+		m_ring[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+// If stop() wasn't called, tells the writer thread to finish and lets it go
+// once it has. It isn't joined, as its exit can be held up by the loader lock.
+Logger::~Logger() {
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_writer.joinable()) {
+			m_stop = true;
+			m_wake.notify_one();
+			m_drained.wait_for(lock, std::chrono::seconds(1),
+			                   [this]() { return m_writerDone; });
+			m_writer.detach();
+		}
+	}
+	if (m_out != stdout && m_out != NULL)
+		std::fclose(m_out);
+}
 
 // Sets the verbosity to the given value
 // Bounds are checked and boxed by _checkVerbosity (above)
@@ -74,31 +118,196 @@ void Logger::setVerbosity(LogVerbosity verbosity) {
 		return;
 	}
 
-	m_verbosity = verbosity;
+	m_verbosity.store(verbosity, std::memory_order_relaxed);
+}
+
+// Messages already logged go to the old stream
+void Logger::setStream(const char *file) {
+	flush();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_out != stdout && m_out != NULL)
+		std::fclose(m_out);
+	m_out = std::fopen(file, "w");
+	if (m_out == NULL)
+		m_out = stdout;  // Console output carries on regardless.
+}
+
+void Logger::setThreadContext(const std::string &context) {
+	if (context.empty()) {
+		threadContext.Release();
+		return;
+	}
+	threadContext.Get() = context + ": ";
+	threadContextSet = true;
+}
+
+void Logger::flush() {
+	std::size_t target = m_enqueuePos.load(std::memory_order_acquire);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	// Once the writer's done, each logger writes its own messages before returning.
+	while (!m_writerDone && m_writtenPos < target) {
+		m_wake.notify_one();
+		m_drained.wait_for(lock, std::chrono::milliseconds(10));
+	}
+}
+
+void Logger::stop() {
+	std::thread writer;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+		m_stopping.store(true);
+		if (m_writer.joinable())
+			writer.swap(m_writer);
+		else
+			m_writerDone = true;  // It never started, and now it won't.
+	}
+	m_wake.notify_one();
+	if (writer.joinable())
+		writer.join();
 }
 
-// Formats the message and prints to stdout
+// Formats the message on the calling thread and queues it for writing
 void Logger::_log(LogVerbosity verbosity, const char *formatStr,
                   std::va_list ap) {
 	if (!_checkVerbosity(verbosity)) {
 		return;
 	}
 
-	// Assumes single thread -- multithread could interleave the lines below
-	// A thread safe version would use vasprintf to print to a temporary string first
-	std::printf("%s", LOG_VERBOSITY_NAMES[verbosity]);
+	// Most messages fit on the stack, so nothing is shared until the message is queued.
+	// The va_list is copied for the first attempt, as it may need to be used again.
+	char stackBuffer[256];
+	std::vector<char> heapBuffer;
+	char *buffer = stackBuffer;
+	std::va_list apCopy;
+	va_copy(apCopy, ap);
+	int length = std::vsnprintf(stackBuffer, sizeof(stackBuffer), formatStr, apCopy);
+	va_end(apCopy);
+	if (length < 0)
+		return;
+	if (static_cast<std::size_t>(length) >= sizeof(stackBuffer)) {
+		heapBuffer.resize(length + 1);
+		buffer = &heapBuffer[0];
+		std::vsnprintf(buffer, heapBuffer.size(), formatStr, ap);
+	}
 
-	std::printf(": ");
-	std::vprintf(formatStr, ap);
-	std::printf("\n");
-	std::fflush(stdout);
+	std::call_once(m_writerStarted, [this]() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_stop)
+			m_writer = std::thread(&Logger::_writerLoop, this);
+	});
+	const std::string *context = threadContextSet ? threadContext.Find() : NULL;
+	if (context == NULL) {
+		_enqueue(verbosity, buffer, length);
+	} else {
+		std::string text = *context;
+		text.append(buffer, length);
+		_enqueue(verbosity, text.data(), text.size());
+	}
+}
+
+/*
+ * Multiple-producer, single-consumer bounded queue.
+ * Producers claim a position with a compare-and-swap and publish the
+ * message by bumping the slot's sequence number. If the ring is full,
+ * producers wait for the writer to free up a slot.
+ */
+void Logger::_enqueue(LogVerbosity verbosity, const char *text,
+                      std::size_t length) {
+	std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+	Record *record;
+	for (;;) {
+		record = &m_ring[pos & (RING_SIZE - 1)];
+		std::size_t sequence = record->sequence.load(std::memory_order_acquire);
+		if (sequence == pos) {
+			if (m_enqueuePos.compare_exchange_weak(pos, pos + 1,
+			                                       std::memory_order_relaxed))
+				break;
+		} else if (sequence < pos) {  // Full.
+			m_wake.notify_one();
+			std::this_thread::yield();
+			pos = m_enqueuePos.load(std::memory_order_relaxed);
+		} else {
+			pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+	record->verbosity = verbosity;
+	record->text.assign(text, length);
+	record->sequence.store(pos + 1, std::memory_order_release);
+	m_wake.notify_one();
+
+	// Pairs with stop(), so that either the writer sees this message or this sees stop().
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_stopping.load()) {
+		// Write it, and anything before it, if the writer thread won't.
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_writerDone) {
+			std::string batch;
+			std::size_t count = _dequeue(batch);
+			if (count != 0)
+				_write(batch, count);
+		}
+	}
+}
+
+// Moves all published messages into batch. Returns the number taken.
+std::size_t Logger::_dequeue(std::string &batch) {
+	std::size_t pos = m_dequeuePos;
+	std::size_t count = 0;
+	for (;;) {
+		Record &record = m_ring[pos & (RING_SIZE - 1)];
+		if (record.sequence.load(std::memory_order_acquire) != pos + 1)
+			break;
+		batch.append(LOG_VERBOSITY_NAMES[record.verbosity]);
+		batch.append(": ");
+		batch.append(record.text);
+		batch.append("\n");
+		record.sequence.store(pos + RING_SIZE, std::memory_order_release);
+		++pos;
+		++count;
+	}
+	m_dequeuePos = pos;
+	return count;
+}
 
+// Writes out count messages taken off by _dequeue. m_mutex must be held.
+void Logger::_write(const std::string &batch, std::size_t count) {
+	std::fwrite(batch.data(), 1, batch.size(), stdout);
+	std::fflush(stdout);
 	if (m_out != stdout) {
-		std::fprintf(m_out, "%s: ", LOG_VERBOSITY_NAMES[verbosity]);
-		std::vfprintf(m_out, formatStr, ap);
-		std::fprintf(m_out, "\n");
+		std::fwrite(batch.data(), 1, batch.size(), m_out);
 		std::fflush(m_out);
 	}
+	m_writtenPos += count;
+	m_drained.notify_all();
+}
+
+void Logger::_writerLoop() {
+	std::string batch;
+	for (;;) {
+		batch.clear();
+		std::size_t count = _dequeue(batch);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		// Anything published after stop() was called is written by whoever
+		// logged it, once this is done. Look again under the lock so that
+		// nothing published in between is missed.
+		if (count == 0 && m_stop)
+			count = _dequeue(batch);
+		if (count != 0) {
+			_write(batch, count);
+			continue;
+		}
+		m_drained.notify_all();
+		if (m_stop) {
+			m_writerDone = true;
+			m_drained.notify_all();
+			break;
+		}
+		// Producers don't take the lock to signal, so don't wait indefinitely.
+		m_wake.wait_for(lock, std::chrono::milliseconds(10));
+	}
 }
 
 }  // namespace boss
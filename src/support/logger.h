@@ -29,17 +29,40 @@
 #define SUPPORT_LOGGER_H_
 
 #include <cstdarg>
+#include <cstddef>
 #include <cstdio>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
 #include "common/dll_def.h"
 #include "support/platform.h"
 
+/*
+ * The most verbose level that is compiled in. Log statements above it are
+ * removed entirely, so builds that don't need trace output can define this
+ * as e.g. 3 (LV_INFO) to drop all debug and trace call sites.
+ */
+#ifndef BOSS_LOG_MAX_VERBOSITY
+#define BOSS_LOG_MAX_VERBOSITY 5
+#endif
+
 /*
  * TODO(MCP): Look at replacing this with a portable version so it's not relying on extensions.
  * Possibly make formatStr part of the variable arguments?
+ *
+ * The verbosity is checked before the arguments are evaluated, so disabled
+ * statements don't build strings that are then thrown away.
  */
 #define _LOG_IMPL(verbosity, formatStr, ...) \
-	boss::g_logger.log(verbosity, formatStr, ##__VA_ARGS__)
+	do { \
+		if ((verbosity) <= BOSS_LOG_MAX_VERBOSITY && \
+		    boss::g_logger.isEnabled(verbosity)) \
+			boss::g_logger.log(verbosity, formatStr, ##__VA_ARGS__); \
+	} while (0)
 
 // Convenience macros
 #define LOG_ERROR(formatStr, ...) _LOG_IMPL(boss::LV_ERROR, formatStr, ##__VA_ARGS__)
@@ -60,17 +83,39 @@ enum LogVerbosity {
 	LV_TRACE = 5
 };
 
-// A simple logging class.  Not implemented to be thread safe.
+/*
+ * A thread safe logging class.
+ * Messages are formatted on the calling thread and pushed onto a lock-free
+ * ring buffer. A background thread, started with the first message, takes
+ * them off in batches and writes them to the console and the output stream.
+ * The thread must be stopped with stop() before the program or library exits,
+ * as joining it from a static destructor can deadlock when a DLL is unloaded.
+ */
 class BOSS_COMMON Logger {
  public:
 	Logger();
+	~Logger();  // Doesn't join the writer thread. Call stop() first.
 
 	// Sets the verbosity limit
 	void setVerbosity(LogVerbosity verbosity);
 
 	// Sets the output stream
-	inline void setStream(const char *file) {
-		m_out = std::fopen(file, "w");
+	void setStream(const char *file);
+
+	// Blocks until all messages logged so far have been written
+	void flush();
+
+	// Writes out any queued messages and stops the writer thread. Messages
+	// logged afterwards are written by the thread that logs them.
+	void stop();
+
+	// Prefixes the messages logged by the calling thread, eg. with the name of
+	// what it's working on, so that threads' interleaved messages can be told apart.
+	void setThreadContext(const std::string &context);
+
+	// Checked by the LOG macros before their arguments are evaluated
+	inline bool isEnabled(LogVerbosity verbosity) {
+		return _isVerbosityEnabled(verbosity);
 	}
 
 	// For use when calculating the arguments to a LOG macro would be expensive
@@ -94,14 +139,45 @@ class BOSS_COMMON Logger {
 	}
 
  private:
-	LogVerbosity m_verbosity;
+	// A slot in the ring buffer. The sequence number says whose turn it is:
+	// equal to the slot's position when free, one more when it holds a message.
+	struct Record {
+		std::atomic<std::size_t> sequence;
+		LogVerbosity verbosity;
+		std::string text;
+	};
+
+	static const std::size_t RING_SIZE = 1024;  // Must be a power of two.
+
+	Logger(const Logger &);
+	Logger& operator= (const Logger &);
+
+	std::atomic<int> m_verbosity;
 	FILE *m_out;
 
+	Record m_ring[RING_SIZE];
+	std::atomic<std::size_t> m_enqueuePos;
+	std::size_t m_dequeuePos;  // Only advanced by the writer thread, or once it's stopped, under m_mutex.
+	std::size_t m_writtenPos;  // Advanced once the messages taken off have been written.
+
+	std::thread m_writer;
+	std::once_flag m_writerStarted;
+	std::mutex m_mutex;                 // Guards m_out, m_writer, m_writtenPos, m_stop and m_writerDone.
+	std::condition_variable m_wake;     // Signalled when there are messages to write.
+	std::condition_variable m_drained;  // Signalled when the writer has caught up.
+	bool m_stop;
+	bool m_writerDone;                  // Set once the writer thread has nothing more to do.
+	std::atomic<bool> m_stopping;       // Set by stop(), so that loggers write their own messages.
+
 	inline bool _isVerbosityEnabled(LogVerbosity verbosity) {
-		return verbosity <= m_verbosity;
+		return verbosity <= m_verbosity.load(std::memory_order_relaxed);
 	}
 
 	void _log(LogVerbosity verbosity, const char *formatStr, std::va_list ap);
+	void _enqueue(LogVerbosity verbosity, const char *text, std::size_t length);
+	std::size_t _dequeue(std::string &batch);
+	void _write(const std::string &batch, std::size_t count);
+	void _writerLoop();
 };
 
 // Declare global logger
@@ -41,6 +41,7 @@
 #include "base/fstream.h"
 #include "base/regex.h"
 //#include "support/helpers.h"  // MCP Note: Don't think this one is needed. Will delete later after confirmation
+#include "support/profiler.h"
 #include "support/types.h"
 #include "support/version_regex.h"
 
@@ -140,6 +141,8 @@ ModHeader ReadHeader(fs::path filename) {
 	char buffer[MAXLENGTH];
 	char *bufptr = buffer;
 	ModHeader modHeader;
+	PROFILE_COUNT(PC_HEADERS_READ, 1);
+	TRACE_FILE_SCOPE("ReadHeader", filename);
 	// MCP Note: changed from filename.native().c_str() to filename.string(); needs testing as error was about not being able to convert wchar_t to char
 	//ifstream file(filename.native().c_str(), ios_base::binary | ios_base::in);
 	//std::ifstream file(filename.string(), std::ios_base::binary | std::ios_base::in);
@@ -229,6 +232,8 @@ bool IsPluginMaster(fs::path filename) {
 
 	if (filename.empty())
 		return false;
+	PROFILE_COUNT(PC_HEADERS_READ, 1);
+	TRACE_FILE_SCOPE("IsPluginMaster", filename);
 
 	// MCP Note: changed from filename.native().c_str() to filename.string(); needs testing as error was about not being able to convert wchar_t to char
 	// Note 2: According to Boost docs, c_str() is the same as specifying native().c_str()?
@@ -0,0 +1,384 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#include "support/profiler.h"
+
+#include <cstdint>
+#include <cstdio>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "base/fstream.h"
+#include "common/error.h"
+
+namespace boss {
+
+namespace fs = boost::filesystem;
+
+// The values in the ProfileCounter enum refer to indices in this array.
+static const char *PROFILE_COUNTER_NAMES[] = {
+	"files_stated",
+	"headers_read",
+	"bytes_hashed",
+	"conditions_evaluated",
+	"regexes_compiled",
+	"rules_applied",
+	"timestamps_written"
+};
+
+// The global profiler and tracer instances
+BOSS_COMMON Profiler g_profiler;
+BOSS_COMMON Tracer g_tracer;
+
+BOSS_COMMON const char *ProfileCounterName(ProfileCounter counter) {
+	if (counter < 0 || counter >= PC_MAX)
+		return "";
+	return PROFILE_COUNTER_NAMES[counter];
+}
+
+static std::string FormatMilliseconds(double milliseconds) {
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.3f", milliseconds);
+	return buffer;
+}
+
+// Strings are already UTF-8, so only quotes, backslashes and control
+// characters need escaping.
+static std::string EscapeJSON(const std::string &str) {
+	std::string out;
+	out.reserve(str.length());
+	for (std::size_t i = 0; i < str.length(); i++) {
+		unsigned char c = static_cast<unsigned char>(str[i]);
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += str[i];
+		} else if (c < 0x20) {
+			char buffer[8];
+			std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+			out += buffer;
+		} else {
+			out += str[i];
+		}
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+// Profiler Class Functions
+//////////////////////////////
+
+Profiler::Profiler()
+    : enabled(false),
+      start(std::chrono::steady_clock::now()) {
+	for (std::size_t i = 0; i < PC_MAX; i++)
+		counters[i] = 0;
+}
+
+void Profiler::Enable(bool enable) {
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool Profiler::IsEnabled() const {
+	return enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::Reset() {
+	std::lock_guard<std::mutex> lock(mutex);
+	phases.clear();
+	for (std::size_t i = 0; i < PC_MAX; i++)
+		counters[i] = 0;
+	start = std::chrono::steady_clock::now();
+}
+
+void Profiler::AddTime(const char *phase, double milliseconds) {
+	std::lock_guard<std::mutex> lock(mutex);
+	// There are only ever a handful of phases, so a linear search is fine.
+	for (std::vector<Phase>::iterator it = phases.begin(); it != phases.end(); ++it) {
+		if (it->name == phase) {
+			it->calls++;
+			it->milliseconds += milliseconds;
+			return;
+		}
+	}
+	Phase newPhase;
+	newPhase.name = phase;
+	newPhase.calls = 1;
+	newPhase.milliseconds = milliseconds;
+	phases.push_back(newPhase);
+}
+
+void Profiler::Increment(ProfileCounter counter, std::uint64_t n) {
+	if (counter >= 0 && counter < PC_MAX)
+		counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+std::uint64_t Profiler::Counter(ProfileCounter counter) const {
+	if (counter < 0 || counter >= PC_MAX)
+		return 0;
+	return counters[counter].load(std::memory_order_relaxed);
+}
+
+std::vector<Profiler::Phase> Profiler::Phases() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return phases;
+}
+
+double Profiler::TotalMilliseconds() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string Profiler::AsText() const {
+	std::vector<Phase> phaseList = Phases();
+	char line[128];
+	std::snprintf(line, sizeof(line), "%-36s %7s %16s\n", "Phase", "Calls", "Time (ms)");
+	std::string text = line;
+	for (std::size_t i = 0; i < phaseList.size(); i++) {
+		std::snprintf(line, sizeof(line), "%-36s %7llu %16.3f\n",
+		              phaseList[i].name.c_str(),
+		              static_cast<unsigned long long>(phaseList[i].calls),
+		              phaseList[i].milliseconds);
+		text += line;
+	}
+	std::snprintf(line, sizeof(line), "%-36s %7s %16.3f\n", "Total", "",
+	              TotalMilliseconds());
+	text += line;
+
+	std::snprintf(line, sizeof(line), "\n%-36s %17s\n", "Counter", "Value");
+	text += line;
+	for (std::size_t i = 0; i < PC_MAX; i++) {
+		std::snprintf(line, sizeof(line), "%-36s %17llu\n",
+		              PROFILE_COUNTER_NAMES[i],
+		              static_cast<unsigned long long>(Counter(static_cast<ProfileCounter>(i))));
+		text += line;
+	}
+	return text;
+}
+
+std::string Profiler::AsJSON() const {
+	std::vector<Phase> phaseList = Phases();
+	std::string json = "{\n\t\"total_ms\": " + FormatMilliseconds(TotalMilliseconds()) + ",\n\t\"phases\": [";
+	for (std::size_t i = 0; i < phaseList.size(); i++) {
+		if (i > 0)
+			json += ',';
+		json += "\n\t\t{\"name\": \"" + EscapeJSON(phaseList[i].name)
+		      + "\", \"calls\": " + std::to_string(phaseList[i].calls)
+		      + ", \"ms\": " + FormatMilliseconds(phaseList[i].milliseconds) + '}';
+	}
+	json += "\n\t],\n\t\"counters\": {";
+	for (std::size_t i = 0; i < PC_MAX; i++) {
+		if (i > 0)
+			json += ',';
+		json += "\n\t\t\"" + std::string(PROFILE_COUNTER_NAMES[i]) + "\": "
+		      + std::to_string(Counter(static_cast<ProfileCounter>(i)));
+	}
+	json += "\n\t}\n}\n";
+	return json;
+}
+
+void Profiler::SaveJSON(const fs::path file) const {
+	boss_fstream::ofstream outFile(file);
+	if (outFile.fail())
+		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
+	outFile << AsJSON();
+	outFile.close();
+	if (outFile.fail())
+		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
+}
+
+
+//////////////////////////////
+// Tracer Class Functions
+//////////////////////////////
+
+Tracer::Tracer()
+    : enabled(false),
+      start(std::chrono::steady_clock::now()) {}
+
+void Tracer::Enable(bool enable) {
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool Tracer::IsEnabled() const {
+	return enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::Reset() {
+	std::lock_guard<std::mutex> lock(mutex);
+	events.clear();
+	lanes.clear();
+	start = std::chrono::steady_clock::now();
+}
+
+void Tracer::Begin(const char *name, const std::string &file) {
+	Record(name, 'B', file);
+}
+
+void Tracer::End(const char *name) {
+	Record(name, 'E', "");
+}
+
+void Tracer::Record(const char *name, char phase, const std::string &file) {
+	Event event;
+	event.name = name;
+	event.phase = phase;
+	event.file = file;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	// Each thread gets its own lane, numbered in the order they first record an event.
+	std::map<std::thread::id, std::uint32_t>::const_iterator lane = lanes.insert(std::make_pair(std::this_thread::get_id(), static_cast<std::uint32_t>(lanes.size()))).first;
+	event.lane = lane->second;
+	event.microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	events.push_back(event);
+}
+
+// Adds an event to a list of them, naming its lane first if this is the first
+// time the lane has appeared. Starts with a comma unless the list is empty.
+void Tracer::AppendEvent(std::string &json, const Event &event,
+                         std::vector<bool> &lanesNamed) const {
+	if (!json.empty() && json[json.size() - 1] != '[')
+		json += ',';
+	if (event.lane >= lanesNamed.size())
+		lanesNamed.resize(event.lane + 1, false);
+	if (!lanesNamed[event.lane]) {
+		json += "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+		      + std::to_string(event.lane) + ", \"args\": {\"name\": \"Thread "
+		      + std::to_string(event.lane) + "\"}},";
+		lanesNamed[event.lane] = true;
+	}
+	json += "\n{\"name\": \"" + EscapeJSON(event.name)
+	      + "\", \"cat\": \"boss\", \"ph\": \"" + event.phase
+	      + "\", \"ts\": " + std::to_string(event.microseconds)
+	      + ", \"pid\": 1, \"tid\": " + std::to_string(event.lane);
+	if (!event.file.empty())
+		json += ", \"args\": {\"file\": \"" + EscapeJSON(event.file) + "\"}";
+	json += '}';
+}
+
+std::string Tracer::AsJSON() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+	std::vector<bool> lanesNamed;
+	for (std::size_t i = 0; i < events.size(); i++)
+		AppendEvent(json, events[i], lanesNamed);
+	json += "\n]}\n";
+	return json;
+}
+
+void Tracer::SaveJSON(const fs::path file) const {
+	boss_fstream::ofstream outFile(file);
+	if (outFile.fail())
+		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
+	outFile << AsJSON();
+	outFile.close();
+	if (outFile.fail())
+		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
+}
+
+// Uses the JSON array format, whose closing bracket is optional, so that each
+// flush can just be appended to the file.
+void Tracer::FlushJSON(const fs::path file) {
+	std::lock_guard<std::mutex> lock(mutex);
+	bool started = file == flushedTo;
+	if (started && events.empty())
+		return;
+	std::string json = started ? "" : "[";
+	if (!started)
+		flushedLanesNamed.clear();
+	for (std::size_t i = 0; i < events.size(); i++)
+		AppendEvent(json, events[i], flushedLanesNamed);
+	if (started)
+		json.insert(0, 1, ',');  // After the events already in the file.
+
+	boss_fstream::ofstream outFile(file, started ? std::ios_base::app : std::ios_base::trunc);
+	if (outFile.fail())
+		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
+	outFile << json;
+	outFile.close();
+	if (outFile.fail())
+		throw boss_error(BOSS_ERROR_FILE_WRITE_FAIL, file.string());
+	flushedTo = file;
+	events.clear();
+}
+
+
+////////////////////////////////
+// ScopedTimer Class Functions
+////////////////////////////////
+
+ScopedTimer::ScopedTimer(const char *inPhase)
+    : phase(inPhase),
+      active(g_profiler.IsEnabled()),
+      traced(g_tracer.IsEnabled()) {
+	if (traced)
+		g_tracer.Begin(phase);
+	if (active)
+		start = std::chrono::steady_clock::now();
+}
+
+ScopedTimer::~ScopedTimer() {
+	if (active)
+		g_profiler.AddTime(phase, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	if (traced)
+		g_tracer.End(phase);
+}
+
+
+///////////////////////////////
+// TraceScope Class Functions
+///////////////////////////////
+
+TraceScope::TraceScope(const char *inName)
+    : name(inName),
+      active(g_tracer.IsEnabled()) {
+	if (active)
+		g_tracer.Begin(name);
+}
+
+TraceScope::TraceScope(const char *inName, const fs::path &file)
+    : name(inName),
+      active(g_tracer.IsEnabled()) {
+	if (active)
+		g_tracer.Begin(name, file.string());
+}
+
+TraceScope::~TraceScope() {
+	if (active)
+		g_tracer.End(name);
+}
+
+}  // namespace boss
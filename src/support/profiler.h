@@ -0,0 +1,215 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#ifndef SUPPORT_PROFILER_H_
+#define SUPPORT_PROFILER_H_
+
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "common/dll_def.h"
+
+// Times the rest of the enclosing scope as the given phase.
+#define _PROFILE_CONCAT2(a, b) a##b
+#define _PROFILE_CONCAT(a, b) _PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(phase) \
+	boss::ScopedTimer _PROFILE_CONCAT(_profileTimer, __LINE__)(phase)
+
+// Records begin and end trace events around the rest of the enclosing scope.
+#define TRACE_SCOPE(name) \
+	boss::TraceScope _PROFILE_CONCAT(_traceScope, __LINE__)(name)
+#define TRACE_FILE_SCOPE(name, file) \
+	boss::TraceScope _PROFILE_CONCAT(_traceScope, __LINE__)(name, file)
+
+// Adds n to one of the profiler's counters.
+#define PROFILE_COUNT(counter, n) \
+	do { \
+		if (boss::g_profiler.IsEnabled()) \
+			boss::g_profiler.Increment(counter, n); \
+	} while (0)
+
+
+namespace boss {
+
+enum ProfileCounter {
+	PC_FILES_STATED = 0,
+	PC_HEADERS_READ,
+	PC_BYTES_HASHED,
+	PC_CONDITIONS_EVALUATED,
+	PC_REGEXES_COMPILED,
+	PC_RULES_APPLIED,
+	PC_TIMESTAMPS_WRITTEN,
+	PC_MAX
+};
+
+/*
+ * Collects the time spent in each phase of a run and counts of the work done.
+ * Phases are kept in the order they were first entered, and may nest, so
+ * their times can add up to more than the total.
+ * Disabled by default, in which case timers and counters cost a flag check.
+ */
+class BOSS_COMMON Profiler {
+ public:
+	struct Phase {
+		std::string name;
+		std::uint64_t calls;
+		double milliseconds;
+	};
+
+	Profiler();
+
+	void Enable(bool enable);
+	bool IsEnabled() const;
+
+	// Clears all phases and counters, and restarts the total time.
+	void Reset();
+
+	void AddTime(const char *phase, double milliseconds);
+	void Increment(ProfileCounter counter, std::uint64_t n = 1);
+
+	std::uint64_t Counter(ProfileCounter counter) const;
+	std::vector<Phase> Phases() const;
+	double TotalMilliseconds() const;  // Time since the last Reset().
+
+	std::string AsText() const;  // The per-phase breakdown printed to the console.
+	std::string AsJSON() const;
+
+	void SaveJSON(const boost::filesystem::path file) const;
+
+ private:
+	std::atomic<bool> enabled;
+	std::atomic<std::uint64_t> counters[PC_MAX];
+	std::chrono::steady_clock::time_point start;
+	std::vector<Phase> phases;
+	mutable std::mutex mutex;  // Guards phases and start.
+
+	Profiler(const Profiler &);  // Not copyable.
+};
+
+BOSS_COMMON extern Profiler g_profiler;
+
+/*
+ * Records begin/end events in the Chrome trace event format, which can be
+ * loaded into about:tracing or Perfetto. Each thread that records an event
+ * gets its own lane. Disabled by default, in which case recording an event
+ * costs a flag check.
+ */
+class BOSS_COMMON Tracer {
+ public:
+	Tracer();
+
+	void Enable(bool enable);
+	bool IsEnabled() const;
+
+	// Clears all events, and restarts the clock events are timed from.
+	void Reset();
+
+	// name must outlive the tracer, so it should be a string literal.
+	// file is added to the event's arguments if it isn't empty.
+	void Begin(const char *name, const std::string &file = "");
+	void End(const char *name);
+
+	std::string AsJSON() const;
+
+	void SaveJSON(const boost::filesystem::path file) const;
+
+	// Appends the events recorded since the last flush to file and forgets
+	// them, so that a long-running process's events don't pile up. The file
+	// is started afresh by the first flush to it.
+	void FlushJSON(const boost::filesystem::path file);
+
+ private:
+	struct Event {
+		const char *name;
+		char phase;  // 'B' or 'E'.
+		std::uint32_t lane;
+		std::int64_t microseconds;
+		std::string file;
+	};
+
+	void Record(const char *name, char phase, const std::string &file);
+	void AppendEvent(std::string &json, const Event &event,
+	                 std::vector<bool> &lanesNamed) const;
+
+	std::atomic<bool> enabled;
+	std::chrono::steady_clock::time_point start;
+	std::vector<Event> events;
+	std::map<std::thread::id, std::uint32_t> lanes;  // Each recording thread's lane.
+	boost::filesystem::path flushedTo;  // The file FlushJSON last appended to.
+	std::vector<bool> flushedLanesNamed;  // The lanes already named in that file.
+	mutable std::mutex mutex;  // Guards everything else but enabled.
+
+	Tracer(const Tracer &);  // Not copyable.
+};
+
+BOSS_COMMON extern Tracer g_tracer;
+
+// Adds the time between its construction and destruction to a phase, and
+// traces it as an event if tracing is on.
+class BOSS_COMMON ScopedTimer {
+ public:
+	explicit ScopedTimer(const char *phase);
+	~ScopedTimer();
+
+ private:
+	const char *phase;
+	bool active;
+	bool traced;
+	std::chrono::steady_clock::time_point start;
+
+	ScopedTimer(const ScopedTimer &);  // Not copyable.
+};
+
+// Traces the time between its construction and destruction as an event,
+// without adding it to the profiler's phases.
+class BOSS_COMMON TraceScope {
+ public:
+	explicit TraceScope(const char *name);
+	TraceScope(const char *name, const boost::filesystem::path &file);
+	~TraceScope();
+
+ private:
+	const char *name;
+	bool active;
+
+	TraceScope(const TraceScope &);  // Not copyable.
+};
+
+// The name used for a counter in the console and JSON output.
+BOSS_COMMON const char *ProfileCounterName(ProfileCounter counter);
+
+}  // namespace boss
+#endif  // SUPPORT_PROFILER_H_
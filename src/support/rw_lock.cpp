@@ -0,0 +1,103 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#include "support/rw_lock.h"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace boss {
+
+//////////////////////////////
+// RWLock Class Functions
+//////////////////////////////
+
+RWLock::RWLock() : readers(0), waitingWriters(0), writing(false) {}
+
+void RWLock::LockShared() {
+	std::unique_lock<std::mutex> guard(mutex);
+	while (writing || waitingWriters != 0)
+		readersCv.wait(guard);
+	++readers;
+}
+
+void RWLock::UnlockShared() {
+	std::lock_guard<std::mutex> guard(mutex);
+	if (--readers == 0 && waitingWriters != 0)
+		writersCv.notify_one();
+}
+
+void RWLock::Lock() {
+	std::unique_lock<std::mutex> guard(mutex);
+	++waitingWriters;
+	while (writing || readers != 0)
+		writersCv.wait(guard);
+	--waitingWriters;
+	writing = true;
+}
+
+void RWLock::Unlock() {
+	std::lock_guard<std::mutex> guard(mutex);
+	writing = false;
+	if (waitingWriters != 0)
+		writersCv.notify_one();
+	else
+		readersCv.notify_all();
+}
+
+//////////////////////////////
+// RWLockGuard Class Functions
+//////////////////////////////
+
+RWLockGuard::RWLockGuard(RWLock &inLock, const bool inExclusive)
+    : lock(inLock), exclusive(inExclusive) {
+	if (exclusive)
+		lock.Lock();
+	else
+		lock.LockShared();
+}
+
+RWLockGuard::~RWLockGuard() {
+	if (exclusive)
+		lock.Unlock();
+	else
+		lock.UnlockShared();
+}
+
+void RWLockGuard::MakeExclusive() {
+	if (exclusive)
+		return;
+	lock.UnlockShared();
+	lock.Lock();
+	exclusive = true;
+}
+
+bool RWLockGuard::IsExclusive() const {
+	return exclusive;
+}
+
+}  // namespace boss
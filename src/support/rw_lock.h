@@ -0,0 +1,89 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+#ifndef SUPPORT_RW_LOCK_H_
+#define SUPPORT_RW_LOCK_H_
+
+#include <cstddef>
+
+#include <condition_variable>
+#include <mutex>
+
+#include "common/dll_def.h"
+
+namespace boss {
+
+/*
+ * A reader-writer lock: any number of threads can hold it shared, or one thread
+ * can hold it exclusively. Waiting writers block new readers, so a steady stream
+ * of readers can't starve them.
+ */
+class BOSS_COMMON RWLock {
+ public:
+	RWLock();
+
+	void LockShared();
+	void UnlockShared();
+	void Lock();
+	void Unlock();
+
+ private:
+	std::mutex mutex;
+	std::condition_variable readersCv;
+	std::condition_variable writersCv;
+	std::size_t readers;         // Threads holding the lock shared.
+	std::size_t waitingWriters;
+	bool writing;                // True if a thread holds the lock exclusively.
+
+	RWLock(const RWLock &);  // Not copyable.
+	RWLock &operator = (const RWLock &);
+};
+
+/*
+ * Holds an RWLock, shared or exclusively, until it goes out of scope.
+ */
+class BOSS_COMMON RWLockGuard {
+ public:
+	RWLockGuard(RWLock &inLock, const bool inExclusive);
+	~RWLockGuard();
+
+	// Swaps a shared hold for an exclusive one. Other threads may take the lock
+	// in between, so anything checked while it was shared must be checked again.
+	void MakeExclusive();
+
+	bool IsExclusive() const;
+
+ private:
+	RWLock &lock;
+	bool exclusive;
+
+	RWLockGuard(const RWLockGuard &);  // Not copyable.
+	RWLockGuard &operator = (const RWLockGuard &);
+};
+
+}  // namespace boss
+#endif  // SUPPORT_RW_LOCK_H_
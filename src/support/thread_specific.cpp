@@ -0,0 +1,210 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+
+#include "support/thread_specific.h"
+
+#if _WIN32 || _WIN64
+#	ifndef UNICODE
+#		define UNICODE
+#	endif
+#	ifndef _UNICODE
+#		define _UNICODE
+#	endif
+#	include <windows.h>
+#else
+#	include <pthread.h>
+#endif
+
+#include <cstddef>
+
+#include <mutex>
+#include <new>
+#include <set>
+
+namespace boss {
+
+#if _WIN32 || _WIN64
+// Fiber-local storage gives a callback when a thread exits, but XP doesn't have
+// it, so it's looked up at runtime. XP falls back to thread-local storage, in
+// which case values are only deleted when they're replaced or released, or
+// when the key is destroyed.
+typedef VOID (WINAPI *FlsCallbackFunc)(PVOID);
+typedef DWORD (WINAPI *FlsAllocFunc)(FlsCallbackFunc);
+typedef PVOID (WINAPI *FlsGetValueFunc)(DWORD);
+typedef BOOL (WINAPI *FlsSetValueFunc)(DWORD, PVOID);
+typedef BOOL (WINAPI *FlsFreeFunc)(DWORD);
+
+struct FlsFunctions {
+	FlsAllocFunc alloc;
+	FlsGetValueFunc getValue;
+	FlsSetValueFunc setValue;
+	FlsFreeFunc free;
+
+	FlsFunctions() : alloc(NULL), getValue(NULL), setValue(NULL), free(NULL) {
+		HMODULE kernel32 = GetModuleHandleW(L"kernel32.dll");
+		if (kernel32 == NULL)
+			return;
+		alloc = reinterpret_cast<FlsAllocFunc>(GetProcAddress(kernel32, "FlsAlloc"));
+		getValue = reinterpret_cast<FlsGetValueFunc>(GetProcAddress(kernel32, "FlsGetValue"));
+		setValue = reinterpret_cast<FlsSetValueFunc>(GetProcAddress(kernel32, "FlsSetValue"));
+		free = reinterpret_cast<FlsFreeFunc>(GetProcAddress(kernel32, "FlsFree"));
+		if (alloc == NULL || getValue == NULL || setValue == NULL || free == NULL)
+			alloc = NULL;
+	}
+
+	bool IsAvailable() const {
+		return alloc != NULL;
+	}
+};
+#endif
+
+struct ThreadKey::Impl {
+#if _WIN32 || _WIN64
+	FlsFunctions fls;
+	DWORD index;  // TLS_OUT_OF_INDEXES if allocation failed.
+#else
+	pthread_key_t index;
+	bool allocated;
+#endif
+	std::mutex mutex;
+	std::set<ThreadValue *> values;  // Every thread's, so that the key can delete them.
+
+	// Called for a value when its thread exits.
+	static void Destroy(void *value) {
+		ThreadValue *threadValue = static_cast<ThreadValue *>(value);
+		threadValue->key->Forget(threadValue);
+		delete threadValue;
+	}
+
+#if _WIN32 || _WIN64
+	static VOID WINAPI FlsDestroy(PVOID value) {
+		if (value != NULL)
+			Destroy(value);
+	}
+#endif
+};
+
+//////////////////////////////
+// ThreadValue Class Functions
+//////////////////////////////
+
+ThreadValue::ThreadValue() : key(NULL) {}
+
+ThreadValue::~ThreadValue() {}
+
+//////////////////////////////
+// ThreadKey Class Functions
+//////////////////////////////
+
+ThreadKey::ThreadKey() : impl(new Impl) {
+#if _WIN32 || _WIN64
+	if (impl->fls.IsAvailable())
+		impl->index = impl->fls.alloc(&Impl::FlsDestroy);
+	else
+		impl->index = TlsAlloc();
+#else
+	impl->allocated = pthread_key_create(&impl->index, &Impl::Destroy) == 0;
+#endif
+}
+
+ThreadKey::~ThreadKey() {
+	// Free the slot first, so that no thread exits into a value being deleted
+	// here. FlsFree calls the exit callback for any values that are still set.
+#if _WIN32 || _WIN64
+	if (impl->index != TLS_OUT_OF_INDEXES) {
+		if (impl->fls.IsAvailable())
+			impl->fls.free(impl->index);
+		else
+			TlsFree(impl->index);
+	}
+#else
+	if (impl->allocated)
+		pthread_key_delete(impl->index);
+#endif
+	for (std::set<ThreadValue *>::iterator it = impl->values.begin(); it != impl->values.end(); ++it)
+		delete *it;
+	delete impl;
+}
+
+ThreadValue *ThreadKey::Get() const {
+#if _WIN32 || _WIN64
+	if (impl->index == TLS_OUT_OF_INDEXES)
+		return NULL;
+	if (impl->fls.IsAvailable())
+		return static_cast<ThreadValue *>(impl->fls.getValue(impl->index));
+	return static_cast<ThreadValue *>(TlsGetValue(impl->index));
+#else
+	if (!impl->allocated)
+		return NULL;
+	return static_cast<ThreadValue *>(pthread_getspecific(impl->index));
+#endif
+}
+
+void ThreadKey::Set(ThreadValue *value) {
+	ThreadValue *previous = Get();
+	if (value == previous)
+		return;
+	if (value != NULL) {
+		value->key = this;
+		std::lock_guard<std::mutex> guard(impl->mutex);
+		impl->values.insert(value);
+	}
+
+	bool set;
+#if _WIN32 || _WIN64
+	if (impl->index == TLS_OUT_OF_INDEXES)
+		set = false;
+	else if (impl->fls.IsAvailable())
+		set = impl->fls.setValue(impl->index, value) != 0;
+	else
+		set = TlsSetValue(impl->index, value) != 0;
+#else
+	set = impl->allocated && pthread_setspecific(impl->index, value) == 0;
+#endif
+	if (!set) {
+		if (value != NULL)
+			Forget(value);
+		throw std::bad_alloc();
+	}
+
+	if (previous != NULL) {
+		Forget(previous);
+		delete previous;
+	}
+}
+
+void ThreadKey::Release() {
+	Set(NULL);
+}
+
+void ThreadKey::Forget(ThreadValue *value) {
+	std::lock_guard<std::mutex> guard(impl->mutex);
+	impl->values.erase(value);
+}
+
+}  // namespace boss
@@ -0,0 +1,128 @@
+/*	BOSS
+
+	A "one-click" program for users that quickly optimises and avoids
+	detrimental conflicts in their TES IV: Oblivion, Nehrim - At Fate's Edge,
+	TES V: Skyrim, Fallout 3 and Fallout: New Vegas mod load orders.
+
+	Copyright (C) 2009-2012    BOSS Development Team.
+
+	This file is part of BOSS.
+
+	BOSS is free software: you can redistribute
+	it and/or modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3 of
+	the License, or (at your option) any later version.
+
+	BOSS is distributed in the hope that it will
+	be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with BOSS.  If not, see
+	<http://www.gnu.org/licenses/>.
+
+	$Revision: 1783 $, $Date: 2010-10-31 23:05:28 +0000 (Sun, 31 Oct 2010) $
+*/
+
+
+#ifndef SUPPORT_THREAD_SPECIFIC_H_
+#define SUPPORT_THREAD_SPECIFIC_H_
+
+#include <cstddef>
+
+#include "common/dll_def.h"
+
+namespace boss {
+
+class ThreadKey;
+
+/*
+ * A value stored under a ThreadKey. Deleted when its thread exits, when it is
+ * replaced, or when the key is destroyed.
+ */
+class BOSS_COMMON ThreadValue {
+ public:
+	ThreadValue();
+	virtual ~ThreadValue();
+
+ private:
+	friend class ThreadKey;
+	ThreadKey *key;
+
+	ThreadValue(const ThreadValue &);  // Not copyable.
+	ThreadValue &operator = (const ThreadValue &);
+};
+
+/*
+ * An explicitly allocated thread-local storage slot. This is used instead of
+ * thread_local, which the Windows toolset doesn't support, and whose implicit
+ * TLS doesn't work on XP in a DLL loaded with LoadLibrary.
+ */
+class BOSS_COMMON ThreadKey {
+ public:
+	ThreadKey();
+	~ThreadKey();
+
+	// Gets the calling thread's value, or NULL if it has none.
+	ThreadValue *Get() const;
+	// Sets the calling thread's value, taking ownership of it and deleting the
+	// previous one. Throws std::bad_alloc if it can't be stored, in which case
+	// the caller keeps ownership.
+	void Set(ThreadValue *value);
+	// Deletes the calling thread's value.
+	void Release();
+
+ private:
+	struct Impl;
+	Impl *impl;
+
+	// Stops tracking a value that's being deleted by its thread's exit.
+	void Forget(ThreadValue *value);
+
+	ThreadKey(const ThreadKey &);  // Not copyable.
+	ThreadKey &operator = (const ThreadKey &);
+};
+
+/*
+ * A T for each thread, default-constructed on first use.
+ */
+template <typename T>
+class ThreadSpecific {
+ public:
+	// Gets the calling thread's T. Can throw std::bad_alloc.
+	T &Get() {
+		Holder *holder = static_cast<Holder *>(key.Get());
+		if (holder == NULL) {
+			holder = new Holder;
+			try {
+				key.Set(holder);
+			} catch (...) {
+				delete holder;
+				throw;
+			}
+		}
+		return holder->value;
+	}
+
+	// Gets the calling thread's T, or NULL if it hasn't got one.
+	T *Find() {
+		Holder *holder = static_cast<Holder *>(key.Get());
+		return holder == NULL ? NULL : &holder->value;
+	}
+
+	// Deletes the calling thread's T, if it has one.
+	void Release() {
+		key.Release();
+	}
+
+ private:
+	struct Holder : public ThreadValue {
+		T value;
+	};
+
+	ThreadKey key;
+};
+
+}  // namespace boss
+#endif  // SUPPORT_THREAD_SPECIFIC_H_
@@ -30,7 +30,13 @@
 #include <cstddef>
 
 #include <fstream>
+#include <mutex>
+#include <new>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 
@@ -42,6 +48,7 @@
 #include "common/globals.h"
 #include "support/helpers.h"
 #include "support/logger.h"
+#include "support/profiler.h"
 
 namespace boss {
 
@@ -86,6 +93,13 @@ void handle_error(int error_code, pointers_struct &pointers) {
 	throw boss_error(error_message, BOSS_ERROR_GIT_ERROR);
 }
 
+TempFolder::~TempFolder() {
+	if (path.empty())
+		return;
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(path, ec);  // Not worth failing over: it's cleared before it's next used.
+}
+
 std::string RepoURL(const Game &game) {
 	// TODO(MCP): Look at converting this to a switch-statement
 	// MCP Note: The last else-statement should be an else-if with a default of invalid or similar
@@ -101,67 +115,76 @@ std::string RepoURL(const Game &game) {
 		return gl_falloutnv_repo_url;
 }
 
-bool are_files_equal(const void *buf1, std::size_t buf1_size,
-                            const void *buf2, std::size_t buf2_size) {
-	if (buf1_size != buf2_size)
-		return false;
-
-	std::size_t pos = 0;
-	while (pos < buf1_size) {
-		if (*((char*)buf1 + pos) != *((char*)buf2 + pos))
-			return false;
-		++pos;
-	}
-	return true;
-}
-
 // Gets the revision SHA (first 9 characters) for the currently checked-out masterlist, or "unknown".
 std::string GetMasterlistVersion(Game &game) {
-	if (!boost::filesystem::exists(game.Masterlist().parent_path() / ".git" / "HEAD")) {
+	PROFILE_SCOPE("GetMasterlistVersion");
+	boost::filesystem::path gitFolder = game.Masterlist().parent_path() / ".git";
+	if (!boost::filesystem::exists(gitFolder / "HEAD")) {
 		return "Unknown: Git repository missing";
 	}
-	std::string rev;
-	// Naive check, ignoring working directory changes.
+
+	// UpdateMasterlist() leaves HEAD as a direct reference to the checked-out revision.
+	// For some reason trying to get the revision of HEAD:masterlist.txt using libgit2 gives me 18efbc9d8 instead.
+	std::string head;
+	boss_fstream::ifstream headFile(gitFolder / "HEAD");
+	headFile >> head;
+	headFile.close();
 
 	/*
-	 * Better check, which compares HEAD to the working dir.
-	 *
-	 * 1. Get an object for the masterlist in HEAD.
-	 * 2. Get the blob for that object.
-	 * 3. Open the masterlist file in the working dir in a file buffer.
-	 * 4. Compare the file and blob buffers.
+	 * Check that the working masterlist hasn't been edited, by comparing its Git
+	 * blob ID with that of the masterlist in HEAD. The outcome is cached with
+	 * HEAD and the file's size and modification time, so that the file is only
+	 * hashed again once one of those changes.
 	 */
-	pointers_struct ptrs;
-	LOG_INFO("Existing repository found, attempting to open it.");
-	handle_error(git_repository_open(&ptrs.repo, game.Masterlist().parent_path().string().c_str()), ptrs);
+	std::string key;
+	try {
+		key = head + ' ' + std::to_string(boost::filesystem::file_size(game.Masterlist()))
+		      + ' ' + std::to_string(boost::filesystem::last_write_time(game.Masterlist()));
+	} catch (boost::filesystem::filesystem_error &e) {
+		LOG_WARN("Could not read the masterlist's size or modification time. Details: %s", e.what());
+		return "Unknown: Masterlist edited";
+	}
+	std::string cachedKey, cachedOutcome;
+	boss_fstream::ifstream cacheIn(gitFolder / MASTERLIST_CHECK_FILE);
+	if (!cacheIn.fail()) {
+		std::getline(cacheIn, cachedKey);
+		std::getline(cacheIn, cachedOutcome);
+		cacheIn.close();
+	}
 
-	LOG_INFO("Getting HEAD masterlist object.");
-	handle_error(git_revparse_single(&ptrs.obj, ptrs.repo, "HEAD:masterlist.txt"), ptrs);
+	bool unedited;
+	if (cachedKey == key && !cachedOutcome.empty()) {
+		LOG_INFO("Masterlist unchanged since it was last checked.");
+		unedited = cachedOutcome == "unedited";
+	} else {
+		pointers_struct ptrs;
+		LOG_INFO("Existing repository found, attempting to open it.");
+		handle_error(git_repository_open(&ptrs.repo, game.Masterlist().parent_path().string().c_str()), ptrs);
 
-	LOG_INFO("Getting blob for masterlist object.");
-	handle_error(git_blob_lookup(&ptrs.blob, ptrs.repo, git_object_id(ptrs.obj)), ptrs);
+		LOG_INFO("Getting HEAD masterlist object.");
+		handle_error(git_revparse_single(&ptrs.obj, ptrs.repo, "HEAD:masterlist.txt"), ptrs);
 
-	LOG_INFO("Opening masterlist in working directory.");
-	std::string mlist;
-	fileToBuffer(game.Masterlist(), mlist);
+		LOG_INFO("Hashing masterlist in working directory.");
+		git_oid workingId;
+		handle_error(git_odb_hashfile(&workingId, game.Masterlist().string().c_str(), GIT_OBJ_BLOB), ptrs);
 
-	LOG_INFO("Comparing files.");
-	if (are_files_equal(git_blob_rawcontent(ptrs.blob),
-	                    git_blob_rawsize(ptrs.blob),
-	                    mlist.data(),
-	                    mlist.length())) {
+		unedited = git_oid_equal(&workingId, git_object_id(ptrs.obj)) != 0;
 		ptrs.free();
-		// For some reason trying to get the revision of HEAD:masterlist.txt using libgit2 gives me 18efbc9d8 instead.
-		std::string revision;
-		//std::ifstream head((game.Masterlist().parent_path() / ".git" / "HEAD").string());
-		boss_fstream::ifstream head((game.Masterlist().parent_path() / ".git" / "HEAD"));
-		head >> revision;
-		head.close();
-		revision.resize(9);
-		return revision;
+
+		boss_fstream::ofstream cacheOut(gitFolder / MASTERLIST_CHECK_FILE);
+		if (cacheOut.fail()) {
+			LOG_WARN("Could not save the masterlist check to \"%s\".",
+			         (gitFolder / MASTERLIST_CHECK_FILE).string().c_str());
+		} else {
+			cacheOut << key << '\n' << (unedited ? "unedited" : "edited") << '\n';
+			cacheOut.close();
+		}
 	}
-	ptrs.free();
-	return "Unknown: Masterlist edited";
+
+	if (!unedited)
+		return "Unknown: Masterlist edited";
+	head.resize(9);
+	return head;
 }
 
 int ValidateCertificate(git_cert *certificate, int is_valid, const char *host_name, void *payload_data) {
@@ -170,4 +193,189 @@ int ValidateCertificate(git_cert *certificate, int is_valid, const char *host_na
 	return -1;
 }
 
+//////////////////////////////////////////
+// MasterlistPrecompiler Class Functions
+//////////////////////////////////////////
+
+MasterlistPrecompiler::MasterlistPrecompiler() : started(false) {}
+
+MasterlistPrecompiler::~MasterlistPrecompiler() {
+	Wait();
+}
+
+void MasterlistPrecompiler::Start(const Game &game,
+                                  const std::string &inRevision) {
+	Wait();
+	path = game.Masterlist();
+	revision = inRevision;
+	parsed.Clear();
+	error.reset();
+	started = true;
+
+	LOG_INFO("Parsing the masterlist at revision %s in the background.",
+	         revision.c_str());
+	const Game *parentGame = &game;
+	try {
+		worker = std::thread([this, parentGame]() {
+			PROFILE_SCOPE("MasterlistPrecompiler");
+			try {
+				parsed.Load(*parentGame, path);
+			} catch (boss_error &e) {
+				LOG_ERROR("The masterlist at revision %s failed to parse. Details: %s",
+				          revision.c_str(), e.getString().c_str());
+				error.reset(new boss_error(e));
+			} catch (std::bad_alloc /*&e*/) {
+				error.reset(new boss_error(BOSS_ERROR_NO_MEM));
+			}
+		});
+	} catch (std::system_error &e) {
+		// The sort will just parse the masterlist itself.
+		LOG_WARN("Could not start parsing the masterlist in the background. Details: %s", e.what());
+		started = false;
+	}
+}
+
+bool MasterlistPrecompiler::Take(Game &game, ItemList &masterlist) {
+	if (!started || path != game.Masterlist())
+		return false;
+	Wait();
+	started = false;
+
+	// The parse is only of use if the masterlist hasn't changed since it was checked out.
+	if (GetMasterlistVersion(game) != revision) {
+		LOG_INFO("Masterlist changed since it was parsed in the background, discarding the parse.");
+		parsed.Clear();
+		error.reset();
+		return false;
+	}
+
+	LOG_INFO("Using the masterlist parsed in the background.");
+	masterlist = std::move(parsed);
+	parsed.Clear();
+	if (error) {
+		boss_error e = *error;
+		error.reset();
+		throw e;
+	}
+	return true;
+}
+
+void MasterlistPrecompiler::Wait() {
+	if (worker.joinable())
+		worker.join();
+}
+
+//////////////////////////////////////////
+// UpdateMasterlists Functions
+//////////////////////////////////////////
+
+MasterlistProgress::MasterlistProgress()
+    : game(AUTODETECT),
+      receivedObjects(0),
+      totalObjects(0),
+      receivedBytes(0),
+      finished(false) {}
+
+MasterlistUpdate::MasterlistUpdate()
+    : game(AUTODETECT),
+      errorCode(BOSS_OK) {}
+
+namespace {
+
+// Shared by the threads of an UpdateMasterlists call.
+struct MultiUpdateState {
+	std::mutex mutex;  // Guards progress and serialises calls to prog.
+	std::vector<MasterlistProgress> progress;
+	MultiUpdateProgress prog;
+	void *data;
+};
+
+// The payload of a game's transfer progress callbacks.
+struct GameTransfer {
+	MultiUpdateState *state;
+	std::size_t index;
+};
+
+// Records a game's progress, then passes everyone's on.
+void ReportGameProgress(GameTransfer &transfer, const git_transfer_progress *stats) {
+	MultiUpdateState &state = *transfer.state;
+	std::lock_guard<std::mutex> guard(state.mutex);
+	MasterlistProgress &progress = state.progress[transfer.index];
+	if (stats == NULL) {
+		progress.finished = true;
+	} else {
+		progress.receivedObjects = stats->received_objects;
+		progress.totalObjects = stats->total_objects;
+		progress.receivedBytes = stats->received_bytes;
+	}
+	if (state.prog != NULL)
+		state.prog(state.progress, state.data);
+}
+
+int TransferProgress(const git_transfer_progress *stats, void *payload) {
+	ReportGameProgress(*static_cast<GameTransfer *>(payload), stats);
+	return 0;
+}
+
+}  // namespace
+
+std::vector<MasterlistUpdate> UpdateMasterlists(const std::vector<Game *> &games,
+                                                MultiUpdateProgress prog,
+                                                void *data) {
+	PROFILE_SCOPE("UpdateMasterlists");
+	MultiUpdateState state;
+	state.progress.resize(games.size());
+	state.prog = prog;
+	state.data = data;
+	std::vector<GameTransfer> transfers(games.size());
+	std::vector<MasterlistUpdate> results(games.size());
+	for (std::size_t i = 0, max = games.size(); i < max; i++) {
+		state.progress[i].game = games[i]->Id();
+		results[i].game = games[i]->Id();
+		transfers[i].state = &state;
+		transfers[i].index = i;
+	}
+
+	LOG_INFO("Updating %" PRIuS " masterlists at once.", games.size());
+	std::vector<std::thread> threads;
+	threads.reserve(games.size());
+	for (std::size_t i = 0, max = games.size(); i < max; i++) {
+		MasterlistUpdate &result = results[i];
+		Game &game = *games[i];
+		GameTransfer &transfer = transfers[i];
+		auto update = [&result, &game, &transfer]() {
+			try {
+				result.revision = UpdateMasterlist(game, TransferProgress, &transfer);
+			} catch (boss_error &e) {
+				result.errorCode = e.getCode();
+				result.errorString = e.getString();
+			} catch (std::bad_alloc /*&e*/) {
+				result.errorCode = BOSS_ERROR_NO_MEM;
+				result.errorString = boss_error(BOSS_ERROR_NO_MEM).getString();
+			}
+			ReportGameProgress(transfer, NULL);
+		};
+		try {
+			threads.push_back(std::thread(update));
+		} catch (std::system_error &e) {
+			// Couldn't start another thread, so update this game on this one.
+			LOG_WARN("Could not start an updating thread, updating %s on the calling thread. Details: %s",
+			         game.Name().c_str(), e.what());
+			update();
+		}
+	}
+	for (std::size_t i = 0, max = threads.size(); i < max; i++)
+		threads[i].join();
+
+	for (std::size_t i = 0, max = results.size(); i < max; i++) {
+		if (results[i].errorCode == BOSS_OK)
+			LOG_INFO("%s masterlist updated to revision %s.",
+			         games[i]->Name().c_str(), results[i].revision.c_str());
+		else
+			LOG_ERROR("%s masterlist update failed. Details: %s",
+			          games[i]->Name().c_str(), results[i].errorString.c_str());
+	}
+	return results;
+}
+
 }  // namespace boss
@@ -29,9 +29,14 @@
 #define UPDATING_UPDATER_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 
 #include <fstream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 
@@ -41,11 +46,27 @@
 #include "common/error.h"
 #include "common/game.h"
 #include "common/globals.h"
+#include "common/item_list.h"
 #include "support/helpers.h"
 #include "support/logger.h"
+#include "support/profiler.h"
+
+// libgit2 can only fetch a limited history depth from v1.7.
+#if LIBGIT2_VER_MAJOR > 1 || (LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR >= 7)
+#	define BOSS_GIT_SHALLOW_FETCH 1
+#endif
 
 namespace boss {
 
+// The only remote branch that BOSS needs: the masterlist is checked out from its tip.
+const char MASTERLIST_REFSPEC[] = "+refs/heads/master:refs/remotes/origin/master";
+
+// Where GetMasterlistVersion caches its check of the working masterlist, in the repository's .git folder.
+const char MASTERLIST_CHECK_FILE[] = "BOSSMasterlistCheck";
+
+// Where a repository that replaces the existing one is fetched into, in the masterlist's folder.
+const char MASTERLIST_NEW_REPO_FOLDER[] = "BOSSMasterlistUpdate";
+
 struct pointers_struct {
 	pointers_struct();
 
@@ -63,12 +84,17 @@ struct pointers_struct {
 
 void handle_error(int error_code, pointers_struct &pointers);
 
-std::string RepoURL(const Game &game);
+// Deletes a folder, if one is given, when it goes out of scope.
+struct TempFolder {
+	~TempFolder();
+
+	boost::filesystem::path path;
+};
 
-bool are_files_equal(const void *buf1, std::size_t buf1_size,
-                     const void *buf2, std::size_t buf2_size);
+std::string RepoURL(const Game &game);
 
-// Gets the revision SHA (first 9 characters) for the currently checked-out masterlist, or "unknown".
+// Gets the revision SHA (first 9 characters) for the currently checked-out masterlist, or "unknown" if it has been edited.
+// Only hashes the masterlist if it or HEAD has changed since the last call.
 std::string GetMasterlistVersion(Game &game);
 
 int ValidateCertificate(git_cert *certificate, int is_valid, const char *host_name, void *payload_data);
@@ -76,16 +102,39 @@ int ValidateCertificate(git_cert *certificate, int is_valid, const char *host_na
 // Progress has form prog(const char *str, int len, void *data)
 template<class Progress>
 std::string UpdateMasterlist(Game &game, Progress prog, void *out) {
+	PROFILE_SCOPE("UpdateMasterlist");
 	pointers_struct ptrs;
 	const git_transfer_progress *stats = NULL;
+	const boost::filesystem::path repoPath = game.Masterlist().parent_path();
+	boost::filesystem::path workPath = repoPath;  // Where the repository being updated is.
+	TempFolder newRepo;  // Deleted on failure, so that the existing repository is left as it was.
 
 	LOG_INFO("Checking for a Git repository.");
 
 	// Checking for a ".git" folder.
-	if (boost::filesystem::exists(game.Masterlist().parent_path() / ".git")) {
+	bool repoExists = boost::filesystem::exists(repoPath / ".git");
+	if (repoExists) {
 		// Repository exists. Open it.
 		LOG_INFO("Existing repository found, attempting to open it.");
-		handle_error(git_repository_open(&ptrs.repo, game.Masterlist().parent_path().string().c_str()), ptrs);
+		handle_error(git_repository_open(&ptrs.repo, repoPath.string().c_str()), ptrs);
+#ifdef BOSS_GIT_SHALLOW_FETCH
+		// Only the tip of master is needed, so a repository holding the full history is replaced by a shallow one, rather than kept growing.
+		// The shallow repository is fetched and checked out beside it, and only replaces it once that has succeeded.
+		if (!git_repository_is_shallow(ptrs.repo)) {
+			LOG_INFO("Existing repository has the full history, replacing it with a shallow repository.");
+			ptrs.free();
+			workPath = repoPath / MASTERLIST_NEW_REPO_FOLDER;
+			try {
+				boost::filesystem::remove_all(workPath);  // Left over from an update that was interrupted.
+			} catch (boost::filesystem::filesystem_error &e) {
+				throw boss_error(BOSS_ERROR_FS_FILE_DELETE_FAIL, workPath.string(), e.what());
+			}
+			newRepo.path = workPath;
+			repoExists = false;
+		}
+#endif
+	}
+	if (repoExists) {
 
 		LOG_INFO("Attempting to get info on the repository remote.");
 
@@ -115,12 +164,12 @@ std::string UpdateMasterlist(Game &game, Progress prog, void *out) {
 	} else {
 		LOG_INFO("Repository doesn't exist, initialising a new repository.");
 		// Repository doesn't exist. Set up a repository.
-		handle_error(git_repository_init(&ptrs.repo, game.Masterlist().parent_path().string().c_str(), false), ptrs);
+		handle_error(git_repository_init(&ptrs.repo, workPath.string().c_str(), false), ptrs);
 
 		LOG_INFO("Setting the new repository's remote to: %s", RepoURL(game).c_str());
 
-		// Now set the repository's remote.
-		handle_error(git_remote_create(&ptrs.remote, ptrs.repo, "origin", RepoURL(game).c_str()), ptrs);
+		// Now set the repository's remote, tracking only the master branch.
+		handle_error(git_remote_create_with_fetchspec(&ptrs.remote, ptrs.repo, "origin", RepoURL(game).c_str(), MASTERLIST_REFSPEC), ptrs);
 	}
 
 	// WARNING: This is generally a very bad idea, since it makes HTTPS a little bit pointless, but in this case because we're only reading data and not really concerned about its integrity, it's acceptable. A better solution would be to figure out why GitHub's certificate appears to be invalid to OpenSSL.
@@ -138,6 +187,16 @@ std::string UpdateMasterlist(Game &game, Progress prog, void *out) {
 	fetch_options.callbacks = GIT_REMOTE_CALLBACKS_INIT;
 	fetch_options.callbacks.transfer_progress = prog;
 	fetch_options.callbacks.payload = out;
+	// Fetch master alone and without tags, so that returning users don't negotiate refs BOSS never uses, and prune stale remote-tracking refs.
+	fetch_options.download_tags = GIT_REMOTE_DOWNLOAD_TAGS_NONE;
+	fetch_options.prune = GIT_FETCH_PRUNE;
+#ifdef BOSS_GIT_SHALLOW_FETCH
+	fetch_options.depth = 1;
+#endif
+	char refspec[sizeof(MASTERLIST_REFSPEC)];
+	std::memcpy(refspec, MASTERLIST_REFSPEC, sizeof(MASTERLIST_REFSPEC));
+	char *refspecStrings[] = {refspec};
+	git_strarray refspecs = {refspecStrings, 1};
 
 //#ifndef _MSC_VER
 	//int (*validate_cert)(git_cert *, int, const char *, void *) = ValidateCert;
@@ -151,7 +210,7 @@ std::string UpdateMasterlist(Game &game, Progress prog, void *out) {
 
 	// Fetch from remote.
 	LOG_INFO("Fetching from remote.");
-	handle_error(git_remote_fetch(ptrs.remote, nullptr, &fetch_options, nullptr), ptrs);
+	handle_error(git_remote_fetch(ptrs.remote, &refspecs, &fetch_options, nullptr), ptrs);
 	//handle_error(git_remote_fetch(ptrs.remote), ptrs);
 
 	/*
@@ -215,8 +274,97 @@ std::string UpdateMasterlist(Game &game, Progress prog, void *out) {
 	LOG_INFO("Freeing pointers.");
 	ptrs.free();
 
+	if (workPath != repoPath) {
+		LOG_INFO("Replacing the existing repository with the shallow repository.");
+		// The existing repository is moved aside rather than deleted, so that it can be put back, and is deleted along with workPath.
+		const boost::filesystem::path oldRepoPath = workPath / "old.git";
+		try {
+			boost::filesystem::rename(repoPath / ".git", oldRepoPath);
+		} catch (boost::filesystem::filesystem_error &e) {
+			throw boss_error(BOSS_ERROR_FS_FILE_RENAME_FAIL, (repoPath / ".git").string(), e.what());
+		}
+		try {
+			boost::filesystem::rename(workPath / ".git", repoPath / ".git");
+		} catch (boost::filesystem::filesystem_error &e) {
+			boost::system::error_code ec;
+			boost::filesystem::rename(oldRepoPath, repoPath / ".git", ec);
+			throw boss_error(BOSS_ERROR_FS_FILE_RENAME_FAIL, (workPath / ".git").string(), e.what());
+		}
+		try {
+			boost::filesystem::rename(workPath / game.Masterlist().filename(), game.Masterlist());
+		} catch (boost::filesystem::filesystem_error &e) {
+			throw boss_error(BOSS_ERROR_FS_FILE_RENAME_FAIL, (workPath / game.Masterlist().filename()).string(), e.what());
+		}
+	}
+
 	return std::string(revision);
 }
 
+// One game's progress in UpdateMasterlists.
+struct MasterlistProgress {
+	MasterlistProgress();
+
+	std::uint32_t game;
+	std::size_t receivedObjects;
+	std::size_t totalObjects;
+	std::size_t receivedBytes;
+	bool finished;
+};
+
+// One game's outcome in UpdateMasterlists.
+struct MasterlistUpdate {
+	MasterlistUpdate();
+
+	std::uint32_t game;
+	std::string revision;      // The revision updated to, if the update succeeded.
+	std::uint32_t errorCode;   // BOSS_OK if the update succeeded.
+	std::string errorString;   // Details of the error, if it didn't.
+};
+
+// Called by UpdateMasterlists whenever a game's progress changes, with every game's progress in the order the games were given.
+// Calls are never concurrent, but they come from the updating threads.
+typedef void (*MultiUpdateProgress)(const std::vector<MasterlistProgress> &games, void *data);
+
+/*
+ * Parses a freshly updated masterlist in the background, so that the sort that
+ * follows the update doesn't have to wait for it to be parsed, and so that a
+ * corrupt update is found before anything is sorted. The parsed masterlist is
+ * kept with the masterlist's path and the revision the updater returned, and
+ * is only handed over while that revision is still the one checked out.
+ */
+class BOSS_COMMON MasterlistPrecompiler {
+ public:
+	MasterlistPrecompiler();
+	~MasterlistPrecompiler();  // Waits for any parse in progress.
+
+	// Starts parsing the given game's masterlist, as checked out at revision, on another thread. Discards any previous result.
+	// The game must outlive the parse.
+	void Start(const Game &game, const std::string &revision);
+
+	// Waits for the parse started for the given game's masterlist, if any, and moves the parsed masterlist into masterlist.
+	// Returns false if there's none, or if the masterlist has since been edited or updated again, in which case masterlist is untouched.
+	// If the parse failed, its error is thrown once the failed parse, with its error buffer, has been moved into masterlist.
+	bool Take(Game &game, ItemList &masterlist);
+
+ private:
+	void Wait();
+
+	std::thread worker;
+	boost::filesystem::path path;
+	std::string revision;
+	ItemList parsed;
+	std::unique_ptr<boss_error> error;  // Set if the parse failed.
+	bool started;
+
+	MasterlistPrecompiler(const MasterlistPrecompiler &);  // Not copyable.
+	MasterlistPrecompiler &operator = (const MasterlistPrecompiler &);
+};
+
+// Updates the masterlists of the given games at once, each on its own thread, and returns the outcome for each game in the order they were given.
+// The games must have different masterlist folders, and must not be used elsewhere until this returns. prog can be NULL.
+std::vector<MasterlistUpdate> UpdateMasterlists(const std::vector<Game *> &games,
+                                                MultiUpdateProgress prog,
+                                                void *data);
+
 }  // namespace boss
 #endif  // UPDATING_UPDATER_H_